@@ -0,0 +1,47 @@
+/*
+	FILE HEADER ALLOCATOREALLINEATO.H
+
+	Allocatore minimale per std::vector che restituisce memoria allineata a ALLINEAMENTO byte
+	(di default una cache line). Viene usato per i buffer delle scansioni, così ogni buffer parte
+	sempre all'inizio di una cache line e i cicli vettorizzati non partono da indirizzi disallineati.
+
+	Esempio:
+	- std::vector<double, AllocatoreAllineato<double>> v(1801); -> v.data() è multiplo di 64
+*/
+
+#ifndef ALLOCATOREALLINEATO_H
+#define ALLOCATOREALLINEATO_H
+
+#include <cstddef>
+#include <new>
+
+namespace lidar_driver {
+	template <typename T, std::size_t ALLINEAMENTO = 64>
+	class AllocatoreAllineato {
+		public:
+			using value_type = T;
+
+			// serve a std::vector per ottenere l'allocatore di un altro tipo
+			template <typename U>
+			struct rebind { using other = AllocatoreAllineato<U, ALLINEAMENTO>; };
+
+			AllocatoreAllineato() = default;
+			template <typename U>
+			AllocatoreAllineato(const AllocatoreAllineato<U, ALLINEAMENTO> &) {}
+
+			T *allocate(std::size_t n) {
+				return static_cast<T *>(::operator new(n * sizeof(T), std::align_val_t(ALLINEAMENTO)));
+			}
+			void deallocate(T *p, std::size_t) {
+				::operator delete(p, std::align_val_t(ALLINEAMENTO));
+			}
+
+			// tutti gli allocatori sono intercambiabili (non hanno stato)
+			template <typename U>
+			bool operator==(const AllocatoreAllineato<U, ALLINEAMENTO> &) const { return true; }
+			template <typename U>
+			bool operator!=(const AllocatoreAllineato<U, ALLINEAMENTO> &) const { return false; }
+	};
+}
+
+#endif // ALLOCATOREALLINEATO_H
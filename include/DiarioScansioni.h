@@ -0,0 +1,143 @@
+/*
+	FILE HEADER DIARIOSCANSIONI.H
+
+	Diario su disco delle scansioni: un file mappato in memoria (mmap) con un numero fisso di record
+	di dimensione fissa, scritti uno dopo l'altro e, arrivati in fondo, di nuovo dal primo (come il
+	buffer di LidarDriver, ma con minuti di storia invece di poche scansioni).
+
+	Di solito non si usa direttamente per scrivere: LidarDriver::apri_diario crea (o riapre) il diario
+	e da quel momento ogni new_scan scrive anche un record. Per rileggere la storia, anche mentre il
+	driver sta ancora scrivendo o dopo un crash, si apre il file con il costruttore di sola lettura;
+	mentre il driver scrive, però, le misure vanno lette con leggi, che si accorge se il record è
+	stato riscritto durante la copia (get_view, misure e intestazione non possono saperlo).
+
+	Struttura del file (vedi FormatoBinario.h):
+	 - IntestazioneDiario nei primi 64 byte, con i parametri del driver e la dimensione dei record
+	 - numeroRecord record, ognuno con una IntestazioneRecord (il progressivo del diario) e una
+	   IntestazioneScansione (con numero di sequenza e timestamp della scansione nel driver, come in
+	   write_scan) seguite dalle misure nel formato del driver; la dimensione dei record è arrotondata
+	   a 64 byte così ogni record inizia su una cache line, e le misure subito dopo
+
+	Note sulla implementazione:
+	 - elPiNovo/elPiVecio/dimension non sono salvati nel file: ogni record ha il suo progressivo
+	   (crescente, da 1) e aggiorna() li ricostruisce leggendo solo le intestazioni dei record (il più
+	   nuovo ha il progressivo più grande, il più vecchio il più piccolo)
+	 - il progressivo è del diario e non della scansione: sequenza e timestamp vengono dal driver (anche
+	   quelli passati a new_scan dal chiamante) e così vengono ricaricati da apri_diario, ma non è detto
+	   che siano consecutivi o che partano da 1
+	 - un record viene scritto in tre passi: il progressivo viene messo a 0 (record non valido), vengono
+	   copiate le misure e l'intestazione della scansione e solo alla fine viene scritto il nuovo
+	   progressivo (con un rilascio atomico); se il processo si interrompe a metà, il record ha
+	   progressivo 0 e viene ignorato
+	 - le pagine del file mappato appartengono al kernel, per cui i record completati sopravvivono al
+	   crash del processo; per sopravvivere anche a uno spegnimento bisogna chiamare sincronizza()
+	 - get_view e misure danno accesso diretto ai record nella mappatura, senza copiare i dati e senza
+	   leggere tutto il file (il kernel carica solo le pagine effettivamente lette)
+	 - le generazioni dei record (per valida() delle viste) non sono nel file ma in ogni oggetto, per
+	   cui un lettore non vede le sovrascritture fatte dal driver; leggi invece rilegge il progressivo
+	   del record dopo la copia, come un seqlock, e scarta la copia se nel frattempo è cambiato
+
+	Costruttori:
+	- DiarioScansioni(const std::string &, int, double, int, FormatoCampioni, double)
+	                                   -> apre in scrittura il diario con percorso, numero di record,
+	                                      risoluzione, misure per scansione, formato e scala: se il
+	                                      file non c'è viene creato, altrimenti deve avere gli stessi
+	                                      parametri e si continua dopo il record più nuovo
+	- DiarioScansioni(const std::string &) -> apre in sola lettura un diario esistente
+	  (l'oggetto non è copiabile, perché possiede la mappatura del file)
+
+	Funzioni membro:
+	- void scrivi(const unsigned char *, int, FormatoCampioni, long long, unsigned long long)
+	                                      -> scrive un record con le misure passate (numero di misure e
+	                                         formato devono essere quelli del diario, altrimenti viene
+	                                         lanciata "FileSbagliatoError"), il loro timestamp e la
+	                                         loro sequenza nel driver
+	- void aggiorna()                     -> rilegge le intestazioni dei record e ricostruisce gli indici
+	                                         (la chiama il costruttore; in un lettore serve a vedere i
+	                                         record scritti nel frattempo dal driver)
+	- void sincronizza()                  -> forza la scrittura su disco delle pagine modificate
+	- int size() const                    -> numero di scansioni nel diario
+	- int get_numero_record() const       -> numero massimo di scansioni nel diario
+	- VistaScansione get_view(int) const  -> vista sulla k-esima scansione (0 = la più vecchia); in un
+	                                         lettore è affidabile solo se il driver non sta scrivendo
+	- bool leggi(int, double *) const     -> copia (in double) le misure della k-esima scansione, false
+	                                         se il record è stato riscritto prima o durante la copia
+	- const unsigned char *misure(int) const -> misure della k-esima scansione nel formato del diario
+	- const IntestazioneScansione &intestazione(int) const -> intestazione della k-esima scansione
+	- int cerca_sequenza(unsigned long long) const -> posizione della scansione con quella sequenza (del
+	                                         driver), -1 se non è (più) nel diario
+	- get_dim_scansioni(), get_formato(), get_resolution(), get_scala() -> parametri del diario
+
+	Classi per lancio di eccezioni (le stesse di LidarDriver)
+	- FileSbagliatoError         -> il file non si apre, non è un diario o ha parametri diversi
+	- NoGheSonVettoriError       -> lanciata se si chiede una scansione che non c'è
+	- DimBufferForaDaiRangeError -> lanciata se il numero di record non è positivo
+*/
+
+#ifndef DIARIOSCANSIONI_H
+#define DIARIOSCANSIONI_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "FormatoBinario.h"
+#include "FormatoCampioni.h"
+#include "LidarDriver.h"
+#include "VistaScansione.h"
+
+namespace lidar_driver {
+	class DiarioScansioni {
+		public:
+			// costruttori e distruttori
+			DiarioScansioni(const std::string &, int, double, int, FormatoCampioni, double);
+			DiarioScansioni(const std::string &);
+			DiarioScansioni(const DiarioScansioni &) = delete;
+			DiarioScansioni &operator=(const DiarioScansioni &) = delete;
+			~DiarioScansioni();
+
+			// member function
+			void scrivi(const unsigned char *, int, FormatoCampioni, long long, unsigned long long);
+			void aggiorna();
+			void sincronizza();
+			int size() const;
+			int get_numero_record() const;
+			VistaScansione get_view(int) const;
+			bool leggi(int, double *) const;
+			const unsigned char *misure(int) const;
+			const IntestazioneScansione &intestazione(int) const;
+			int cerca_sequenza(unsigned long long) const;
+			int get_dim_scansioni() const;
+			FormatoCampioni get_formato() const;
+			double get_resolution() const;
+			double get_scala() const;
+
+			// classi per lancio di errori (condivise con LidarDriver)
+			using FileSbagliatoError = LidarDriver::FileSbagliatoError;
+			using NoGheSonVettoriError = LidarDriver::NoGheSonVettoriError;
+			using DimBufferForaDaiRangeError = LidarDriver::DimBufferForaDaiRangeError;
+
+		private:
+			// variabili private
+			int fd;					// file descriptor del diario
+			unsigned char *mappa;	// inizio della mappatura del file
+			std::size_t dimMappa;	// byte mappati (tutto il file)
+			bool scrivibile;		// aperto in scrittura (dal driver) o in sola lettura
+			IntestazioneDiario parametri;	// copia dell'intestazione del file
+			int elPiNovo;		// Indice del record più nuovo
+			int elPiVecio;		// Indice del record più vecchio
+			int dimension;		// Numero di record validi
+			unsigned long long ultimoProgressivo;	// Progressivo del record più nuovo (0 se vuoto)
+			std::vector<unsigned long long> generazioni;	// Generazione di ogni record (per le viste)
+
+			// funzioni private
+			bool mappa_file(const std::string &, bool, std::size_t);
+			void chiudi();
+			unsigned char *record(int i) const { return mappa + INIZIO_RECORD_DIARIO + static_cast<std::size_t>(i) * parametri.dimRecord; }
+			IntestazioneRecord *testa_record(int i) const { return reinterpret_cast<IntestazioneRecord *>(record(i)); }
+			IntestazioneScansione *intestazione_record(int i) const { return reinterpret_cast<IntestazioneScansione *>(record(i) + sizeof(IntestazioneRecord)); }
+			unsigned char *misure_record(int i) const { return record(i) + sizeof(IntestazioneRecord) + sizeof(IntestazioneScansione); }
+			int avanza(int i, int passi) const { return (i + passi) % static_cast<int>(parametri.numeroRecord); }
+	};
+}
+
+#endif // DIARIOSCANSIONI_H
@@ -0,0 +1,61 @@
+/*
+	FILE HEADER ESITOLIDAR.H
+
+	Risultato delle funzioni try_ di LidarDriver (try_get_distance, try_get_scan, try_get_last, ...):
+	contiene il valore richiesto oppure il motivo per cui non c'è, senza lanciare eccezioni, come
+	std::optional ma con l'errore (o come std::expected del C++23, di cui ha gli stessi nomi, così si
+	potrà sostituire senza cambiare il codice che lo usa).
+
+	Le funzioni che lanciano eccezioni (get_distance, get_scan, ...) sono scritte sopra quelle try_:
+	l'eccezione viene lanciata solo se l'esito contiene un errore, e ErroreLidar dice quale.
+
+	Tipi:
+	- enum class ErroreLidar { BUFFER_VUOTO, ANGOLO_FORA_DAI_RANGE }
+	                                 -> motivo per cui manca il valore (corrispondono alle eccezioni
+	                                    NoGheSonVettoriError e AngoloForaDaiRangeError)
+	- template<typename T> class EsitoLidar
+
+	Funzioni membro di EsitoLidar<T> (tutte noexcept, tranne value_or se la copia di T può lanciare):
+	- bool has_value() const, explicit operator bool() -> true se c'è il valore
+	- T &value(), T &operator*(), T *operator->()      -> il valore (solo se has_value())
+	- T value_or(U &&) const                           -> il valore, o quello passato se non c'è
+	- ErroreLidar error() const                        -> l'errore (solo se !has_value())
+*/
+
+#ifndef ESITOLIDAR_H
+#define ESITOLIDAR_H
+
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+namespace lidar_driver {
+	enum class ErroreLidar { BUFFER_VUOTO, ANGOLO_FORA_DAI_RANGE };
+
+	template <typename T>
+	class EsitoLidar {
+		public:
+			EsitoLidar(T valore) noexcept(std::is_nothrow_move_constructible_v<T>) : dato{std::move(valore)} {}
+			EsitoLidar(ErroreLidar errore) noexcept : errore{errore} {}
+
+			bool has_value() const noexcept { return dato.has_value(); }
+			explicit operator bool() const noexcept { return dato.has_value(); }
+
+			T &value() noexcept { return *dato; }
+			const T &value() const noexcept { return *dato; }
+			T &operator*() noexcept { return *dato; }
+			const T &operator*() const noexcept { return *dato; }
+			T *operator->() noexcept { return &*dato; }
+			const T *operator->() const noexcept { return &*dato; }
+			template <typename U>
+			T value_or(U &&altro) const { return dato.has_value() ? *dato : static_cast<T>(std::forward<U>(altro)); }
+
+			ErroreLidar error() const noexcept { return errore; }
+
+		private:
+			std::optional<T> dato;
+			ErroreLidar errore{};
+	};
+}
+
+#endif // ESITOLIDAR_H
@@ -0,0 +1,163 @@
+/*
+	FILE HEADER FLOTTALIDAR.H
+
+	Gestore di più lidar montati sullo stesso robot (una "flotta" di sensori): possiede un LidarDriver
+	per ogni sensore e un gruppo di thread lavoratori, ognuno legato a un core, che fanno l'inserimento
+	delle scansioni (filtri, statistiche, diario) e rispondono alle interrogazioni su tutti i sensori.
+
+	Note sulla implementazione:
+	 - i sensori sono divisi tra i lavoratori in modo fisso: il sensore s appartiene al lavoratore
+	   s % numero_lavoratori(), per cui il driver di un sensore viene sempre aggiornato dallo stesso
+	   thread (e dallo stesso core) e i suoi dati restano nella cache di quel core
+	 - new_scan non tocca il driver: copia la scansione nella "casella di arrivo" del sensore, un
+	   LidarDriverConcorrente (wait-free, un produttore e un consumatore), e sveglia il lavoratore del
+	   sensore, che la inserisce nel driver; per cui ogni sensore deve avere un solo thread produttore
+	   e le scansioni ricevono il timestamp quando il lavoratore le inserisce
+	 - le interrogazioni su tutti i sensori (ultime_scansioni, closest_obstacle, attendi) vengono
+	   eseguite in parallelo: ogni lavoratore elabora i suoi sensori, dopo aver inserito tutte le
+	   scansioni arrivate, e il thread che ha chiesto aspetta che abbiano finito tutti; per cui vedono
+	   sempre tutte le scansioni passate a new_scan dallo stesso thread prima della chiamata
+	 - ogni sensore ha un mutex, preso dal lavoratore durante l'inserimento e dalle interrogazioni, per
+	   cui con_driver può leggere o configurare un driver da qualsiasi thread
+	 - lo stato di ogni sensore e di ogni lavoratore è allocato separatamente e allineato alla cache
+	   line (alignas(CACHE_LINE)), così due lavoratori non scrivono mai sulla stessa linea (niente
+	   false sharing), nemmeno quando salvano il risultato di un'interrogazione
+	 - i lavoratori senza niente da fare dormono su un contatore atomico (std::atomic::wait), che
+	   new_scan e le interrogazioni incrementano per svegliarli
+
+	Costruttori:
+	- FlottaLidar(int, double, int = 0, FormatoCampioni = FormatoCampioni::DOUBLE, double = 0.001)
+	                                  -> numero di sensori, risoluzione (la stessa per tutti), numero di
+	                                     lavoratori (0 = uno per sensore, ma non più dei core disponibili),
+	                                     formato e scala delle misure dei driver
+	  (l'oggetto non è copiabile né spostabile, perché i lavoratori puntano ai suoi dati)
+	- ~FlottaLidar()                  -> ferma i lavoratori (le scansioni non ancora inserite si perdono)
+
+	Funzioni membro:
+	- void new_scan(int, std::span<const double>) -> passa una scansione del sensore indicato al suo lavoratore
+	- void new_scan(int, const std::vector<double> &) -> come sopra
+	- void attendi()                  -> aspetta che tutte le scansioni passate prima a new_scan siano inserite
+	- void ultime_scansioni(std::span<double>, std::span<long long>)
+	                                  -> copia l'ultima scansione di ogni sensore (il sensore s a partire da
+	                                     s * get_dim_scansioni()) e il suo timestamp; un sensore senza
+	                                     scansioni ha tutte le misure a 0 e timestamp -1
+	- OstacoloFlotta closest_obstacle() -> ostacolo più vicino tra le ultime scansioni di tutti i sensori
+	                                     (con sensore, distanza e angolo; sensore -1 se non ce ne sono);
+	                                     per i driver con le statistiche attive è O(1)
+	- template<typename F> auto con_driver(int, F) -> chiama f(LidarDriver &) sul driver del sensore
+	                                     mentre nessun altro lo usa (per configurarlo o leggerlo)
+	- int numero_sensori() const, int numero_lavoratori() const, int lavoratore_di(int) const
+	- int get_dim_scansioni() const   -> misure per scansione
+	- unsigned long long scansioni_perse(int) const -> scansioni del sensore sovrascritte nella casella di
+	                                     arrivo prima che il lavoratore riuscisse a inserirle
+
+	Classi per lancio di eccezioni
+	- SensoreForaDaiRangeError     -> lanciata se il numero del sensore (o dei sensori) non è valido
+	- DimensionOutputSbagliataError -> lanciata se gli span di ultime_scansioni sono troppo piccoli
+	- ResolusionForaDaiRangeError e ScalaForaDaiRangeError come in LidarDriver
+*/
+
+#ifndef FLOTTALIDAR_H
+#define FLOTTALIDAR_H
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <vector>
+#include "FormatoCampioni.h"
+#include "LidarDriver.h"
+#include "LidarDriverConcorrente.h"
+
+namespace lidar_driver {
+	// risultato di FlottaLidar::closest_obstacle
+	struct OstacoloFlotta {
+		int sensore{-1};		// sensore che vede l'ostacolo (-1 = nessuna misura valida)
+		double distanza{0};		// distanza dell'ostacolo
+		double angolo{0};		// angolo dell'ostacolo nel piano del sensore
+	};
+
+	class FlottaLidar {
+		public:
+			// costruttori e distruttori
+			FlottaLidar(int, double, int = 0, FormatoCampioni = FormatoCampioni::DOUBLE, double = 0.001);
+			FlottaLidar(const FlottaLidar &) = delete;
+			FlottaLidar &operator=(const FlottaLidar &) = delete;
+			~FlottaLidar();
+
+			// member function
+			void new_scan(int, std::span<const double>);
+			void new_scan(int, const std::vector<double> &);
+			void attendi();
+			void ultime_scansioni(std::span<double>, std::span<long long>);
+			OstacoloFlotta closest_obstacle();
+			int numero_sensori() const;
+			int numero_lavoratori() const;
+			int lavoratore_di(int) const;
+			int get_dim_scansioni() const;
+			unsigned long long scansioni_perse(int) const;
+
+			template <typename F>
+			auto con_driver(int s, F f) {
+				Sensore &sensore = this->sensore(s);
+				std::lock_guard<std::mutex> blocco(sensore.mutex);
+				return f(sensore.driver);
+			}
+
+			// classi per lancio di errori
+			class SensoreForaDaiRangeError{};
+			using DimensionOutputSbagliataError = LidarDriver::DimensionOutputSbagliataError;
+			using ResolusionForaDaiRangeError = LidarDriver::ResolusionForaDaiRangeError;
+			using ScalaForaDaiRangeError = LidarDriver::ScalaForaDaiRangeError;
+
+		private:
+			// costanti private
+			static constexpr int CACHE_LINE{64};
+
+			// stato di un sensore: driver, casella di arrivo e risultato dell'ultima interrogazione
+			struct alignas(CACHE_LINE) Sensore {
+				LidarDriver driver;
+				LidarDriverConcorrente arrivi;
+				std::mutex mutex;
+				OstacoloFlotta ostacolo;
+
+				Sensore(double r, FormatoCampioni f, double scala) : driver{r, f, scala}, arrivi{r} {}
+			};
+
+			// stato di un lavoratore: il campanello per svegliarlo e il suo thread
+			struct alignas(CACHE_LINE) Lavoratore {
+				std::atomic<unsigned> campanello{0};
+				std::thread thread;
+			};
+
+			// variabili private
+			std::vector<std::unique_ptr<Sensore>> sensori;			// un elemento per sensore
+			std::vector<std::unique_ptr<Lavoratore>> lavoratori;	// un elemento per lavoratore
+			int dimScansioni;	// Dimensione dei vettori delle scansioni
+			std::mutex interrogazione;	// una sola interrogazione alla volta
+
+			// interrogazione in corso: funzione da chiamare per ogni sensore e suo contesto
+			void (*lavoro)(void *, int){nullptr};
+			void *contesto{nullptr};
+
+			// contatori su cache line diverse da quelle dei dati
+			alignas(CACHE_LINE) std::atomic<unsigned long long> generazione{0};	// interrogazioni richieste
+			alignas(CACHE_LINE) std::atomic<int> mancanti{0};	// lavoratori che non hanno ancora finito
+			std::atomic<bool> fermo{false};						// i lavoratori devono terminare
+
+			// funzioni private
+			Sensore &sensore(int) const;
+			void lavora(int);
+			void sveglia(int);
+			void esegui(void (*)(void *, int), void *);
+
+			// chiama f(s) per ogni sensore s, in parallelo sui lavoratori
+			template <typename F>
+			void in_parallelo(F &f) {
+				esegui([](void *c, int s) { (*static_cast<F *>(c))(s); }, &f);
+			}
+	};
+}
+
+#endif // FLOTTALIDAR_H
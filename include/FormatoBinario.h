@@ -0,0 +1,93 @@
+/*
+	FILE HEADER FORMATOBINARIO.H
+
+	Intestazioni del formato binario con cui LidarDriver salva e rilegge le scansioni (funzioni
+	write_scan, write_buffer, read_scan e read_buffer).
+
+	Struttura:
+	- singola scansione -> IntestazioneScansione + dimScansioni misure nel formato indicato
+	- buffer intero     -> IntestazioneBuffer + numeroScansioni scansioni singole, dalla più vecchia
+	                       alla più nuova
+	- diario su file    -> IntestazioneDiario (nei primi INIZIO_RECORD_DIARIO byte) + numeroRecord
+	                       record di dimRecord byte, ognuno con una IntestazioneRecord seguita da una
+	                       scansione singola (vedi DiarioScansioni.h); un record con progressivo 0 è
+	                       vuoto o scritto a metà
+
+	Osservazioni:
+	- le misure vengono scritte esattamente come sono nel buffer (stesso formato, stessi byte), per
+	  cui scrittura e lettura sono delle semplici memcpy
+	- i numeri sono scritti nell'ordine dei byte della macchina (little-endian su x86 e ARM): i file
+	  sono pensati per registrare e rileggere lo stato del driver, non per lo scambio tra architetture
+	- le intestazioni hanno solo campi allineati alla loro dimensione, per cui non hanno byte di
+	  padding e la loro dimensione è la stessa con tutti i compilatori (vedi static_assert)
+*/
+
+#ifndef FORMATOBINARIO_H
+#define FORMATOBINARIO_H
+
+#include <cstdint>
+
+namespace lidar_driver {
+	// "firme" all'inizio delle intestazioni e versione del formato
+	constexpr char MAGIA_SCANSIONE[4] = {'L', 'D', 'R', 'S'};
+	constexpr char MAGIA_BUFFER[4] = {'L', 'D', 'R', 'B'};
+	constexpr char MAGIA_DIARIO[4] = {'L', 'D', 'R', 'J'};
+	constexpr std::uint16_t VERSIONE_FORMATO = 1;
+	constexpr std::uint16_t VERSIONE_DIARIO = 2;	// la 1 non aveva IntestazioneRecord
+
+	struct IntestazioneScansione {
+		char magia[4];				// MAGIA_SCANSIONE
+		std::uint16_t versione;		// VERSIONE_FORMATO
+		std::uint8_t formato;		// FormatoCampioni delle misure che seguono
+		std::uint8_t riservato;
+		std::uint32_t dimScansioni;	// numero di misure che seguono
+		std::uint32_t riservato2;
+		double resolusion;			// risoluzione angolare dello strumento
+		double scala;				// scala delle misure (solo per UINT16)
+		std::uint64_t sequenza;		// numero progressivo della scansione nel driver
+		std::int64_t timestamp;		// timestamp della scansione nel driver (ns)
+	};
+
+	struct IntestazioneBuffer {
+		char magia[4];				// MAGIA_BUFFER
+		std::uint16_t versione;		// VERSIONE_FORMATO
+		std::uint8_t formato;		// FormatoCampioni del buffer
+		std::uint8_t riservato;
+		std::uint32_t dimScansioni;	// misure per scansione
+		std::uint32_t dimBuffer;	// numero massimo di scansioni del buffer
+		double resolusion;			// risoluzione angolare dello strumento
+		double scala;				// scala delle misure (solo per UINT16)
+		std::uint32_t numeroScansioni;	// scansioni che seguono l'intestazione
+		std::uint32_t riservato2;
+	};
+
+	struct IntestazioneDiario {
+		char magia[4];				// MAGIA_DIARIO
+		std::uint16_t versione;		// VERSIONE_FORMATO
+		std::uint8_t formato;		// FormatoCampioni dei record
+		std::uint8_t riservato;
+		std::uint32_t dimScansioni;	// misure per scansione
+		std::uint32_t numeroRecord;	// numero di record del file (poi si ricomincia dal primo)
+		double resolusion;			// risoluzione angolare dello strumento
+		double scala;				// scala delle misure (solo per UINT16)
+		std::uint32_t dimRecord;	// byte di ogni record (intestazioni + misure, multiplo di 64)
+		std::uint32_t riservato2;
+	};
+
+	// inizio di ogni record del diario, prima della IntestazioneScansione: con questa arriva a 64 byte,
+	// così le misure iniziano su una cache line
+	struct IntestazioneRecord {
+		std::uint64_t progressivo;	// ordine di scrittura nel diario (da 1; 0 = record vuoto o scritto a metà)
+		std::uint64_t riservato;
+	};
+
+	// i record del diario iniziano dopo la prima cache line, che contiene l'intestazione
+	constexpr std::uint32_t INIZIO_RECORD_DIARIO = 64;
+
+	static_assert(sizeof(IntestazioneScansione) == 48, "IntestazioneScansione non deve avere padding");
+	static_assert(sizeof(IntestazioneBuffer) == 40, "IntestazioneBuffer non deve avere padding");
+	static_assert(sizeof(IntestazioneDiario) == 40, "IntestazioneDiario non deve avere padding");
+	static_assert(sizeof(IntestazioneRecord) == 16, "IntestazioneRecord non deve avere padding");
+}
+
+#endif // FORMATOBINARIO_H
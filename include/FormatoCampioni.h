@@ -0,0 +1,91 @@
+/*
+	FILE HEADER FORMATOCAMPIONI.H
+
+	Formati con cui le misure possono essere memorizzate nel buffer di LidarDriver e funzioni per
+	convertire da/verso double.
+
+	Formati:
+	- DOUBLE -> 8 byte per misura, nessuna conversione (formato di default)
+	- FLOAT  -> 4 byte per misura, precisione di circa 7 cifre significative
+	- UINT16 -> 2 byte per misura, intero senza segno che vale misura / scala arrotondato
+	            (es. con scala 0.001 e misure in metri: precisione al millimetro fino a 65.535 m);
+	            le misure negative diventano 0, quelle troppo grandi diventano 65535 * scala
+
+	Funzioni:
+	- int dimensione_campione(FormatoCampioni) -> byte occupati da una misura
+	- double leggi_campione(const unsigned char *, int, FormatoCampioni, double)
+	                                            -> misura i-esima di uno slot, convertita in double
+	- void codifica_campioni(const double *, int, unsigned char *, FormatoCampioni, double)
+	                                            -> converte n misure double nel formato indicato
+	- void decodifica_campioni(const unsigned char *, int, double *, FormatoCampioni, double)
+	                                            -> converte n misure dal formato indicato a double
+
+	Osservazione:
+	- i cicli di conversione sono scritti senza dipendenze tra le iterazioni e senza chiamate a
+	  funzioni (l'arrotondamento è fatto con + 0.5 e troncamento), così il compilatore li vettorizza
+*/
+
+#ifndef FORMATOCAMPIONI_H
+#define FORMATOCAMPIONI_H
+
+#include <cstdint>
+#include <cstring>
+
+namespace lidar_driver {
+	enum class FormatoCampioni { DOUBLE, FLOAT, UINT16 };
+
+	inline int dimensione_campione(FormatoCampioni formato) {
+		switch (formato) {
+			case FormatoCampioni::FLOAT:  return sizeof(float);
+			case FormatoCampioni::UINT16: return sizeof(std::uint16_t);
+			default:                      return sizeof(double);
+		}
+	}
+
+	inline double leggi_campione(const unsigned char *slot, int i, FormatoCampioni formato, double scala) {
+		switch (formato) {
+			case FormatoCampioni::FLOAT:  return reinterpret_cast<const float *>(slot)[i];
+			case FormatoCampioni::UINT16: return reinterpret_cast<const std::uint16_t *>(slot)[i] * scala;
+			default:                      return reinterpret_cast<const double *>(slot)[i];
+		}
+	}
+
+	inline void codifica_campioni(const double *src, int n, unsigned char *dest, FormatoCampioni formato, double scala) {
+		if (formato == FormatoCampioni::DOUBLE) {
+			std::memcpy(dest, src, n * sizeof(double));
+		}
+		else if (formato == FormatoCampioni::FLOAT) {
+			float *d = reinterpret_cast<float *>(dest);
+			for (int i = 0; i < n; i++)
+				d[i] = static_cast<float>(src[i]);
+		}
+		else {
+			std::uint16_t *d = reinterpret_cast<std::uint16_t *>(dest);
+			const double inversa = 1 / scala;
+			for (int i = 0; i < n; i++) {
+				double q = src[i] * inversa + 0.5;
+				q = (q >= 0) ? q : 0;	// anche NaN diventa 0
+				q = (q > 65535) ? 65535 : q;
+				d[i] = static_cast<std::uint16_t>(static_cast<int>(q));
+			}
+		}
+	}
+
+	inline void decodifica_campioni(const unsigned char *src, int n, double *dest, FormatoCampioni formato, double scala) {
+		if (formato == FormatoCampioni::DOUBLE) {
+			std::memcpy(dest, src, n * sizeof(double));
+		}
+		else if (formato == FormatoCampioni::FLOAT) {
+			const float *s = reinterpret_cast<const float *>(src);
+			for (int i = 0; i < n; i++)
+				dest[i] = s[i];
+		}
+		else {
+			const std::uint16_t *s = reinterpret_cast<const std::uint16_t *>(src);
+			for (int i = 0; i < n; i++)
+				dest[i] = s[i] * scala;
+		}
+	}
+}
+
+#endif // FORMATOCAMPIONI_H
@@ -0,0 +1,79 @@
+/*
+	FILE HEADER FORMATTATORETESTO.H
+
+	Classe per stampare le scansioni di un LidarDriver in formato testuale (leggibile) in modo
+	efficiente, ad esempio per i log.
+
+	Note sulla implementazione:
+	 - le misure vengono lette direttamente dal buffer del driver tramite VistaScansione, senza
+	   copiare la scansione
+	 - ogni misura viene convertita con std::to_chars (niente allocazioni, niente locale) e aggiunta
+	   a una stringa interna che viene riusata a ogni chiamata: dopo le prime chiamate ha già la
+	   capacità necessaria e non viene più riallocata
+	 - le funzioni restituiscono uno std::string_view sulla stringa interna, valido fino alla
+	   chiamata successiva sullo stesso formattatore
+	 - con le opzioni di default il testo è identico a quello della vecchia operator<< (6 decimali,
+	   "{ " + misure separate da ", " + " }\n")
+
+	Opzioni (struct OpzioniTesto):
+	- int precisione        -> numero di cifre decimali (default 6)
+	- std::string separatore -> testo tra due misure (default ", ")
+	- std::string apertura   -> testo prima della prima misura (default "{ ")
+	- std::string chiusura   -> testo dopo l'ultima misura (default " }\n")
+	- std::string vuoto      -> testo stampato se non ci sono scansioni (default "{ }\n")
+
+	Costruttori:
+	- FormattatoreTesto(OpzioniTesto = {}) -> crea il formattatore con le opzioni indicate
+
+	Funzioni membro:
+	- std::string_view formatta(const VistaScansione &)       -> testo di una scansione
+	- std::string_view formatta_ultima(const LidarDriver &)   -> testo dell'ultima scansione inserita
+	- std::string_view formatta_buffer(const LidarDriver &)   -> testo di tutte le scansioni del buffer,
+	                                                             dalla più vecchia alla più nuova
+	- std::string_view formatta_settore(const LidarDriver &, double, double)
+	                                                          -> testo delle misure dell'ultima scansione
+	                                                             con angolo nel settore [inizio, fine]
+	- const OpzioniTesto &get_opzioni() const / void set_opzioni(const OpzioniTesto &)
+*/
+
+#ifndef FORMATTATORETESTO_H
+#define FORMATTATORETESTO_H
+
+#include <string>
+#include <string_view>
+#include "LidarDriver.h"
+#include "VistaScansione.h"
+
+namespace lidar_driver {
+	struct OpzioniTesto {
+		int precisione{6};
+		std::string separatore{", "};
+		std::string apertura{"{ "};
+		std::string chiusura{" }\n"};
+		std::string vuoto{"{ }\n"};
+	};
+
+	class FormattatoreTesto {
+		public:
+			// costruttori
+			FormattatoreTesto(OpzioniTesto = {});
+
+			// member function
+			std::string_view formatta(const VistaScansione &);
+			std::string_view formatta_ultima(const LidarDriver &);
+			std::string_view formatta_buffer(const LidarDriver &);
+			std::string_view formatta_settore(const LidarDriver &, double, double);
+			const OpzioniTesto &get_opzioni() const;
+			void set_opzioni(const OpzioniTesto &);
+
+		private:
+			// variabili private
+			OpzioniTesto opzioni;	// opzioni di formattazione
+			std::string testo;		// stringa riusata per il risultato
+
+			// funzioni private
+			void aggiungi_scansione(const VistaScansione &, int, int);
+	};
+}
+
+#endif // FORMATTATORETESTO_H
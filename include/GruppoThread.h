@@ -0,0 +1,95 @@
+/*
+	FILE HEADER GRUPPOTHREAD.H
+
+	Gruppo di thread (thread pool) per eseguire in parallelo lo stesso lavoro su tanti elementi, ad
+	esempio su tutte le scansioni di un LidarDriver con un buffer molto grande (vedi for_each_scan e
+	transform_scans).
+
+	Note sulla implementazione:
+	 - i thread vengono creati una volta sola dal costruttore e, quando non c'è lavoro, dormono su un
+	   contatore atomico (std::atomic::wait)
+	 - per_ogni(n, f) chiama f(i) per ogni i in [0, n): gli indici vengono presi a blocchi da un
+	   contatore atomico condiviso, per cui chi finisce prima il suo blocco ne prende subito un altro
+	   e il carico si bilancia da solo anche se alcuni elementi costano più di altri (come con il
+	   work stealing, ma senza code per thread, che con un unico intervallo di indici non servono)
+	 - anche il thread che chiama per_ogni lavora, e al ritorno tutti gli f(i) sono terminati
+	 - se un f(i) lancia un'eccezione, gli indici non ancora presi vengono saltati e la prima eccezione
+	   viene rilanciata da per_ogni nel thread che l'ha chiamata
+	 - un solo per_ogni alla volta usa i thread del gruppo; un per_ogni chiamato da dentro un f(i)
+	   (lavoro annidato) viene eseguito tutto dal thread che lo chiama, senza aspettare gli altri
+
+	Costruttori:
+	- GruppoThread(int = 0) -> crea il gruppo con il numero di thread indicato (0 = uno per core, meno
+	                           quello del thread che chiama per_ogni); con 0 o 1 core non crea thread e
+	                           per_ogni lavora nel thread che la chiama
+	  (l'oggetto non è copiabile né spostabile, perché i thread puntano ai suoi dati)
+	- ~GruppoThread()       -> ferma i thread
+
+	Funzioni membro:
+	- template<typename F> void per_ogni(int n, F &&f, int massimo = 0, int blocco = 1)
+	                        -> chiama f(i) per ogni i in [0, n) usando al massimo "massimo" thread in
+	                           tutto, compreso quello che chiama (0 = tutti), prendendo "blocco" indici
+	                           alla volta
+	- int size() const      -> numero di thread del gruppo (escluso quello che chiama per_ogni)
+	- static GruppoThread &condiviso() -> gruppo creato al primo uso e usato da LidarDriver
+*/
+
+#ifndef GRUPPOTHREAD_H
+#define GRUPPOTHREAD_H
+
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace lidar_driver {
+	class GruppoThread {
+		public:
+			// costruttori e distruttori
+			GruppoThread(int = 0);
+			GruppoThread(const GruppoThread &) = delete;
+			GruppoThread &operator=(const GruppoThread &) = delete;
+			~GruppoThread();
+
+			// member function
+			template <typename F>
+			void per_ogni(int n, F &&f, int massimo = 0, int blocco = 1) {
+				esegui(n, [](void *c, int i) { (*static_cast<std::remove_reference_t<F> *>(c))(i); },
+				       const_cast<void *>(static_cast<const void *>(&f)), massimo, blocco);
+			}
+			int size() const;
+			static GruppoThread &condiviso();
+
+		private:
+			// costanti private
+			static constexpr int CACHE_LINE{64};
+
+			// variabili private
+			std::vector<std::thread> thread;	// thread del gruppo
+			std::mutex occupato;	// un solo per_ogni alla volta
+
+			// lavoro in corso: funzione da chiamare per ogni indice, suo contesto e indici
+			void (*lavoro)(void *, int){nullptr};
+			void *contesto{nullptr};
+			int totale{0};			// numero di indici
+			int dimBlocco{1};		// indici presi alla volta
+			int partecipanti{0};	// thread del gruppo che lavorano (gli altri tornano a dormire)
+			std::exception_ptr errore;	// prima eccezione lanciata da un f(i)
+			std::mutex mutexErrore;		// protegge errore
+
+			// contatori su cache line diverse: il prossimo indice cambia di continuo
+			alignas(CACHE_LINE) std::atomic<int> prossimo{0};	// primo indice non ancora preso
+			alignas(CACHE_LINE) std::atomic<unsigned> generazione{0};	// lavori avviati (campanello)
+			std::atomic<int> mancanti{0};	// thread del gruppo che non hanno ancora finito il lavoro
+			std::atomic<bool> fermo{false};	// i thread devono terminare
+
+			// funzioni private
+			void esegui(int, void (*)(void *, int), void *, int, int);
+			void lavora(int);
+			void prendi_blocchi();
+	};
+}
+
+#endif // GRUPPOTHREAD_H
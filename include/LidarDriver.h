@@ -6,33 +6,106 @@
 	funzioni per maneggiare i dati memorizzati.
 
 	Note sulla implementazione del buffer:
-	 - il buffer è implementato come vettore (o coda) circolare di dimensione costate di BUFFER_DIM
-	   con indice del primo elemento, indice dell'ultimo elemento e una variabile che tiene traccia
-	   della dimensione occupata
-	 - secia     -> vettore del tipo std::vector<std::vector<double>>
+	 - il buffer è implementato come vettore (o coda) circolare di dimensione dimBuffer (di default
+	   BUFFER_DIM, ma si può scegliere nel costruttore e cambiare con set_dim_buffer) con indice del
+	   primo elemento, indice dell'ultimo elemento e una variabile che tiene traccia della dimensione
+	   occupata
+	 - gli indici avanzano con la funzione avanza: se dimBuffer è una potenza di 2 si usa una
+	   maschera di bit (i & (dimBuffer - 1)) invece del modulo, che è molto più lento
+	 - ogni scansione è memorizzata in uno slot di dimScansioni misure (allineato alla cache line),
+	   allocato a parte dalla risorsa del driver; gli slot sono condivisi (con un contatore dei
+	   riferimenti, std::shared_ptr) tra il driver e le sue copie: copiare un driver copia solo i
+	   puntatori agli slot, e quando uno dei due scrive una nuova scansione in uno slot condiviso gli
+	   viene dato uno slot nuovo, così l'altro continua a vedere la vecchia scansione (copy-on-write)
+	 - il costruttore alloca tutti gli slot e finché non ci sono copie new_scan riusa sempre gli
+	   stessi (0 allocazioni); con una copia in giro, invece, ogni new_scan su uno slot ancora
+	   condiviso alloca uno slot nuovo: è il prezzo delle istantanee, che prima (un unico blocco per
+	   tutte le scansioni) andavano copiate per intero. Per non passare dall'heap in quel caso c'è
+	   set_risorsa con una RiservaSlot
+	 - per questo le copie sono "istantanee" economiche del buffer: una copia presa da un altro thread
+	   (con lo stesso mutex che protegge new_scan) si può leggere mentre il driver originale continua a
+	   ricevere scansioni, perché nessuno dei due scrive mai in uno slot che l'altro può vedere
+	 - le misure possono essere memorizzate come double (default), float o interi a 16 bit con una
+	   scala (vedi FormatoCampioni.h): tutte le funzioni ricevono e restituiscono comunque double
+	 - secia     -> vettore di puntatori condivisi agli slot (std::shared_ptr<unsigned char>)
 	 - elPiNovo  -> indice dell'ultimo vettore inserito
 	 - elPiVecio -> indice dell'elemento nel vettore da più tempo
 	 - dimension -> dimensione occupata nel buffer
+	 - ogni slot ha un numero di generazione che viene incrementato ogni volta che lo slot viene
+	   sovrascritto (o il buffer svuotato), così le VistaScansione possono capire se i dati che
+	   puntano sono ancora validi
+	 - ogni slot ha anche un timestamp e un numero di sequenza: se non vengono passati a new_scan il
+	   timestamp è l'istante dell'inserimento (std::chrono::steady_clock, in ns) e la sequenza è quella
+	   successiva all'ultima; i timestamp devono essere non decrescenti (come quelli di un orologio
+	   monotono), così nell'ordine del buffer sono ordinati e le ricerche per tempo sono binarie: un
+	   timestamp passato minore dell'ultimo viene rifiutato con TimestampIndrioError, e quelli presi
+	   dall'orologio non scendono mai sotto l'ultimo (es. se prima erano quelli dello strumento)
+	 - siccome risoluzione e numero di misure non cambiano mai, il costruttore calcola una volta sola
+	   coseno e seno dell'angolo di ogni misura (tabelle allineate), usati da to_points per passare
+	   dalle coordinate polari a quelle cartesiane senza chiamare std::cos e std::sin
+	 - se attivate con set_statistiche, new_scan calcola anche le statistiche della nuova scansione
+	   (misura minima e suo angolo, massima, media, numero di misure valide), per tutta la scansione e
+	   per ogni settore angolare, con un solo passaggio vettorizzato mentre le misure sono ancora nella
+	   cache; le statistiche sono salvate insieme allo slot e le funzioni che le leggono sono O(1)
+	 - for_each_scan e transform_scans elaborano tutte le scansioni del buffer in parallelo con il gruppo
+	   di thread condiviso (vedi GruppoThread.h): ogni thread riceve una vista sullo slot, senza copie;
+	   l'ordine del buffer viene fissato all'inizio della chiamata e il driver non deve cambiare fino
+	   alla fine; per analizzare un driver che intanto riceve scansioni da un altro thread si lavora su
+	   una copia (un'istantanea) presa con lo stesso mutex che protegge new_scan
+	 - opzionalmente ogni scansione inserita viene scritta anche in un diario su file (vedi
+	   DiarioScansioni.h), che conserva molte più scansioni del buffer e sopravvive ai crash; le copie
+	   del driver non ereditano il diario (scriverebbero due volte nello stesso file), le move sì
+	 - le letture che possono fallire per motivi "normali" (buffer vuoto, angolo non valido) hanno
+	   anche una versione try_ che non lancia eccezioni e restituisce un EsitoLidar (il valore o
+	   l'errore, vedi EsitoLidar.h): chi legge in un ciclo stretto (es. un consumatore che trova
+	   spesso il buffer vuoto) evita così il costo di lancio e cattura; le versioni che lanciano sono
+	   scritte sopra quelle try_, per cui le due si comportano allo stesso modo
 
 	Costanti private della classe:
-	- int BUFFER_DIM = 10         -> dimensione massima del buffer
+	- int BUFFER_DIM = 10         -> dimensione di default del buffer
 	- int MIN_ANGLE = 0           -> angolo minimo da cui parte la scansione
 	- int MAX_ANGLE = 180         -> angolo massimo in cui termina la scansione
 	- double MIN_RESOLUTION = 0.1 -> risoluzione minima accettata
 	- double MAX_RESOLUTION = 1   -> risoluzione massima accettata
+	- int BLOCCO_FUSIONE = 128    -> misure elaborate insieme dai kernel di fusione (stanno nella cache L1)
+	- int MAX_RETE_MEDIANA = 16   -> numero massimo di righe per cui la mediana usa la rete di ordinamento
+	- int MAX_MISURE = 1801       -> numero massimo di misure per scansione (con la risoluzione minima)
+	- std::size_t ALLINEAMENTO_SLOT = 64 -> allineamento degli slot (una cache line)
 
 	Variabili rpivate della classe:
-	- std::vector<std::vector<double>> secia ->
+	- std::vector<std::shared_ptr<unsigned char>> secia -> slot delle scansioni (condivisi con le copie)
+	- std::pmr::memory_resource *risorsa -> da dove vengono allocati gli slot (di default l'heap)
+	- MetricheLidar *metriche -> metriche aggiornate dalle operazioni (nullptr se non ci sono)
 	- int elPiNovo      -> indice dell'ultimo vettore inserito
 	- int elPiVecio     -> indice dell'elemento nel vettore da più tempo
 	- int dimension     -> dimensione occupata nel buffer
 	- int dimScansioni  -> dimensione dei vettori delle scansioni
+	- std::deque<unsigned long long> generazioni -> generazione di ogni slot del buffer (una deque che
+	                      non si accorcia mai, perché le viste puntano ai suoi elementi)
 	- double resolusion -> risoluzione angolare dello strumento
+	- FormatoCampioni formato -> formato delle misure nel buffer
+	- double scala      -> scala delle misure (solo per il formato UINT16)
+	- int dimCampione   -> byte occupati da una misura nel buffer
+	- int dimBuffer     -> numero massimo di scansioni nel buffer
+	- bool potenzaDi2   -> true se dimBuffer è una potenza di 2 (indici con la maschera di bit)
+	- unsigned long long scansioniInserite -> numero di sequenza della prossima scansione (dalla creazione, o
+	                      dopo l'ultima sequenza passata a new_scan)
+	- std::vector<long long> tempi -> timestamp di ogni slot (ns di un orologio monotono)
+	- std::vector<unsigned long long> sequenze -> numero di sequenza di ogni slot
+	- unsigned long long scansioniPerse -> scansioni sovrascritte prima di essere lette con get_scan
+	- Filtri filtri, bool filtriAttivi -> filtri applicati da new_scan e se ce n'è almeno uno attivo
+	- std::vector<double> lavoro -> spazio di lavoro dei filtri (non viene copiato, si rialloca al primo uso)
+	- std::shared_ptr<const TabellePunti> tabelle -> coseno e seno dell'angolo di ogni misura (per
+	                      to_points), condivisi con le copie perché non cambiano mai
+	- bool statisticheAttive -> new_scan calcola le statistiche delle nuove scansioni
+	- int misurePerSettore, numeroSettori -> misure di ogni settore angolare e numero di settori
+	- std::vector<StatisticheScansione> statistiche -> per ogni slot numeroSettori + 1 statistiche: prima
+	                      quelle di tutta la scansione, poi quelle di ogni settore
 
 	Nota sui costruttori-operatori di copia e di move:
 	1. apparentemente non servirebbe implementare il costruttore e l'operatore di assegnamento di copia,
-	   siccome basterebbe una shallow copy -> non abbiamo puntatori da gestire e il vettore secia applica
-	   la copia membro a membro sugli elementi che contiene come definita dalla classe std::vector
+	   siccome basterebbe una shallow copy -> gli shared_ptr degli slot e delle tabelle vengono copiati
+	   (condivisi) e gli altri vettori applicano la copia membro a membro sugli elementi che contengono
 	2. serve, invece, il costruttore di move e l'operatore di move per risparmiare dati e tempo: meglio
 	   non copiare i vettori delle scansioni se si può evitare facendo una move
 	3. siccome non si può implementare solo quello di move e non quello di copy, ci tocca farli entrambi,
@@ -40,17 +113,132 @@
 	   si fanno assegnamenti tra lvalues segna errore
 	
 	Costruttori:
-	- LidarDriver(double)              -> costruttore che riceve come parametro la risoluzione dello strumento
+	- LidarDriver(double, FormatoCampioni = DOUBLE, double = 0.001)
+	                                   -> costruttore che riceve come parametro la risoluzione dello strumento
+	                                      e, opzionalmente, il formato delle misure nel buffer e la scala
+	- LidarDriver(double, int, FormatoCampioni = DOUBLE, double = 0.001)
+	                                   -> come sopra, con il numero di scansioni del buffer
+	- LidarDriver(double, BudgetMemoria, FormatoCampioni = DOUBLE, double = 0.001)
+	                                   -> come sopra, il numero di scansioni è il massimo che sta nei byte
+	                                      del budget (es. LidarDriver(0.1, BudgetMemoria{1 << 20}))
 	- LidarDriver(const LidarDriver &) -> costruttore di copia
 	- LidarDriver(LidarDriver &&)      -> costruttore di move
 	
 	Funzioni membro:
-	- void new_scan(std::vector<double>)   -> inserisce nel buffer la scansione passata come parametro
+	- void new_scan(std::span<const double>)   -> inserisce nel buffer la scansione passata come parametro,
+	                                              copiandola direttamente nel suo slot
+	- void new_scan(const std::vector<double> &) -> come sopra, per i vector
+	- void new_scan(std::span<const double>, long long) -> come sopra, con il timestamp della scansione (ns,
+	                                          non minore di quello dell'ultima scansione nel buffer)
+	- void new_scan(std::span<const double>, long long, unsigned long long)
+	                                       -> come sopra, con timestamp e numero di sequenza della scansione
+	- void new_scan(It, It)                -> come sopra, per una sequenza di misure data da due iteratori
+	- void new_scans(std::span<const double>, int) -> inserisce più scansioni consecutive (ognuna del numero
+	                                          di misure indicato) aggiornando gli indici una volta sola
 	- std::vector<double> get_scan()       -> restituisce e rimuove dal buffer la scansione più vecchia
 	- std::vector<double> get_last() const -> restituisce senza rimuovere l'ultima scansione inserita
+	- VistaScansione get_scan_view()       -> come get_scan, ma restituisce una vista sullo slot invece
+	                                          di una copia (valida finché lo slot non viene sovrascritto)
+	- VistaScansione get_last_view() const -> come get_last, ma restituisce una vista invece di una copia
+	- EsitoLidar<std::vector<double>> try_get_scan(), EsitoLidar<std::vector<double>> try_get_last() const,
+	  EsitoLidar<VistaScansione> try_get_scan_view(), EsitoLidar<VistaScansione> try_get_last_view() const
+	                                       -> come le funzioni senza try_, ma con il buffer vuoto
+	                                          restituiscono l'errore BUFFER_VUOTO invece di lanciare
+	- VistaScansione get_view(int) const   -> vista sulla k-esima scansione del buffer senza rimuoverla
+	                                          (0 = la più vecchia, size() - 1 = la più nuova)
+	- int size() const                     -> numero di scansioni presenti nel buffer
+	- double get_resolution() const        -> risoluzione angolare dello strumento
+	- int get_dim_scansioni() const        -> numero di misure di ogni scansione
+	- long long get_timestamp(int) const   -> timestamp della k-esima scansione del buffer (come get_view)
+	- unsigned long long get_sequenza(int) const -> numero di sequenza della k-esima scansione del buffer
+	- int trova_vicina(long long) const    -> posizione (come get_view) della scansione con il timestamp più
+	                                          vicino a quello passato, con una ricerca binaria
+	- std::pair<int, int> trova_intervallo(long long, long long) const
+	                                       -> posizioni [prima, ultima + 1) delle scansioni con timestamp
+	                                          nell'intervallo [t0, t1], con due ricerche binarie
+	- unsigned long long scansioni_perse() const -> scansioni sovrascritte da new_scan prima di essere lette
+	- void get_scan(std::vector<double> &) -> come get_scan, ma copia la scansione nel vettore passato,
+	                                          riusandone la memoria già allocata
+	- bool try_get_scan(std::vector<double> &) -> come sopra, ma restituisce false se il buffer è vuoto
 	- void clear_buffer()                  -> svuota il buffer da tutte le scansioni
 	- double get_distance(double) const    -> restituisce la misura effettuata nell'ultima scansione per
 	                                          uno specifico angolo passato come parametro
+	- EsitoLidar<double> try_get_distance(double) const -> come get_distance, ma restituisce l'errore
+	                                          (BUFFER_VUOTO o ANGOLO_FORA_DAI_RANGE) invece di lanciare
+	- void get_distances(std::span<const double>, std::span<double>) const
+	                                       -> come get_distance, ma per tutti gli angoli del primo span: le
+	                                          misure vengono scritte nel secondo span (stessa dimensione)
+	- int get_distances(double, double, double, std::span<double>) const
+	                                       -> misure del settore [inizio, fine] con un certo passo, scritte
+	                                          nello span; restituisce il numero di misure scritte
+	- double get_distance_interpolata(double) const
+	                                       -> come get_distance, ma interpolando linearmente tra le due misure
+	                                          vicine all'angolo invece di prendere la più vicina
+	- double get_distance_fusa(double, int, Fusione) const
+	                                       -> media o mediana della misura per l'angolo nelle ultime N
+	                                          scansioni del buffer, senza le misure a 0 (riempimento)
+	- void get_scan_fusa(int, Fusione, std::span<double>) const
+	                                       -> come sopra, per tutti gli angoli: la scansione "fusa" viene
+	                                          scritta nello span (almeno dimScansioni misure)
+	- void set_filtri(const Filtri &)      -> imposta i filtri che new_scan applica a ogni nuova scansione
+	                                          direttamente nel suo slot (Filtri{} per toglierli)
+	- const Filtri &get_filtri() const     -> filtri impostati
+	- void set_metriche(MetricheLidar *)   -> collega le metriche (contatori e durate) che il driver
+	                                          aggiorna, nullptr per scollegarle; solo se compilato con
+	                                          LIDAR_METRICHE (vedi MetricheLidar.h)
+	- MetricheLidar *get_metriche() const  -> metriche collegate (nullptr se non ce ne sono)
+	- void to_points(std::span<double>, std::span<double>) const
+	                                       -> converte l'ultima scansione in punti (x, y) nel piano dello
+	                                          strumento: le coordinate x e y vengono scritte nei due span
+	                                          (almeno dimScansioni misure ciascuno)
+	- void to_points(int, std::span<double>, std::span<double>) const
+	                                       -> come sopra, per la k-esima scansione del buffer (come get_view)
+	- void set_statistiche(bool, double = 0) -> attiva (o disattiva) il calcolo delle statistiche in new_scan,
+	                                          con settori angolari della larghezza indicata in gradi (0 =
+	                                          un solo settore con tutta la scansione); le calcola subito per
+	                                          le scansioni già nel buffer
+	- double larghezza_settore() const     -> larghezza effettiva dei settori (multiplo della risoluzione):
+	                                          il settore s inizia all'angolo s * larghezza_settore()
+	- bool statistiche_attive() const      -> true se new_scan calcola le statistiche
+	- const StatisticheScansione &scan_stats() const -> statistiche dell'ultima scansione inserita
+	- const StatisticheScansione &scan_stats(int) const -> statistiche della k-esima scansione del buffer
+	- std::span<const StatisticheScansione> sector_stats(int) const
+	                                       -> statistiche di ogni settore della k-esima scansione del buffer
+	- std::pair<double, double> closest_obstacle() const -> distanza e angolo dell'ostacolo più vicino
+	                                          nell'ultima scansione (la misura valida più piccola)
+	- template<typename F> void for_each_scan(F, int = 0) const
+	                                       -> chiama f(k, VistaScansione) per ogni scansione del buffer (k
+	                                          contato come in get_view) in parallelo, con al massimo il
+	                                          numero di thread indicato (0 = tutti quelli del gruppo condiviso)
+	- template<typename F> std::vector<R> transform_scans(F, int = 0) const
+	                                       -> come for_each_scan, ma restituisce i risultati R = f(k, vista)
+	                                          di tutte le scansioni, nell'ordine del buffer
+	- FormatoCampioni get_formato() const  -> formato delle misure nel buffer
+	- std::size_t memoria_buffer() const   -> byte occupati dal buffer delle scansioni
+	- std::size_t memoria_condivisa() const -> byte degli slot che il driver condivide con delle copie
+	- int get_dim_buffer() const           -> numero massimo di scansioni nel buffer
+	- void set_dim_buffer(int)             -> cambia il numero massimo di scansioni tenendo le più nuove
+	- void shrink_to_fit()                 -> restituisce gli slot che non contengono scansioni (clear_buffer
+	                                          invece tiene tutto allocato)
+	- void set_risorsa(std::pmr::memory_resource *, int = 0)
+	                                       -> gli slot vengono presi dalla risorsa indicata (es. una
+	                                          RiservaSlot condivisa da più driver), con il numero indicato
+	                                          di slot di scorta riservati per le copie
+	- void apri_diario(const std::string &, int) -> da ora scrive ogni scansione anche nel diario su file
+	                                          indicato, con quel numero di record: se il diario esiste
+	                                          già, le sue scansioni più nuove vengono ricaricate nel buffer
+	- void chiudi_diario()                 -> smette di scrivere nel diario
+	- const DiarioScansioni *get_diario() const -> diario aperto (nullptr se non c'è)
+	- void write_scan(std::ostream &) const   -> scrive l'ultima scansione in formato binario
+	- void write_buffer(std::ostream &) const -> scrive tutto il buffer in formato binario
+	- std::size_t write_buffer(std::span<unsigned char>) const
+	                                       -> come sopra, ma in memoria; restituisce i byte scritti
+	- std::size_t dimensione_binaria() const  -> byte scritti da write_buffer
+	- void read_scan(std::istream &)       -> legge una scansione in formato binario e la inserisce (senza
+	                                          applicare i filtri)
+	- static LidarDriver read_buffer(std::istream &)
+	- static LidarDriver read_buffer(std::span<const unsigned char>)
+	                                       -> ricreano un driver salvato con write_buffer
 
 	Overloading operatori
 	LidarDriver& operator=(const LidarDriver &)                   -> overloading operatore di copia
@@ -59,31 +247,161 @@
 
 	Classi per lancio di eccezioni
 	- class NoGheSonVettoriError{}        -> classe lanciata in caso si tenta di leggere/accedere/rimuovere
-	                                         delle scansioni quando il buffer è vuoto
+	                                         delle scansioni quando il buffer è vuoto (o una scansione che
+	                                         non c'è con get_view)
 	- class ResolusionForaDaiRangeError{} -> classe lanciata se la risoluzione passata al costruttore non è valida
+	- class ScalaForaDaiRangeError{}      -> classe lanciata se la scala passata al costruttore non è positiva
+	- class DimBufferForaDaiRangeError{}  -> classe lanciata se il buffer dovrebbe contenere meno di una scansione
+	- class FileSbagliatoError{}           -> classe lanciata se i dati binari letti non sono validi o sono incompleti
 	- class AngoloForaDaiRangeError{}     -> classe lanciata se l'angolo passato a get_distance non è valido
+	- class FiltroSbagliatoError{}         -> classe lanciata se la finestra dei filtri non è dispari o è troppo larga
+	- class StatisticheSpenteError{}       -> classe lanciata se si leggono le statistiche senza averle attivate
+	- class DimensionOutputSbagliataError{} -> classe lanciata se lo span di output di get_distances è troppo
+	                                         piccolo, o il passo del settore (o la dimensione delle scansioni
+	                                         di new_scans) non è positivo
+	- class TimestampIndrioError{}         -> classe lanciata se una scansione passata a new_scan o letta con
+	                                         read_scan ha un timestamp minore dell'ultima del buffer
+	                                         ("indrio" = indietro)
 */
 
 #ifndef LIDARDRIVER_H
 #define LIDARDRIVER_H
 
+#include <cstddef>
+#include <deque>
+#include <istream>
+#include <memory>
+#include <memory_resource>
 #include <ostream>
+#include <span>
+#include <string>
+#include <type_traits>
+#include <utility>
 #include <vector>
+#include "AllocatoreAllineato.h"
+#include "EsitoLidar.h"
+#include "FormatoBinario.h"
+#include "FormatoCampioni.h"
+#include "GruppoThread.h"
+#include "MetricheLidar.h"
+#include "VistaScansione.h"
 
 namespace lidar_driver {
+	// modo di fondere le misure di più scansioni (get_distance_fusa e get_scan_fusa)
+	enum class Fusione { MEDIA, MEDIANA };
+
+	// filtri applicati da new_scan a ogni scansione (set_filtri); con i valori di default non fanno niente
+	struct Filtri {
+		bool mascheraInvalidi{false};	// misure NaN, infinite o negative -> 0 (misura mancante)
+		double minimo{0};				// se massimo > minimo, le misure non nulle fuori da
+		double massimo{0};				// [minimo, massimo] vengono portate all'estremo più vicino
+		double sogliaPicchi{0};			// se > 0, una misura più alta (o più bassa) di entrambe le vicine
+										// di più della soglia diventa la media delle vicine
+		int finestra{1};				// larghezza (dispari, al massimo 15) della finestra di smoothing
+		Fusione smoothing{Fusione::MEDIANA};	// smoothing con la mediana o con la media della finestra
+	};
+
+	// statistiche di una scansione o di un suo settore (set_statistiche); una misura è valida se è
+	// positiva e finita (0 è una misura mancante), se non ce ne sono tutti i campi sono 0
+	struct StatisticheScansione {
+		double minimo{0};		// misura valida più piccola (l'ostacolo più vicino)
+		double angoloMinimo{0};	// angolo della misura più piccola (la prima, se sono più di una)
+		double massimo{0};		// misura valida più grande
+		double media{0};		// media delle misure valide
+		int valide{0};			// numero di misure valide
+	};
+
+	// coseno e seno dell'angolo di ogni misura, calcolati una volta sola (vedi to_points)
+	struct TabellePunti {
+		std::vector<double, AllocatoreAllineato<double>> coseni;
+		std::vector<double, AllocatoreAllineato<double>> seni;
+	};
+
+	// budget di memoria (in byte) per il buffer, da passare al costruttore di LidarDriver
+	struct BudgetMemoria {
+		std::size_t byte;
+	};
+
+	class DiarioScansioni;
+
 	class LidarDriver {
 		public:
 			// costruttori e distruttori
-			LidarDriver(double);
+			LidarDriver(double, FormatoCampioni = FormatoCampioni::DOUBLE, double = 0.001);
+			LidarDriver(double, int, FormatoCampioni = FormatoCampioni::DOUBLE, double = 0.001);
+			LidarDriver(double, BudgetMemoria, FormatoCampioni = FormatoCampioni::DOUBLE, double = 0.001);
 			LidarDriver(const LidarDriver &);
 			LidarDriver(LidarDriver &&);
 
 			// member function
-			void new_scan(std::vector<double>);
+			void new_scan(std::span<const double>);
+			void new_scan(const std::vector<double> &);
+			void new_scan(std::span<const double>, long long);
+			void new_scan(std::span<const double>, long long, unsigned long long);
+			template <typename It>
+			void new_scan(It, It);
+			void new_scans(std::span<const double>, int);
 			std::vector<double> get_scan();
 			std::vector<double> get_last() const;
+			VistaScansione get_scan_view();
+			VistaScansione get_last_view() const;
+			EsitoLidar<std::vector<double>> try_get_scan();
+			EsitoLidar<std::vector<double>> try_get_last() const;
+			EsitoLidar<VistaScansione> try_get_scan_view() noexcept;
+			EsitoLidar<VistaScansione> try_get_last_view() const noexcept;
+			VistaScansione get_view(int) const;
+			int size() const;
+			double get_resolution() const;
+			int get_dim_scansioni() const;
+			long long get_timestamp(int) const;
+			unsigned long long get_sequenza(int) const;
+			int trova_vicina(long long) const;
+			std::pair<int, int> trova_intervallo(long long, long long) const;
+			unsigned long long scansioni_perse() const;
+			void get_scan(std::vector<double> &);
+			bool try_get_scan(std::vector<double> &);
 			void clear_buffer();
 			double get_distance(double) const;
+			EsitoLidar<double> try_get_distance(double) const noexcept;
+			void get_distances(std::span<const double>, std::span<double>) const;
+			int get_distances(double, double, double, std::span<double>) const;
+			double get_distance_interpolata(double) const;
+			double get_distance_fusa(double, int, Fusione) const;
+			void get_scan_fusa(int, Fusione, std::span<double>) const;
+			void set_filtri(const Filtri &);
+			const Filtri &get_filtri() const;
+			void set_metriche(MetricheLidar *);
+			MetricheLidar *get_metriche() const;
+			void to_points(std::span<double>, std::span<double>) const;
+			void to_points(int, std::span<double>, std::span<double>) const;
+			void set_statistiche(bool, double = 0);
+			double larghezza_settore() const;
+			bool statistiche_attive() const;
+			const StatisticheScansione &scan_stats() const;
+			const StatisticheScansione &scan_stats(int) const;
+			std::span<const StatisticheScansione> sector_stats(int) const;
+			std::pair<double, double> closest_obstacle() const;
+			template <typename F>
+			void for_each_scan(F, int = 0) const;
+			template <typename F>
+			auto transform_scans(F, int = 0) const;
+			FormatoCampioni get_formato() const;
+			std::size_t memoria_buffer() const;
+			std::size_t memoria_condivisa() const;
+			int get_dim_buffer() const;
+			void set_dim_buffer(int);
+			void shrink_to_fit();
+			void set_risorsa(std::pmr::memory_resource *, int = 0);
+			void apri_diario(const std::string &, int);
+			void chiudi_diario();
+			const DiarioScansioni *get_diario() const;
+			void write_scan(std::ostream &) const;
+			void write_buffer(std::ostream &) const;
+			std::size_t write_buffer(std::span<unsigned char>) const;
+			std::size_t dimensione_binaria() const;
+			void read_scan(std::istream &);
+			static LidarDriver read_buffer(std::istream &);
+			static LidarDriver read_buffer(std::span<const unsigned char>);
 
 			// overloading operatori
 			void operator=(LidarDriver &&);
@@ -92,7 +410,14 @@ namespace lidar_driver {
 			// classi per lancio di errori
 			class NoGheSonVettoriError{}; // Eccezione "NoGheSonVettori" ("NoCiSonoVettori")
 			class ResolusionForaDaiRangeError{};
+			class ScalaForaDaiRangeError{};
+			class DimBufferForaDaiRangeError{};
+			class FileSbagliatoError{};
 			class AngoloForaDaiRangeError{};
+			class DimensionOutputSbagliataError{};
+			class FiltroSbagliatoError{};
+			class StatisticheSpenteError{};
+			class TimestampIndrioError{};
 
 		private:
 			// costanti private
@@ -101,18 +426,134 @@ namespace lidar_driver {
 			static constexpr int MAX_ANGLE{180};
 			static constexpr double MIN_RESOLUTION{0.1};
 			static constexpr double MAX_RESOLUTION{1};
+			static constexpr int BLOCCO_FUSIONE{128};	// misure per blocco nei kernel di fusione
+			static constexpr int MAX_RETE_MEDIANA{16};	// scansioni massime per la mediana vettorizzata
+			static constexpr int MAX_MISURE{static_cast<int>((MAX_ANGLE - MIN_ANGLE) / MIN_RESOLUTION + 1)};	// misure con MIN_RESOLUTION
+			static constexpr std::size_t ALLINEAMENTO_SLOT{64};	// allineamento degli slot (cache line)
 
 			// variabili private
-			std::vector<std::vector<double>> secia;	// BUFFER ("secia" = secchio)
+			std::vector<std::shared_ptr<unsigned char>> secia;	// BUFFER ("secia" = secchio): gli slot
+			std::pmr::memory_resource *risorsa;	// Risorsa da cui vengono allocati gli slot
+			MetricheLidar *metriche;	// Metriche delle operazioni (nullptr se non ci sono)
 			int elPiNovo;		// Indice all'ultimo vettore inserito ("elPiNovo" = ilPiùNuovo)
 			int elPiVecio;		// Indice al vettore da più tempo presente nel buffer ("elPiVecio" = ilPiùVecchio)
 			int dimension;		// Dimensione utilizzata del buffer
 			int dimScansioni;	// Dimensione dei vettori delle scansioni
 			double resolusion;	// Risoluzione angolare dello strumento
+			std::deque<unsigned long long> generazioni;	// Generazione di ogni slot (per le viste)
+			FormatoCampioni formato;	// Formato delle misure nel buffer
+			double scala;		// Scala delle misure (solo per UINT16)
+			int dimCampione;	// Byte occupati da una misura
+			int dimBuffer;		// Numero massimo di scansioni nel buffer
+			bool potenzaDi2;	// dimBuffer è una potenza di 2 (indici con la maschera)
+			unsigned long long scansioniInserite;	// Sequenza della prossima scansione
+			std::vector<long long> tempi;	// Timestamp di ogni slot (ns)
+			std::vector<unsigned long long> sequenze;	// Numero di sequenza di ogni slot
+			unsigned long long scansioniPerse;	// Scansioni sovrascritte prima di essere lette
+			std::shared_ptr<DiarioScansioni> diario;	// Diario su file (nullptr se non c'è)
+			Filtri filtri;		// Filtri applicati alle nuove scansioni
+			bool filtriAttivi;	// Almeno un filtro fa qualcosa
+			std::vector<double> lavoro;	// Spazio di lavoro dei filtri (allocato al primo uso)
+			std::shared_ptr<const TabellePunti> tabelle;	// Coseno e seno dell'angolo di ogni misura
+			bool statisticheAttive;	// new_scan calcola le statistiche
+			int misurePerSettore;	// Misure di ogni settore delle statistiche
+			int numeroSettori;		// Settori delle statistiche
+			std::vector<StatisticheScansione> statistiche;	// Statistiche di ogni slot (tutta + settori)
+
+			// funzioni private
+			unsigned char *prossimo_slot(long long, unsigned long long);
+			unsigned char *prossimo_slot() { return prossimo_slot(tempo_attuale(), scansioniInserite); }
+			static long long adesso();
+			long long tempo_attuale() const;
+			void controlla_tempo(long long) const;
+			[[noreturn]] static void lancia(ErroreLidar);
+			int primo_da(long long) const;
+			void registra(int);
+			const unsigned char *slot(int i) const { return secia[i].get(); }
+			unsigned char *slot_scrivibile(int);
+			std::shared_ptr<unsigned char> nuovo_slot() const;
+			int avanza(int i, int passi) const { return potenzaDi2 ? (i + passi) & (dimBuffer - 1) : (i + passi) % dimBuffer; }
+			static int dim_buffer_da_budget(double, BudgetMemoria, FormatoCampioni);
+			IntestazioneScansione intestazione_scansione(int) const;
+			IntestazioneBuffer intestazione_buffer() const;
+			void controlla_intestazione(const IntestazioneScansione &) const;
+			void leggi_misure(std::istream &, const IntestazioneScansione &);
+			void inserisci_misure(const unsigned char *, const IntestazioneScansione &);
+			static LidarDriver da_intestazione(const IntestazioneBuffer &);
+			void raccogli_distanze(const double *, double *, int) const;
+			void fondi(int, int, int, Fusione, double *) const;
+			static void mediana_righe(double (*)[BLOCCO_FUSIONE], int, int, const double *, double *);
+			void filtra(unsigned char *);
+			void calcola_tabelle();
+			void rinnova_generazioni();
+			void punti(const unsigned char *, double *, double *) const;
+			void calcola_statistiche(int);
+			double riassumi_settore(const double *, int, int, StatisticheScansione &) const;
 	};
 
 	// overloading operatore output
 	std::ostream &operator<<(std::ostream &, const LidarDriver &);
+
+	/* Funzione new_scan(It inizio, It fine):
+		- come new_scan(span), ma le misure arrivano da una qualsiasi coppia di iteratori (anche non
+		  contigui, es. std::list o istream_iterator), convertite e copiate una alla volta
+		  direttamente nello slot
+		- è un template, per cui deve stare nell'header
+	*/
+	template <typename It>
+	void LidarDriver::new_scan(It inizio, It fine) {
+		DURATA_LIDAR(OperazioneLidar::NEW_SCAN);
+		unsigned char *dest = prossimo_slot();
+		int i = 0;
+		for (; inizio != fine && i < dimScansioni; ++inizio, ++i) {
+			double misura = *inizio;
+			codifica_campioni(&misura, 1, dest + i * dimCampione, formato, scala);
+		}
+		METRICHE_LIDAR(conta(ContatoreLidar::COMPLETATE, i < dimScansioni));
+		METRICHE_LIDAR(conta(ContatoreLidar::TRONCATE, inizio != fine));
+		std::memset(dest + i * dimCampione, 0, (dimScansioni - i) * dimCampione);
+		filtra(dest);
+		calcola_statistiche(elPiNovo);
+		registra(elPiNovo);
+	}
+
+	/* Funzione for_each_scan(F f, int numeroThread):
+		1. fissa l'ordine del buffer (slot della più vecchia e numero di scansioni) all'inizio
+		2. chiama f(k, vista sulla k-esima scansione) per ogni k, dividendo le scansioni tra al massimo
+		   numeroThread thread del gruppo condiviso (compreso quello che chiama, 0 = tutti)
+		3. ritorna quando tutte le chiamate sono finite; se f lancia un'eccezione, le scansioni non
+		   ancora iniziate vengono saltate e l'eccezione viene rilanciata qui
+
+		Osservazioni:
+		1. f viene chiamata da più thread contemporaneamente, per cui deve essere thread-safe (per
+		   esempio scrivere solo nell'elemento k di un risultato)
+		2. le viste puntano direttamente agli slot: valgono come quelle di get_view, e valida() dice se
+		   nel frattempo lo slot è stato sovrascritto
+	*/
+	template <typename F>
+	void LidarDriver::for_each_scan(F f, int numeroThread) const {
+		int primo = elPiVecio;
+		auto perScansione = [&](int k) {
+			int i = avanza(primo, k);
+			f(k, VistaScansione(slot(i), dimScansioni, &generazioni[i], formato, scala));
+		};
+		GruppoThread::condiviso().per_ogni(dimension, perScansione, numeroThread);
+	}
+
+	/* Funzione transform_scans(F f, int numeroThread):
+		- come for_each_scan, ma restituisce un vettore con i risultati di f(k, vista) per ogni
+		  scansione del buffer, dalla più vecchia alla più nuova
+		- il tipo dei risultati deve avere un costruttore di default e non può essere bool, perché
+		  gli elementi di std::vector<bool> non si possono scrivere da thread diversi
+	*/
+	template <typename F>
+	auto LidarDriver::transform_scans(F f, int numeroThread) const {
+		using Risultato = std::invoke_result_t<F &, int, const VistaScansione &>;
+		static_assert(!std::is_same_v<Risultato, bool>, "transform_scans: usare char o int al posto di bool");
+		std::vector<Risultato> risultati(dimension);
+		for_each_scan([&](int k, const VistaScansione &v) { risultati[k] = f(k, v); }, numeroThread);
+		return risultati;
+	}
 }
 
 #endif // LIDARDRIVER_H
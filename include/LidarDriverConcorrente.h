@@ -0,0 +1,210 @@
+/*
+	FILE HEADER LIDARDRIVERCONCORRENTE.H
+
+	Variante di LidarDriver pensata per essere usata da due thread contemporaneamente senza mutex:
+	un thread produttore che inserisce le scansioni con new_scan e un thread consumatore che le
+	estrae con get_scan (single-producer/single-consumer).
+
+	Note sulla implementazione del buffer:
+	 - il buffer è sempre un vettore circolare di BUFFER_DIM scansioni, ma tutte le scansioni sono
+	   memorizzate una dopo l'altra in un unico vettore di double (slot i -> da i*dimScansioni)
+	 - al posto di elPiNovo/elPiVecio/dimension ci sono due contatori atomici che non si azzerano mai:
+	   - scritti -> numero di scansioni inserite dal produttore (lo scrive solo il produttore)
+	   - letti   -> numero di scansioni estratte dal consumatore (lo scrive solo il consumatore)
+	   lo slot di una scansione è dato dal suo numero modulo BUFFER_DIM e la dimensione occupata è
+	   scritti - letti (al massimo BUFFER_DIM)
+	 - come in LidarDriver, se il buffer è pieno la nuova scansione sovrascrive la più vecchia: il
+	   produttore non aspetta mai il consumatore (wait-free)
+	 - ogni slot ha un numero di sequenza (seqlock): il produttore lo rende dispari prima di scrivere
+	   lo slot e pari alla fine, il consumatore copia la scansione e controlla che il numero di
+	   sequenza non sia cambiato nel frattempo; se è cambiato la scansione è stata sovrascritta
+	   durante la lettura, viene contata come persa e si passa alla successiva
+	 - le letture e le scritture dei campioni avvengono con std::atomic_ref rilassati, così non ci
+	   sono data race anche quando produttore e consumatore lavorano sullo stesso slot
+	 - il consumatore può anche aspettare le scansioni invece di controllare continuamente il buffer:
+	   con wait_scan / wait_scans (bloccanti, con un tempo massimo), con subscribe (un thread che
+	   chiama una funzione per ogni scansione) o con co_await async_wait_scans (coroutine)
+	 - chi aspetta scrive in "soglia" il valore di scritti che lo deve svegliare (es. letti + N per
+	   essere svegliato ogni N scansioni, così il produttore non lo sveglia a ogni scansione) e poi
+	   dorme su una condition variable; il produttore, dopo aver pubblicato la scansione, confronta
+	   scritti con la soglia e prende il mutex solo se la soglia è raggiunta: se nessuno aspetta (soglia
+	   NESSUNA) new_scan non prende mai il mutex e paga solo una fence e la lettura della soglia
+	 - la fence seq_cst tra la pubblicazione di scritti e la lettura della soglia (e quella simmetrica
+	   di chi aspetta tra la scrittura della soglia e la lettura di scritti) garantisce che almeno uno
+	   dei due veda la scrittura dell'altro: o chi aspetta vede la scansione e non dorme, o il
+	   produttore vede la soglia e lo sveglia (nessuna sveglia persa)
+	 - c'è un solo consumatore, per cui aspetta al massimo uno alla volta (un thread in wait_scan,
+	   il thread di subscribe o una coroutine)
+	 - oltre al consumatore, ci possono essere quanti lettori si vuole (Lettore, es. un registratore,
+	   un costruttore di mappe e un controllo di sicurezza che hanno bisogno di tutte le scansioni):
+	   ogni lettore ha il suo cursore (come letti) e il suo contatore di scansioni perse, e legge le
+	   scansioni direttamente dagli slot di secia con lo stesso seqlock del consumatore, senza copiarle
+	   in code separate e senza mutex; leggere non rimuove niente, né per il consumatore né per gli
+	   altri lettori
+	 - il produttore non guarda i cursori dei lettori (come non guarda quello del consumatore): un
+	   lettore lento non lo rallenta mai, ma alla lettura successiva si accorge di quante scansioni
+	   sono state sovrascritte nel frattempo e le conta come perse (ritardo() dice quanto è indietro)
+
+	Costruttori:
+	- LidarDriverConcorrente(double) -> costruttore che riceve come parametro la risoluzione dello strumento
+	  (l'oggetto non è copiabile né spostabile, perché contiene variabili atomiche)
+
+	Funzioni membro:
+	- void new_scan(const std::vector<double> &) -> (solo produttore) inserisce nel buffer la scansione
+	- void new_scan(std::span<const double>)      -> come sopra, da qualsiasi sequenza contigua di double
+	- std::vector<double> get_scan()              -> (solo consumatore) restituisce e rimuove dal buffer la
+	                                                 scansione più vecchia
+	- void get_scan(std::vector<double> &)        -> come sopra, ma copia nel vettore passato (senza allocare
+	                                                 se ha già la dimensione giusta)
+	- bool try_get_scan(std::vector<double> &)    -> come sopra, ma restituisce false invece di lanciare
+	                                                 l'eccezione se non ci sono scansioni da leggere
+	- bool wait_scan(std::vector<double> &, std::chrono::nanoseconds)
+	                                              -> (solo consumatore) come try_get_scan, ma se il buffer è
+	                                                 vuoto aspetta una scansione per al massimo il tempo
+	                                                 indicato; false se non è arrivata
+	- int wait_scans(int, std::chrono::nanoseconds) -> (solo consumatore) aspetta che ci siano almeno N
+	                                                 scansioni da leggere, o che scada il tempo; restituisce
+	                                                 quante ce ne sono (senza leggerle)
+	- std::jthread subscribe(std::function<void(std::span<const double>)>, int = 1, std::chrono::nanoseconds = 0)
+	                                              -> (diventa il consumatore) crea un thread che chiama la
+	                                                 funzione per ogni nuova scansione, svegliandosi ogni N
+	                                                 scansioni o allo scadere dell'intervallo (0 = nessun
+	                                                 intervallo); il thread si ferma quando il std::jthread
+	                                                 restituito viene distrutto (prima del driver)
+	- AttesaScansioni async_wait_scans(int = 1)    -> (solo consumatore) con co_await sospende la coroutine
+	                                                 finché non ci sono almeno N scansioni da leggere e
+	                                                 restituisce quante ce ne sono; la coroutine riprende nel
+	                                                 thread produttore, dentro la new_scan che ha raggiunto
+	                                                 la soglia, per cui deve solo leggere le scansioni e
+	                                                 sospendersi di nuovo (o passare il lavoro a un altro
+	                                                 thread), senza tenere fermo il produttore
+	- int size() const                            -> numero di scansioni presenti nel buffer
+	- unsigned long long scansioni_perse() const  -> numero di scansioni sovrascritte prima di essere lette
+
+	Funzioni membro di Lettore (ognuna chiamata da un solo thread, quello del lettore, tranne ritardo
+	e scansioni_perse):
+	- Lettore(const LidarDriverConcorrente &)     -> crea un lettore che parte dalla prossima scansione
+	                                                 inserita (non copiabile: contiene variabili atomiche)
+	- bool try_get_scan(std::vector<double> &)    -> copia nel vettore la prossima scansione del lettore,
+	                                                 senza toglierla dal buffer; false se non ce ne sono
+	- int size() const                            -> scansioni nel buffer non ancora lette dal lettore
+	- unsigned long long ritardo() const          -> scansioni inserite non ancora lette dal lettore,
+	                                                 comprese quelle già sovrascritte
+	- unsigned long long scansioni_perse() const  -> scansioni sovrascritte prima che il lettore le leggesse
+	  (il lettore deve essere distrutto prima del driver)
+
+	Classi per lancio di eccezioni (le stesse di LidarDriver)
+	- NoGheSonVettoriError        -> lanciata da get_scan se il buffer è vuoto
+	- ResolusionForaDaiRangeError -> lanciata se la risoluzione passata al costruttore non è valida
+*/
+
+#ifndef LIDARDRIVERCONCORRENTE_H
+#define LIDARDRIVERCONCORRENTE_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <stop_token>
+#include <thread>
+#include <vector>
+#include "LidarDriver.h"
+
+namespace lidar_driver {
+	class LidarDriverConcorrente {
+		public:
+			// costruttori
+			LidarDriverConcorrente(double);
+			LidarDriverConcorrente(const LidarDriverConcorrente &) = delete;
+			LidarDriverConcorrente &operator=(const LidarDriverConcorrente &) = delete;
+
+			// member function
+			void new_scan(const std::vector<double> &);
+			void new_scan(std::span<const double>);
+			std::vector<double> get_scan();
+			void get_scan(std::vector<double> &);
+			bool try_get_scan(std::vector<double> &);
+			bool wait_scan(std::vector<double> &, std::chrono::nanoseconds);
+			int wait_scans(int, std::chrono::nanoseconds);
+			std::jthread subscribe(std::function<void(std::span<const double>)>, int = 1, std::chrono::nanoseconds = std::chrono::nanoseconds{0});
+			int size() const;
+
+			// oggetto restituito da async_wait_scans, da usare con co_await
+			class AttesaScansioni {
+				public:
+					AttesaScansioni(LidarDriverConcorrente &ld, int quante) : ld{ld}, quante{quante} {}
+					bool await_ready() const { return ld.size() >= ld.scansioni_da_aspettare(quante); }
+					bool await_suspend(std::coroutine_handle<> h) { return ld.sospendi(h, quante); }
+					int await_resume() const { return ld.size(); }
+
+				private:
+					LidarDriverConcorrente &ld;
+					int quante;
+			};
+			AttesaScansioni async_wait_scans(int quante = 1) { return AttesaScansioni(*this, quante); }
+
+			// lettore indipendente di tutte le scansioni (broadcast), su una cache line sua per non
+			// disturbare i lettori degli altri thread
+			class alignas(64) Lettore {
+				public:
+					Lettore(const LidarDriverConcorrente &);
+					Lettore(const Lettore &) = delete;
+					Lettore &operator=(const Lettore &) = delete;
+
+					bool try_get_scan(std::vector<double> &);
+					int size() const;
+					unsigned long long ritardo() const;
+					unsigned long long scansioni_perse() const;
+
+				private:
+					const LidarDriverConcorrente &ld;
+					std::atomic<unsigned long long> letti;	// scansioni lette (o perse) da questo lettore
+					std::atomic<unsigned long long> persi;	// scansioni perse da questo lettore
+			};
+			unsigned long long scansioni_perse() const;
+
+			// classi per lancio di errori (condivise con LidarDriver)
+			using NoGheSonVettoriError = LidarDriver::NoGheSonVettoriError;
+			using ResolusionForaDaiRangeError = LidarDriver::ResolusionForaDaiRangeError;
+
+		private:
+			// costanti private
+			static constexpr int BUFFER_DIM{10};
+			static constexpr int MIN_ANGLE{0};
+			static constexpr int MAX_ANGLE{180};
+			static constexpr double MIN_RESOLUTION{0.1};
+			static constexpr double MAX_RESOLUTION{1};
+			static constexpr int CACHE_LINE{64};
+			static constexpr unsigned long long NESSUNA{~0ULL};	// soglia quando nessuno aspetta
+
+			// variabili private
+			std::vector<double, AllocatoreAllineato<double>> secia;	// BUFFER: BUFFER_DIM scansioni una dopo l'altra
+			std::unique_ptr<std::atomic<unsigned long long>[]> sequenze; // seqlock di ogni slot
+			int dimScansioni;	// Dimensione dei vettori delle scansioni
+			double resolusion;	// Risoluzione angolare dello strumento
+
+			// contatori su cache line diverse per non far rimbalzare la linea tra i due thread
+			alignas(CACHE_LINE) std::atomic<unsigned long long> scritti;	// scritto solo dal produttore
+			alignas(CACHE_LINE) std::atomic<unsigned long long> letti;		// scritto solo dal consumatore
+			std::atomic<unsigned long long> persi;							// scritto solo dal consumatore
+
+			// attesa delle scansioni (vedi sopra): la soglia è letta dal produttore a ogni new_scan
+			alignas(CACHE_LINE) std::atomic<unsigned long long> soglia;	// valore di scritti che sveglia chi aspetta
+			std::mutex mutexAttesa;				// protegge l'addormentarsi e lo svegliarsi
+			std::condition_variable_any attesa;	// dove dorme chi aspetta (si può interrompere con un stop_token)
+			std::coroutine_handle<> coroutine;	// coroutine sospesa in async_wait_scans (protetta da mutexAttesa)
+
+			// funzioni private
+			bool leggi(std::atomic<unsigned long long> &, std::atomic<unsigned long long> &, std::vector<double> &) const;
+			int scansioni_da_aspettare(int) const;
+			int aspetta(int, std::chrono::nanoseconds, std::stop_token);
+			bool sospendi(std::coroutine_handle<>, int);
+			void sveglia(unsigned long long);
+	};
+}
+
+#endif // LIDARDRIVERCONCORRENTE_H
@@ -0,0 +1,198 @@
+/*
+	FILE HEADER LIDARDRIVERFISSO.H
+
+	Variante di LidarDriver in cui la risoluzione e la dimensione del buffer sono parametri template,
+	per i Lidar di cui si conosce la risoluzione già in fase di compilazione (es. 0.25°, 0.5°, 1°).
+
+	Rispetto a LidarDriver:
+	 - la dimensione delle scansioni DIM_SCANSIONI è una costante, per cui il buffer è uno
+	   std::array di DIM_BUFFER * DIM_SCANSIONI double dentro l'oggetto (nessuna allocazione)
+	 - la conversione angolo -> indice in get_distance divide per una costante: per le risoluzioni
+	   che sono potenze di 2 (0.25, 0.5, 1) il compilatore la trasforma in una moltiplicazione
+	 - i cicli di copia hanno lunghezza nota e il modulo sugli indici del buffer è per una costante
+	 - la risoluzione non valida è un errore di compilazione (static_assert) invece di un'eccezione
+	 - l'oggetto contiene tutto il buffer (es. 10 * 1801 * 8 byte = ~140 KB a 0.1°): con buffer grandi
+	   conviene allocarlo nell'heap (std::make_unique) invece che nello stack
+
+	Il comportamento (buffer circolare, sovrascrittura della più vecchia, troncamento e zeri nelle
+	scansioni della dimensione sbagliata, eccezioni) è lo stesso di LidarDriver, che rimane la classe
+	da usare quando la risoluzione si conosce solo a runtime.
+
+	Esempio:
+	- LidarDriverFisso<0.5> ld;       -> risoluzione 0.5°, buffer di 10 scansioni da 361 misure
+	- LidarDriverFisso<0.25, 16> ld;  -> risoluzione 0.25°, buffer di 16 scansioni da 721 misure
+
+	Funzioni membro (come in LidarDriver):
+	- void new_scan(const std::vector<double> &)
+	- std::vector<double> get_scan()
+	- std::vector<double> get_last() const
+	- VistaScansione get_last_view() const
+	- EsitoLidar<VistaScansione> try_get_last_view() const
+	- void clear_buffer()
+	- double get_distance(double) const
+	- EsitoLidar<double> try_get_distance(double) const
+	- std::ostream &operator<<(std::ostream &, const LidarDriverFisso &)
+*/
+
+#ifndef LIDARDRIVERFISSO_H
+#define LIDARDRIVERFISSO_H
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "EsitoLidar.h"
+#include "LidarDriver.h"
+#include "VistaScansione.h"
+
+namespace lidar_driver {
+	template <double RISOLUZIONE, int DIM_BUFFER = 10>
+	class LidarDriverFisso {
+		public:
+			// costanti pubbliche
+			static constexpr int MIN_ANGLE{0};
+			static constexpr int MAX_ANGLE{180};
+			static constexpr int DIM_SCANSIONI = static_cast<int>((MAX_ANGLE - MIN_ANGLE) / RISOLUZIONE) + 1;
+
+			static_assert(RISOLUZIONE >= 0.1 && RISOLUZIONE <= 1, "risoluzione fuori dal range [0.1, 1]");
+			static_assert(DIM_BUFFER > 0, "il buffer deve contenere almeno una scansione");
+
+			// classi per lancio di errori (condivise con LidarDriver)
+			using NoGheSonVettoriError = LidarDriver::NoGheSonVettoriError;
+			using AngoloForaDaiRangeError = LidarDriver::AngoloForaDaiRangeError;
+
+			/* Funzione new_scan(const vector<double> &v):
+				- copia la scansione nel prossimo slot, troncandola o completandola con zeri
+				- se il buffer è pieno sovrascrive la scansione più vecchia
+			*/
+			void new_scan(const std::vector<double> &v) {
+				elPiNovo = (dimension == 0) ? elPiNovo : (elPiNovo + 1) % DIM_BUFFER;
+
+				double *slot = secia.data() + elPiNovo * DIM_SCANSIONI;
+				int daCopiare = (v.size() < DIM_SCANSIONI) ? v.size() : DIM_SCANSIONI;
+				std::copy_n(v.begin(), daCopiare, slot);
+				std::fill(slot + daCopiare, slot + DIM_SCANSIONI, 0.0);
+				generazioni[elPiNovo]++;
+
+				elPiVecio = (dimension == DIM_BUFFER) ? (elPiVecio + 1) % DIM_BUFFER : elPiVecio;
+				dimension = (dimension == DIM_BUFFER) ? DIM_BUFFER : dimension + 1;
+			}
+
+			/* Funzione get_scan():
+				- restituisce e rimuove dal buffer la scansione più vecchia
+			*/
+			std::vector<double> get_scan() {
+				if (dimension == 0)
+					throw NoGheSonVettoriError();
+
+				dimension--;
+				int scoase = elPiVecio;
+				elPiVecio = (dimension != 0) ? (elPiVecio + 1) % DIM_BUFFER : elPiVecio;
+				return std::vector<double>(secia.begin() + scoase * DIM_SCANSIONI, secia.begin() + (scoase + 1) * DIM_SCANSIONI);
+			}
+
+			/* Funzione get_last():
+				- restituisce senza rimuoverla una copia dell'ultima scansione inserita
+			*/
+			std::vector<double> get_last() const {
+				if (dimension == 0)
+					throw NoGheSonVettoriError();
+
+				return std::vector<double>(secia.begin() + elPiNovo * DIM_SCANSIONI, secia.begin() + (elPiNovo + 1) * DIM_SCANSIONI);
+			}
+
+			/* Funzione get_last_view():
+				- restituisce una vista (senza copia) sull'ultima scansione inserita
+			*/
+			VistaScansione get_last_view() const {
+				if (dimension == 0)
+					throw NoGheSonVettoriError();
+
+				return VistaScansione(secia.data() + elPiNovo * DIM_SCANSIONI, DIM_SCANSIONI, &generazioni[elPiNovo]);
+			}
+
+			/* Funzione try_get_last_view():
+				- come get_last_view, ma se il buffer è vuoto restituisce l'errore BUFFER_VUOTO
+			*/
+			EsitoLidar<VistaScansione> try_get_last_view() const noexcept {
+				if (dimension == 0)
+					return ErroreLidar::BUFFER_VUOTO;
+
+				return VistaScansione(secia.data() + elPiNovo * DIM_SCANSIONI, DIM_SCANSIONI, &generazioni[elPiNovo]);
+			}
+
+			/* Funzione clear_buffer():
+				- reimposta indici e dimensione e invalida le viste, i dati rimangono dove sono
+			*/
+			void clear_buffer() {
+				elPiNovo = elPiVecio = dimension = 0;
+				for (unsigned long long &g : generazioni)
+					g++;
+			}
+
+			/* Funzione get_distance(double):
+				- restituisce la misura dell'ultima scansione per l'angolo più vicino a quello passato
+				- l'indice è angolo / RISOLUZIONE arrotondato, con RISOLUZIONE costante di compilazione
+			*/
+			double get_distance(double angolo) const {
+				if (dimension == 0)
+					throw NoGheSonVettoriError();
+				if (!(angolo >= MIN_ANGLE && angolo <= MAX_ANGLE))	// vero anche per NaN
+					throw AngoloForaDaiRangeError();
+
+				int index = static_cast<int>(std::round(angolo / RISOLUZIONE));
+				if (index >= DIM_SCANSIONI)
+					index = DIM_SCANSIONI - 1;
+				return secia[elPiNovo * DIM_SCANSIONI + index];
+			}
+
+			/* Funzione try_get_distance(double):
+				- come get_distance, ma restituisce l'errore (BUFFER_VUOTO o ANGOLO_FORA_DAI_RANGE, anche
+				  per un angolo NaN) invece di lanciare un'eccezione
+			*/
+			EsitoLidar<double> try_get_distance(double angolo) const noexcept {
+				if (dimension == 0)
+					return ErroreLidar::BUFFER_VUOTO;
+				if (!(angolo >= MIN_ANGLE && angolo <= MAX_ANGLE))
+					return ErroreLidar::ANGOLO_FORA_DAI_RANGE;
+
+				int index = static_cast<int>(std::round(angolo / RISOLUZIONE));
+				if (index >= DIM_SCANSIONI)
+					index = DIM_SCANSIONI - 1;
+				return secia[elPiNovo * DIM_SCANSIONI + index];
+			}
+
+		private:
+			// variabili private (copia e move generati dal compilatore copiano l'array)
+			alignas(64) std::array<double, DIM_BUFFER * DIM_SCANSIONI> secia{};	// BUFFER
+			std::array<unsigned long long, DIM_BUFFER> generazioni{};	// Generazione di ogni slot
+			int elPiNovo{0};	// Indice all'ultimo vettore inserito
+			int elPiVecio{0};	// Indice al vettore da più tempo presente nel buffer
+			int dimension{0};	// Dimensione utilizzata del buffer
+	};
+
+	/* Overloading dell'operatore <<
+		- stampa l'ultima scansione inserita con lo stesso formato di LidarDriver
+	*/
+	template <double RISOLUZIONE, int DIM_BUFFER>
+	std::ostream &operator<<(std::ostream &os, const LidarDriverFisso<RISOLUZIONE, DIM_BUFFER> &ld) {
+		EsitoLidar<VistaScansione> esito = ld.try_get_last_view();
+		if (!esito)
+			return os << "{ }\n";
+
+		const VistaScansione &temp = *esito;
+		std::string s = "{ ";
+		for (int i = 0; i < temp.size(); i++) {
+			s += std::to_string(temp[i]);
+			if (i < temp.size() - 1)
+				s += ", ";
+		}
+		s += " }\n";
+
+		return os << s;
+	}
+}
+
+#endif // LIDARDRIVERFISSO_H
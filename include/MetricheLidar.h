@@ -0,0 +1,156 @@
+/*
+	FILE HEADER METRICHELIDAR.H
+
+	Metriche (contatori e istogrammi delle durate) delle operazioni principali di un LidarDriver,
+	per vedere come si comporta sotto carico: quante scansioni non lette vengono sovrascritte,
+	quante vengono completate con zeri o troncate, quante eccezioni lanciano le letture e quanto
+	dura ogni chiamata.
+
+	Le metriche si attivano in compilazione, con -DLIDAR_METRICHE (es. "make OPZIONI=-DLIDAR_METRICHE"),
+	e poi per ogni driver con LidarDriver::set_metriche(&metriche):
+	 - senza LIDAR_METRICHE le istruzioni che aggiornano le metriche (le macro METRICHE_LIDAR e
+	   DURATA_LIDAR qui sotto) spariscono dal codice del driver, per cui non costano niente; il
+	   puntatore alle metriche resta nel driver (così la classe ha la stessa forma con e senza
+	   l'opzione) ma non viene mai letto
+	 - con LIDAR_METRICHE, un driver senza metriche collegate paga solo il controllo del puntatore
+
+	Note sulla implementazione:
+	 - tutti i valori sono std::atomic aggiornati con memory_order_relaxed: più driver (anche in thread
+	   diversi) possono usare le stesse metriche, e istantanea() si può chiamare da un altro thread
+	   mentre il driver lavora (i valori letti non sono una fotografia "atomica" di tutto, ma ognuno è
+	   corretto e nessuno torna mai indietro)
+	 - gli istogrammi hanno secchi con limiti che raddoppiano da 16 ns a circa 67 ms (più un secchio
+	   per le durate più lunghe): trovare il secchio costa un'istruzione (std::bit_width)
+	 - le metriche sono allineate alla cache line, così quelle di driver diversi non si disturbano
+	 - scrivi_prometheus scrive un'istantanea nel formato di testo di Prometheus (contatori con il
+	   suffisso _total, istogrammi con i secchi cumulativi, _sum e _count), con le etichette indicate
+	   (es. sensore="2") in tutte le serie
+
+	Tipi:
+	- enum class OperazioneLidar { NEW_SCAN, GET_SCAN, GET_LAST, GET_DISTANCE } -> operazioni misurate
+	- enum class ContatoreLidar { INSERITE, SOVRASCRITTE, COMPLETATE, TRONCATE } -> eventi contati
+	- struct IstantaneaMetriche -> valori delle metriche in un certo istante (non atomici)
+	- struct SerieMetriche      -> istantanea con le sue etichette, per scrivere più driver insieme
+
+	Funzioni membro di MetricheLidar:
+	- void conta(ContatoreLidar, std::uint64_t = 1)   -> aggiunge al contatore indicato
+	- void conta_errore(OperazioneLidar)              -> conta un'eccezione lanciata dall'operazione
+	- void registra_durata(OperazioneLidar, std::uint64_t) -> aggiunge una durata (ns) all'istogramma
+	- IstantaneaMetriche istantanea() const           -> legge tutti i valori
+	- void azzera()                                   -> rimette tutto a zero
+
+	Funzioni:
+	- void scrivi_prometheus(std::ostream &, const IstantaneaMetriche &, const std::string & = "")
+	- void scrivi_prometheus(std::ostream &, std::span<const SerieMetriche>)
+	                                   -> scrivono una o più istantanee nel formato di testo di Prometheus
+	- const char *nome_operazione(OperazioneLidar) -> nome dell'operazione nelle etichette
+*/
+
+#ifndef METRICHELIDAR_H
+#define METRICHELIDAR_H
+
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <span>
+#include <string>
+
+namespace lidar_driver {
+	enum class OperazioneLidar { NEW_SCAN, GET_SCAN, GET_LAST, GET_DISTANCE };
+	enum class ContatoreLidar { INSERITE, SOVRASCRITTE, COMPLETATE, TRONCATE };
+
+	inline constexpr int NUMERO_OPERAZIONI{4};
+	inline constexpr int NUMERO_CONTATORI{4};
+	inline constexpr int NUMERO_SECCHI{24};		// 23 limiti (16 ns << i) più il secchio +Inf
+	inline constexpr std::uint64_t PRIMO_LIMITE_NS{16};
+
+	struct IstantaneaMetriche {
+		std::uint64_t contatori[NUMERO_CONTATORI]{};
+		struct Operazione {
+			std::uint64_t errori{0};
+			std::uint64_t chiamate{0};
+			std::uint64_t sommaNs{0};
+			std::uint64_t secchi[NUMERO_SECCHI]{};	// non cumulativi: durate tra il limite precedente e questo
+		} operazioni[NUMERO_OPERAZIONI];
+
+		std::uint64_t operator[](ContatoreLidar c) const { return contatori[static_cast<int>(c)]; }
+		const Operazione &operator[](OperazioneLidar o) const { return operazioni[static_cast<int>(o)]; }
+	};
+
+	struct SerieMetriche {
+		std::string etichette;		// es. sensore="2" (senza graffe), vuota se non ce ne sono
+		IstantaneaMetriche valori;
+	};
+
+	class alignas(64) MetricheLidar {
+		public:
+			void conta(ContatoreLidar c, std::uint64_t quanti = 1) {
+				contatori[static_cast<int>(c)].fetch_add(quanti, std::memory_order_relaxed);
+			}
+			void conta_errore(OperazioneLidar o) {
+				operazioni[static_cast<int>(o)].errori.fetch_add(1, std::memory_order_relaxed);
+			}
+			void registra_durata(OperazioneLidar o, std::uint64_t ns) {
+				Operazione &op = operazioni[static_cast<int>(o)];
+				int secchio = (ns <= PRIMO_LIMITE_NS) ? 0 : std::bit_width((ns - 1) / PRIMO_LIMITE_NS);
+				op.secchi[(secchio < NUMERO_SECCHI - 1) ? secchio : NUMERO_SECCHI - 1].fetch_add(1, std::memory_order_relaxed);
+				op.sommaNs.fetch_add(ns, std::memory_order_relaxed);
+				op.chiamate.fetch_add(1, std::memory_order_relaxed);
+			}
+			IstantaneaMetriche istantanea() const;
+			void azzera();
+
+		private:
+			struct Operazione {
+				std::atomic<std::uint64_t> errori{0};
+				std::atomic<std::uint64_t> chiamate{0};
+				std::atomic<std::uint64_t> sommaNs{0};
+				std::atomic<std::uint64_t> secchi[NUMERO_SECCHI]{};
+			};
+			std::atomic<std::uint64_t> contatori[NUMERO_CONTATORI]{};
+			Operazione operazioni[NUMERO_OPERAZIONI];
+	};
+
+	/* Classe CronometroMetriche:
+		- misura la durata di un'operazione dalla costruzione alla distruzione (anche se l'operazione
+		  lancia un'eccezione) e la registra nelle metriche; con metriche nullptr non fa niente
+	*/
+	class CronometroMetriche {
+		public:
+			CronometroMetriche(MetricheLidar *metriche, OperazioneLidar operazione)
+				: metriche{metriche}, operazione{operazione} {
+				if (metriche)
+					inizio = std::chrono::steady_clock::now();
+			}
+			CronometroMetriche(const CronometroMetriche &) = delete;
+			CronometroMetriche &operator=(const CronometroMetriche &) = delete;
+			~CronometroMetriche() {
+				if (metriche)
+					metriche->registra_durata(operazione, std::chrono::duration_cast<std::chrono::nanoseconds>(
+						std::chrono::steady_clock::now() - inizio).count());
+			}
+
+		private:
+			MetricheLidar *metriche;
+			OperazioneLidar operazione;
+			std::chrono::steady_clock::time_point inizio;
+	};
+
+	const char *nome_operazione(OperazioneLidar);
+	void scrivi_prometheus(std::ostream &, const IstantaneaMetriche &, const std::string & = "");
+	void scrivi_prometheus(std::ostream &, std::span<const SerieMetriche>);
+}
+
+// istruzioni delle metriche nelle funzioni del driver (che ha il membro "metriche"): senza
+// LIDAR_METRICHE non generano codice
+#ifdef LIDAR_METRICHE
+#define METRICHE_LIDAR(istruzione) do { if (metriche) metriche->istruzione; } while (0)
+#define DURATA_LIDAR(operazione) CronometroMetriche cronometroMetriche(metriche, operazione)
+#else
+#define METRICHE_LIDAR(istruzione) do {} while (0)
+#define DURATA_LIDAR(operazione) do {} while (0)
+#endif
+
+#endif // METRICHELIDAR_H
@@ -0,0 +1,82 @@
+/*
+	FILE HEADER RISERVASLOT.H
+
+	Riserva (pool) di blocchi di memoria per gli slot delle scansioni, da condividere tra più
+	LidarDriver (vedi LidarDriver::set_risorsa). È una std::pmr::memory_resource, per cui si può usare
+	anche con i contenitori std::pmr.
+
+	Note sulla implementazione:
+	 - i blocchi sono divisi per dimensione (arrotondata a ALLINEAMENTO byte) e ogni dimensione ha la
+	   sua lista di blocchi liberi; di solito le dimensioni sono due, quella degli slot e quella dei
+	   blocchi di controllo degli std::shared_ptr che li possiedono
+	 - un blocco restituito con deallocate torna nella sua lista e viene riusato dalla prossima
+	   allocate della stessa dimensione: la memoria torna alla risorsa "a monte" solo quando la
+	   riserva viene distrutta, per cui, una volta riservati abbastanza blocchi, i driver non
+	   toccano più l'heap
+	 - se una lista è vuota il blocco viene chiesto alla risorsa a monte (e contato), così la riserva
+	   non fallisce mai se i blocchi riservati non bastano, si allarga
+	 - le liste sono protette da un mutex, per cui la riserva può essere usata da driver in thread
+	   diversi (per esempio quelli di una FlottaLidar)
+	 - tutti i blocchi sono allineati ad almeno ALLINEAMENTO byte (una cache line)
+
+	Costruttori:
+	- RiservaSlot(std::pmr::memory_resource * = std::pmr::new_delete_resource())
+	                             -> riserva vuota che prende la memoria dalla risorsa indicata
+	  (l'oggetto non è copiabile; deve vivere più a lungo di tutti i driver e le copie che la usano)
+	- ~RiservaSlot()             -> restituisce tutti i blocchi alla risorsa a monte
+
+	Funzioni membro:
+	- void riserva(std::size_t, int)  -> alloca subito il numero indicato di blocchi di quella dimensione
+	                                     (per riservare degli slot per le scansioni di un driver, con i loro
+	                                     blocchi di controllo, si usa LidarDriver::set_risorsa)
+	- int blocchi_liberi() const      -> blocchi pronti per essere riusati
+	- std::size_t allocazioni_a_monte() const -> blocchi chiesti finora alla risorsa a monte
+*/
+
+#ifndef RISERVASLOT_H
+#define RISERVASLOT_H
+
+#include <cstddef>
+#include <memory_resource>
+#include <mutex>
+#include <vector>
+
+namespace lidar_driver {
+	class RiservaSlot : public std::pmr::memory_resource {
+		public:
+			// costruttori e distruttori
+			RiservaSlot(std::pmr::memory_resource * = std::pmr::new_delete_resource());
+			RiservaSlot(const RiservaSlot &) = delete;
+			RiservaSlot &operator=(const RiservaSlot &) = delete;
+			~RiservaSlot();
+
+			// member function
+			void riserva(std::size_t, int);
+			int blocchi_liberi() const;
+			std::size_t allocazioni_a_monte() const;
+
+		private:
+			// costanti private
+			static constexpr std::size_t ALLINEAMENTO{64};
+
+			// blocchi liberi di una dimensione
+			struct Lista {
+				std::size_t dimensione;
+				std::vector<void *> liberi;
+			};
+
+			// variabili private
+			std::pmr::memory_resource *aMonte;	// da dove arriva la memoria
+			std::vector<Lista> liste;			// una lista per dimensione
+			std::size_t allocazioni;			// blocchi chiesti a aMonte
+			mutable std::mutex mutex;			// protegge liste e allocazioni
+
+			// funzioni private
+			Lista &lista(std::size_t);
+			void *do_allocate(std::size_t, std::size_t) override;
+			void do_deallocate(void *, std::size_t, std::size_t) override;
+			bool do_is_equal(const std::pmr::memory_resource &) const noexcept override;
+	};
+}
+
+#endif // RISERVASLOT_H
@@ -0,0 +1,105 @@
+/*
+	FILE HEADER VISTASCANSIONE.H
+
+	Vista (non proprietaria) su una scansione memorizzata nel buffer di un LidarDriver: non copia i
+	dati, ma contiene solo un puntatore all'inizio dello slot e la sua dimensione.
+
+	Siccome lo slot puntato può essere sovrascritto da una new_scan successiva, ogni slot del buffer
+	ha un numero di generazione che viene incrementato a ogni scrittura: la vista si ricorda la
+	generazione dello slot nel momento in cui è stata creata e con valida() si può verificare se i
+	dati puntati sono ancora quelli della scansione originale.
+
+	Osservazioni:
+	- la vista punta alla memoria del LidarDriver da cui è stata ottenuta: non va usata dopo che
+	  l'oggetto è stato distrutto (dopo una move segue invece i dati nell'oggetto di destinazione)
+	- valida() va controllata DOPO aver letto i dati se nel frattempo si sono fatte altre operazioni
+	  sul LidarDriver; operator[] e span() non fanno controlli per non pesare sul caso normale
+	- se il buffer memorizza le misure in un formato compatto (FLOAT o UINT16) operator[] converte
+	  la misura in double al volo, e così anche gli iteratori di begin() ed end(); data() e span()
+	  danno invece accesso diretto ai double e con gli altri formati restituiscono nullptr e uno
+	  span vuoto (le misure compatte vanno lette con operator[], gli iteratori o copia_in)
+
+	Funzioni membro:
+	- int size() const                    -> numero di misure della scansione
+	- FormatoCampioni formato() const     -> formato in cui sono memorizzate le misure
+	- double operator[](int) const        -> misura i-esima (convertita in double)
+	- const double *data() const          -> puntatore alla prima misura (nullptr se non DOUBLE)
+	- begin(), end()                      -> iteratori (convertono in double) per i cicli range-for
+	- std::span<const double> span() const -> la stessa vista come std::span (vuoto se non DOUBLE)
+	- void copia_in(double *) const       -> copia le misure (convertite in double) nell'array passato
+	- bool valida() const                 -> true se lo slot non è stato sovrascritto
+*/
+
+#ifndef VISTASCANSIONE_H
+#define VISTASCANSIONE_H
+
+#include <cstddef>
+#include <iterator>
+#include <span>
+#include "FormatoCampioni.h"
+
+namespace lidar_driver {
+	class VistaScansione {
+		public:
+			// iteratore di sola lettura che converte le misure come operator[]
+			class Iteratore {
+				public:
+					using iterator_category = std::input_iterator_tag;
+					using value_type = double;
+					using difference_type = std::ptrdiff_t;
+					using pointer = void;
+					using reference = double;
+
+					Iteratore() = default;
+					Iteratore(const VistaScansione *vista, int i) : vista{vista}, i{i} {}
+
+					double operator*() const { return (*vista)[i]; }
+					Iteratore &operator++() { i++; return *this; }
+					Iteratore operator++(int) { Iteratore prima = *this; i++; return prima; }
+					bool operator==(const Iteratore &altro) const { return i == altro.i; }
+
+				private:
+					const VistaScansione *vista = nullptr;
+					int i = 0;
+			};
+
+			VistaScansione(const void *dati, int dim, const unsigned long long *generazioneSlot,
+			               FormatoCampioni formato = FormatoCampioni::DOUBLE, double scala = 1)
+				: dati{static_cast<const unsigned char *>(dati)}, dim{dim}, generazioneSlot{generazioneSlot},
+				  generazione{*generazioneSlot}, formatoCampioni{formato}, scala{scala} {}
+
+			int size() const { return dim; }
+			FormatoCampioni formato() const { return formatoCampioni; }
+			double operator[](int i) const {
+				return (formatoCampioni == FormatoCampioni::DOUBLE) ? reinterpret_cast<const double *>(dati)[i]
+				                                                    : leggi_campione(dati, i, formatoCampioni, scala);
+			}
+
+			Iteratore begin() const { return {this, 0}; }
+			Iteratore end() const { return {this, dim}; }
+
+			// accesso diretto ai double: solo per il formato DOUBLE, altrimenti nullptr e span vuoto
+			const double *data() const {
+				return (formatoCampioni == FormatoCampioni::DOUBLE) ? reinterpret_cast<const double *>(dati) : nullptr;
+			}
+			std::span<const double> span() const {
+				return (formatoCampioni == FormatoCampioni::DOUBLE) ? std::span<const double>{data(), static_cast<std::size_t>(dim)}
+				                                                    : std::span<const double>{};
+			}
+
+			// copia tutte le misure (convertite in double) nell'array puntato da out
+			void copia_in(double *out) const { decodifica_campioni(dati, dim, out, formatoCampioni, scala); }
+
+			bool valida() const { return *generazioneSlot == generazione; }
+
+		private:
+			const unsigned char *dati;				// inizio dello slot nel buffer
+			int dim;								// numero di misure della scansione
+			const unsigned long long *generazioneSlot;	// generazione attuale dello slot
+			unsigned long long generazione;			// generazione dello slot alla creazione della vista
+			FormatoCampioni formatoCampioni;		// formato delle misure nello slot
+			double scala;							// scala delle misure (solo per UINT16)
+	};
+}
+
+#endif // VISTASCANSIONE_H
@@ -0,0 +1,374 @@
+/*
+	FILE IMPLEMENTAZIONI DIARIOSCANSIONI.CPP
+
+	Vengono implementate le funzioni della libreria DiarioScansioni.h
+*/
+
+#include "../include/DiarioScansioni.h"
+#include <atomic>  // per std::atomic_ref sui progressivi dei record
+#include <climits> // per ULLONG_MAX nella funzione aggiorna
+#include <cstring> // per std::memcpy e std::memcmp
+#include <fcntl.h>    // per open
+#include <sys/mman.h> // per mmap, munmap e msync
+#include <sys/stat.h> // per fstat
+#include <unistd.h>   // per ftruncate e close
+
+namespace lidar_driver {
+	/* Costruttore in scrittura:
+		1. verifica il numero di record e calcola la dimensione di ogni record (intestazione del
+		   record e della scansione + misure, arrotondata a 64 byte)
+		2. apre (o crea) e mappa il file: se è nuovo ci scrive l'intestazione del diario, altrimenti
+		   verifica che abbia gli stessi parametri, altrimenti viene lanciata "FileSbagliatoError"
+		3. con aggiorna ricostruisce gli indici dai record già presenti, così dopo un crash si
+		   continua a scrivere dopo il record più nuovo
+	*/
+	DiarioScansioni::DiarioScansioni(const std::string &percorso, int numeroRecord, double resolusion,
+	                                 int dimScansioni, FormatoCampioni formato, double scala) {
+		if (numeroRecord < 1)
+			throw DimBufferForaDaiRangeError();
+
+		parametri = IntestazioneDiario{};
+		std::memcpy(parametri.magia, MAGIA_DIARIO, sizeof(MAGIA_DIARIO));
+		parametri.versione = VERSIONE_DIARIO;
+		parametri.formato = static_cast<std::uint8_t>(formato);
+		parametri.dimScansioni = dimScansioni;
+		parametri.numeroRecord = numeroRecord;
+		parametri.resolusion = resolusion;
+		parametri.scala = scala;
+		parametri.dimRecord = (sizeof(IntestazioneRecord) + sizeof(IntestazioneScansione)
+		                       + dimScansioni * dimensione_campione(formato) + 63) / 64 * 64;
+
+		std::size_t dimFile = INIZIO_RECORD_DIARIO + static_cast<std::size_t>(numeroRecord) * parametri.dimRecord;
+		scrivibile = true;
+		if (mappa_file(percorso, true, dimFile)) {
+			// file nuovo (tutto a zero): si scrive l'intestazione e la si porta subito su disco
+			std::memcpy(mappa, &parametri, sizeof(parametri));
+			msync(mappa, INIZIO_RECORD_DIARIO, MS_SYNC);
+		}
+		else if (dimMappa != dimFile || std::memcmp(mappa, &parametri, sizeof(parametri)) != 0) {
+			chiudi();
+			throw FileSbagliatoError();
+		}
+
+		aggiorna();
+	}
+
+	/* Costruttore in sola lettura:
+		1. apre e mappa il file in sola lettura
+		2. legge l'intestazione del diario e verifica che sia valida e che il file contenga tutti i
+		   record, altrimenti viene lanciata "FileSbagliatoError"
+		3. con aggiorna ricostruisce gli indici dai record presenti
+	*/
+	DiarioScansioni::DiarioScansioni(const std::string &percorso) {
+		scrivibile = false;
+		mappa_file(percorso, false, 0);
+
+		std::memcpy(&parametri, mappa, sizeof(parametri));
+		std::size_t dimMinimaRecord = sizeof(IntestazioneRecord) + sizeof(IntestazioneScansione)
+			+ static_cast<std::size_t>(parametri.dimScansioni) * dimensione_campione(static_cast<FormatoCampioni>(parametri.formato));
+		if (std::memcmp(parametri.magia, MAGIA_DIARIO, sizeof(MAGIA_DIARIO)) != 0
+			|| parametri.versione != VERSIONE_DIARIO
+			|| parametri.formato > static_cast<std::uint8_t>(FormatoCampioni::UINT16)
+			|| parametri.numeroRecord < 1
+			|| parametri.dimRecord < dimMinimaRecord || parametri.dimRecord % 64 != 0
+			|| dimMappa < INIZIO_RECORD_DIARIO + static_cast<std::size_t>(parametri.numeroRecord) * parametri.dimRecord) {
+			chiudi();
+			throw FileSbagliatoError();
+		}
+
+		aggiorna();
+	}
+
+	/* Distruttore:
+		- toglie la mappatura e chiude il file (le pagine modificate vengono comunque scritte su
+		  disco dal kernel)
+	*/
+	DiarioScansioni::~DiarioScansioni() {
+		chiudi();
+	}
+
+	/* Funzione scrivi(const unsigned char *misure, int dimScansioni, FormatoCampioni formato,
+	                   long long timestamp, unsigned long long sequenza):
+		1. il record da scrivere è quello dopo il più nuovo (il primo se il diario è vuoto): se il
+		   diario è pieno è il più vecchio, che viene sovrascritto
+		2. il progressivo del record viene messo a 0, così se il processo si interrompe durante la
+		   scrittura il record risulta non valido
+		3. vengono copiate le misure (dimScansioni misure già nel formato del diario) e poi
+		   l'intestazione della scansione, con timestamp e sequenza che la scansione ha nel driver
+		   (come in write_scan); il progressivo viene scritto per ultimo con un rilascio atomico,
+		   così chi lo legge con un'acquisizione vede anche tutto il resto del record
+		4. aggiorna gli indici come prossimo_slot di LidarDriver
+
+		Osservazioni:
+		1. se il diario è aperto in sola lettura viene lanciata l'eccezione "FileSbagliatoError"
+		2. numero di misure e formato della scansione passata devono essere quelli del diario (ad
+		   esempio se il driver è cambiato dopo l'apertura del diario), altrimenti viene lanciata
+		   "FileSbagliatoError": la copia leggerebbe più (o meno) byte di quelli della scansione
+	*/
+	void DiarioScansioni::scrivi(const unsigned char *misure, int dimScansioni, FormatoCampioni formato,
+	                             long long timestamp, unsigned long long sequenza) {
+		if (!scrivibile || dimScansioni != get_dim_scansioni() || formato != get_formato())
+			throw FileSbagliatoError();
+
+		int i = (dimension == 0) ? elPiNovo : avanza(elPiNovo, 1);
+		std::atomic_ref<std::uint64_t> progressivo(testa_record(i)->progressivo);
+		generazioni[i]++;
+
+		progressivo.store(0, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+
+		std::memcpy(misure_record(i), misure, parametri.dimScansioni * dimensione_campione(get_formato()));
+
+		IntestazioneScansione nuova{};
+		std::memcpy(nuova.magia, MAGIA_SCANSIONE, sizeof(MAGIA_SCANSIONE));
+		nuova.versione = VERSIONE_FORMATO;
+		nuova.formato = parametri.formato;
+		nuova.dimScansioni = parametri.dimScansioni;
+		nuova.resolusion = parametri.resolusion;
+		nuova.scala = parametri.scala;
+		nuova.sequenza = sequenza;
+		nuova.timestamp = timestamp;
+		std::memcpy(intestazione_record(i), &nuova, sizeof(nuova));
+		progressivo.store(++ultimoProgressivo, std::memory_order_release);
+
+		elPiNovo = i;
+		elPiVecio = (dimension == static_cast<int>(parametri.numeroRecord)) ? avanza(elPiVecio, 1) : elPiVecio;
+		dimension = (dimension == static_cast<int>(parametri.numeroRecord)) ? dimension : dimension + 1;
+	}
+
+	/* Funzione aggiorna():
+		1. legge il progressivo di tutti i record (solo le intestazioni, non le misure): i record con
+		   progressivo 0 o senza la firma di una scansione sono vuoti o scritti a metà e vengono saltati
+		2. il record più nuovo è quello con il progressivo più grande, il più vecchio quello con il più
+		   piccolo; i record validi sono quelli tra i due (girando in fondo al file)
+
+		Osservazioni:
+		- un record scritto a metà può essere solo quello dopo il più nuovo, per cui non finisce mai
+		  tra il più vecchio e il più nuovo
+		- le viste ottenute prima della chiamata restano valide (la mappatura non cambia)
+	*/
+	void DiarioScansioni::aggiorna() {
+		int numeroRecord = parametri.numeroRecord;
+		unsigned long long minima = ULLONG_MAX;
+		generazioni.resize(numeroRecord);
+		elPiNovo = elPiVecio = dimension = 0;
+		ultimoProgressivo = 0;
+
+		for (int i = 0; i < numeroRecord; i++) {
+			unsigned long long progressivo = std::atomic_ref<std::uint64_t>(testa_record(i)->progressivo).load(std::memory_order_acquire);
+			if (progressivo == 0 || std::memcmp(intestazione_record(i)->magia, MAGIA_SCANSIONE, sizeof(MAGIA_SCANSIONE)) != 0)
+				continue;
+			if (progressivo > ultimoProgressivo) {
+				ultimoProgressivo = progressivo;
+				elPiNovo = i;
+			}
+			if (progressivo < minima) {
+				minima = progressivo;
+				elPiVecio = i;
+			}
+		}
+
+		if (ultimoProgressivo != 0)
+			dimension = (elPiNovo - elPiVecio + numeroRecord) % numeroRecord + 1;
+	}
+
+	/* Funzione sincronizza():
+		- scrive su disco le pagine modificate del file e aspetta che la scrittura sia completata
+		- i record sopravvivono al crash del processo anche senza, serve per lo spegnimento della
+		  macchina (es. da chiamare ogni tanto, non a ogni scansione perché è lenta)
+	*/
+	void DiarioScansioni::sincronizza() {
+		if (scrivibile)
+			msync(mappa, dimMappa, MS_SYNC);
+	}
+
+	/* Funzione size():
+		- restituisce il numero di scansioni presenti nel diario
+	*/
+	int DiarioScansioni::size() const {
+		return dimension;
+	}
+
+	/* Funzione get_numero_record():
+		- restituisce il numero massimo di scansioni che il diario può contenere
+	*/
+	int DiarioScansioni::get_numero_record() const {
+		return parametri.numeroRecord;
+	}
+
+	/* Funzione get_view(int k):
+		- restituisce una vista sulle misure della k-esima scansione del diario, contando dalla più
+		  vecchia (k = 0) alla più nuova (k = size() - 1), direttamente nella mappatura del file
+		- la vista si accorge (con valida()) solo dei record riscritti da questo oggetto: in un lettore
+		  aperto mentre il driver scrive il record può cambiare sotto la vista, per cui va usata leggi
+		- se k non corrisponde a nessuna scansione viene lanciata l'eccezione "NoGheSonVettoriError"
+	*/
+	VistaScansione DiarioScansioni::get_view(int k) const {
+		if (k < 0 || k >= dimension)
+			throw NoGheSonVettoriError();
+
+		int i = avanza(elPiVecio, k);
+		return VistaScansione(misure_record(i), parametri.dimScansioni,
+		                      &generazioni[i], get_formato(), parametri.scala);
+	}
+
+	/* Funzione leggi(int k, double *out):
+		1. il record della k-esima scansione (come in get_view) deve avere il progressivo che gli indici
+		   di questo oggetto gli attribuiscono: se è diverso (o 0) il record è già stato sovrascritto, o
+		   è in scrittura, da un altro processo e viene restituito false
+		2. copia le misure a parole di 8 byte in un buffer di appoggio e poi rilegge il progressivo:
+		   se è cambiato durante la copia il driver ha iniziato a riscrivere il record e la copia
+		   può essere mescolata, per cui viene restituito false
+		3. altrimenti converte le misure in double in out (get_dim_scansioni() misure) e restituisce true
+
+		Osservazioni:
+		- è il modo di leggere un diario mentre il driver lo sta ancora scrivendo: le viste di
+		  get_view si accorgono solo delle sovrascritture fatte da questo stesso oggetto, perché le
+		  generazioni dei record non sono salvate nel file
+		- le parole vengono lette con atomic_ref: il record è lungo un multiplo di 64 byte e
+		  le intestazioni di 64, per cui l'ultima parola non esce dal record
+		- se k non corrisponde a nessuna scansione viene lanciata l'eccezione "NoGheSonVettoriError"
+	*/
+	bool DiarioScansioni::leggi(int k, double *out) const {
+		if (k < 0 || k >= dimension)
+			throw NoGheSonVettoriError();
+
+		int i = avanza(elPiVecio, k);
+		std::uint64_t atteso = ultimoProgressivo - dimension + 1 + k;
+		std::atomic_ref<std::uint64_t> progressivo(testa_record(i)->progressivo);
+		if (progressivo.load(std::memory_order_acquire) != atteso)
+			return false;
+
+		std::size_t parole = (parametri.dimScansioni * dimensione_campione(get_formato()) + 7) / 8;
+		thread_local std::vector<std::uint64_t> copia;
+		copia.resize(parole);
+		std::uint64_t *src = reinterpret_cast<std::uint64_t *>(misure_record(i));
+		for (std::size_t j = 0; j < parole; j++)
+			copia[j] = std::atomic_ref<std::uint64_t>(src[j]).load(std::memory_order_relaxed);
+
+		// la fence impedisce che la rilettura del progressivo venga anticipata alla copia
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (progressivo.load(std::memory_order_relaxed) != atteso)
+			return false;
+
+		decodifica_campioni(reinterpret_cast<const unsigned char *>(copia.data()), parametri.dimScansioni,
+		                    out, get_formato(), parametri.scala);
+		return true;
+	}
+
+	/* Funzione misure(int k):
+		- come get_view, ma restituisce il puntatore alle misure nel formato del diario (è quello
+		  che usa LidarDriver::apri_diario per ricaricare le scansioni con una memcpy)
+	*/
+	const unsigned char *DiarioScansioni::misure(int k) const {
+		if (k < 0 || k >= dimension)
+			throw NoGheSonVettoriError();
+
+		return misure_record(avanza(elPiVecio, k));
+	}
+
+	/* Funzione intestazione(int k):
+		- restituisce l'intestazione (sequenza, timestamp, ...) della k-esima scansione del diario
+	*/
+	const IntestazioneScansione &DiarioScansioni::intestazione(int k) const {
+		if (k < 0 || k >= dimension)
+			throw NoGheSonVettoriError();
+
+		return *intestazione_record(avanza(elPiVecio, k));
+	}
+
+	/* Funzione cerca_sequenza(unsigned long long sequenza):
+		1. di solito le sequenze (del driver) dei record tra il più vecchio e il più nuovo sono
+		   consecutive, per cui la posizione della scansione cercata si calcola da quella del più nuovo
+		   e basta controllare che l'intestazione in quella posizione abbia proprio quella sequenza
+		2. se non è così (il chiamante ha passato le sequenze a new_scan, o il driver è stato
+		   ricreato) il diario viene scorso dal più nuovo al più vecchio
+		3. restituisce -1 se la scansione non è nel diario (troppo vecchia o non ancora scritta)
+	*/
+	int DiarioScansioni::cerca_sequenza(unsigned long long sequenza) const {
+		if (dimension == 0)
+			return -1;
+
+		unsigned long long ultima = intestazione(dimension - 1).sequenza;
+		if (sequenza <= ultima && ultima - sequenza < static_cast<unsigned long long>(dimension)) {
+			int k = dimension - 1 - static_cast<int>(ultima - sequenza);
+			if (intestazione(k).sequenza == sequenza)
+				return k;
+		}
+		for (int k = dimension - 1; k >= 0; k--)
+			if (intestazione(k).sequenza == sequenza)
+				return k;
+		return -1;
+	}
+
+	/* Funzioni get_dim_scansioni(), get_formato(), get_resolution(), get_scala():
+		- restituiscono i parametri con cui è stato creato il diario
+	*/
+	int DiarioScansioni::get_dim_scansioni() const {
+		return parametri.dimScansioni;
+	}
+
+	FormatoCampioni DiarioScansioni::get_formato() const {
+		return static_cast<FormatoCampioni>(parametri.formato);
+	}
+
+	double DiarioScansioni::get_resolution() const {
+		return parametri.resolusion;
+	}
+
+	double DiarioScansioni::get_scala() const {
+		return parametri.scala;
+	}
+
+	/* Funzione mappa_file(const std::string &percorso, bool scrittura, std::size_t dimNuovo):
+		1. apre il file (in scrittura lo crea se non c'è)
+		2. se il file è vuoto e lo si apre in scrittura, lo porta a dimNuovo byte (tutti a zero)
+		3. mappa tutto il file in memoria, condiviso con il file stesso
+		4. restituisce true se il file è stato creato (o era vuoto)
+
+		Osservazione:
+		- in caso di errore il file viene chiuso e viene lanciata l'eccezione "FileSbagliatoError"
+	*/
+	bool DiarioScansioni::mappa_file(const std::string &percorso, bool scrittura, std::size_t dimNuovo) {
+		mappa = nullptr;
+		fd = open(percorso.c_str(), scrittura ? (O_RDWR | O_CREAT) : O_RDONLY, 0644);
+		if (fd < 0)
+			throw FileSbagliatoError();
+
+		struct stat info;
+		if (fstat(fd, &info) != 0) {
+			chiudi();
+			throw FileSbagliatoError();
+		}
+		bool nuovo = info.st_size == 0;
+		if (nuovo && scrittura && ftruncate(fd, dimNuovo) != 0) {
+			chiudi();
+			throw FileSbagliatoError();
+		}
+
+		dimMappa = (nuovo && scrittura) ? dimNuovo : info.st_size;
+		if (dimMappa < INIZIO_RECORD_DIARIO) {
+			chiudi();
+			throw FileSbagliatoError();
+		}
+		void *p = mmap(nullptr, dimMappa, scrittura ? (PROT_READ | PROT_WRITE) : PROT_READ, MAP_SHARED, fd, 0);
+		if (p == MAP_FAILED) {
+			chiudi();
+			throw FileSbagliatoError();
+		}
+		mappa = static_cast<unsigned char *>(p);
+		return nuovo;
+	}
+
+	/* Funzione chiudi():
+		- toglie la mappatura (se c'è) e chiude il file (se è aperto)
+	*/
+	void DiarioScansioni::chiudi() {
+		if (mappa != nullptr)
+			munmap(mappa, dimMappa);
+		if (fd >= 0)
+			close(fd);
+		mappa = nullptr;
+		fd = -1;
+	}
+}
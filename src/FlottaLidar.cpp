@@ -0,0 +1,314 @@
+/*
+	FILE IMPLEMENTAZIONI FLOTTALIDAR.CPP
+
+	Vengono implementate le funzioni della libreria FlottaLidar.h
+*/
+
+#include "../include/FlottaLidar.h"
+#include <algorithm> // per std::min e std::fill_n
+#include <atomic>
+#include <cmath>     // per std::isfinite
+#include <mutex>
+#include <span>
+#include <thread>
+#include <vector>
+#ifdef __linux__
+#include <pthread.h> // per pthread_setaffinity_np
+#include <sched.h>   // per sched_getaffinity
+#endif
+
+namespace lidar_driver {
+	/* Funzione core_disponibili():
+		- restituisce i core su cui il processo può girare (su Linux quelli della sua affinità, che in
+		  un container possono essere meno di quelli della macchina), per legarci i lavoratori
+		- se non si riesce a saperlo restituisce un vettore vuoto e i lavoratori non vengono legati
+	*/
+	static std::vector<int> core_disponibili() {
+		std::vector<int> core;
+#ifdef __linux__
+		cpu_set_t insieme;
+		CPU_ZERO(&insieme);
+		if (sched_getaffinity(0, sizeof(insieme), &insieme) == 0)
+			for (int c = 0; c < CPU_SETSIZE; c++)
+				if (CPU_ISSET(c, &insieme))
+					core.push_back(c);
+#endif
+		return core;
+	}
+
+	/* Costruttore con numero di sensori, risoluzione e numero di lavoratori:
+		1. verifica il numero di sensori e crea un driver (con formato e scala indicati) e una casella
+		   di arrivo per ognuno; il driver controlla risoluzione e scala
+		2. sceglie il numero di lavoratori: quelli chiesti, o con 0 uno per sensore ma non più dei core
+		   disponibili, e comunque non più dei sensori (un lavoratore senza sensori non servirebbe)
+		3. avvia i lavoratori e lega il lavoratore w al w-esimo core disponibile (ricominciando dal primo
+		   se i lavoratori sono più dei core)
+
+		Osservazioni:
+		- se il sistema non permette di legare i thread ai core, i lavoratori funzionano lo stesso,
+		  solo senza la garanzia di restare sullo stesso core
+		- se non si riesce ad avviare un lavoratore, quelli già avviati vengono fermati e aspettati
+		  prima di rilanciare l'eccezione (std::system_error)
+	*/
+	FlottaLidar::FlottaLidar(int numeroSensori, double resolusion, int numeroLavoratori, FormatoCampioni formato, double scala) {
+		if (numeroSensori < 1 || numeroLavoratori < 0)
+			throw SensoreForaDaiRangeError();
+
+		sensori.reserve(numeroSensori);
+		for (int s = 0; s < numeroSensori; s++)
+			sensori.push_back(std::make_unique<Sensore>(resolusion, formato, scala));
+		dimScansioni = sensori[0]->driver.get_dim_scansioni();
+
+		std::vector<int> core = core_disponibili();
+		if (numeroLavoratori == 0)
+			numeroLavoratori = core.empty() ? static_cast<int>(std::thread::hardware_concurrency()) : static_cast<int>(core.size());
+		numeroLavoratori = std::min(std::max(numeroLavoratori, 1), numeroSensori);
+
+		lavoratori.reserve(numeroLavoratori);
+		for (int w = 0; w < numeroLavoratori; w++)
+			lavoratori.push_back(std::make_unique<Lavoratore>());
+		int avviati = 0;
+		try {
+			for (; avviati < numeroLavoratori; avviati++) {
+				int w = avviati;
+				lavoratori[w]->thread = std::thread(&FlottaLidar::lavora, this, w);
+#ifdef __linux__
+				if (!core.empty()) {
+					cpu_set_t insieme;
+					CPU_ZERO(&insieme);
+					CPU_SET(core[w % core.size()], &insieme);
+					pthread_setaffinity_np(lavoratori[w]->thread.native_handle(), sizeof(insieme), &insieme);
+				}
+#endif
+			}
+		} catch (...) {
+			// i thread già avviati vanno fermati come nel distruttore (che non viene chiamato),
+			// altrimenti verrebbero distrutti ancora joinable e il programma terminerebbe
+			fermo.store(true, std::memory_order_release);
+			for (int w = 0; w < avviati; w++) {
+				sveglia(w);
+				lavoratori[w]->thread.join();
+			}
+			throw;
+		}
+	}
+
+	/* Distruttore:
+		- chiede ai lavoratori di terminare, li sveglia e aspetta che abbiano finito
+	*/
+	FlottaLidar::~FlottaLidar() {
+		fermo.store(true, std::memory_order_release);
+		for (int w = 0; w < numero_lavoratori(); w++) {
+			sveglia(w);
+			lavoratori[w]->thread.join();
+		}
+	}
+
+	/* Funzione new_scan(int s, std::span<const double> v) - un solo thread per sensore:
+		1. copia la scansione nella casella di arrivo del sensore s (troncando o completando con zeri)
+		2. sveglia il lavoratore del sensore, che la inserirà nel driver
+		- se s non è un sensore valido viene lanciata l'eccezione "SensoreForaDaiRangeError"
+	*/
+	void FlottaLidar::new_scan(int s, std::span<const double> v) {
+		sensore(s).arrivi.new_scan(v);
+		sveglia(lavoratore_di(s));
+	}
+
+	/* Funzione new_scan(int s, const vector<double> &v):
+		- come la new_scan da span
+	*/
+	void FlottaLidar::new_scan(int s, const std::vector<double> &v) {
+		new_scan(s, std::span<const double>(v));
+	}
+
+	/* Funzione attendi():
+		- un'interrogazione vuota: al ritorno tutte le scansioni passate a new_scan prima della chiamata
+		  (dallo stesso thread) sono state inserite nei driver
+	*/
+	void FlottaLidar::attendi() {
+		auto niente = [](int) {};
+		in_parallelo(niente);
+	}
+
+	/* Funzione ultime_scansioni(std::span<double> misure, std::span<long long> tempi):
+		1. controlla che gli span bastino per tutti i sensori (numero_sensori() * get_dim_scansioni()
+		   misure e numero_sensori() timestamp), altrimenti lancia "DimensionOutputSbagliataError"
+		2. ogni lavoratore copia l'ultima scansione dei suoi sensori, convertita in double, e il suo
+		   timestamp; un sensore senza scansioni ha tutte le misure a 0 e timestamp -1
+	*/
+	void FlottaLidar::ultime_scansioni(std::span<double> misure, std::span<long long> tempi) {
+		if (misure.size() < sensori.size() * dimScansioni || tempi.size() < sensori.size())
+			throw DimensionOutputSbagliataError();
+
+		auto copia = [&](int s) {
+			Sensore &x = *sensori[s];
+			double *dest = misure.data() + static_cast<std::size_t>(s) * dimScansioni;
+			std::lock_guard<std::mutex> blocco(x.mutex);
+			if (x.driver.size() == 0) {
+				std::fill_n(dest, dimScansioni, 0.0);
+				tempi[s] = -1;
+				return;
+			}
+			x.driver.get_last_view().copia_in(dest);
+			tempi[s] = x.driver.get_timestamp(x.driver.size() - 1);
+		};
+		in_parallelo(copia);
+	}
+
+	/* Funzione closest_obstacle():
+		1. ogni lavoratore trova l'ostacolo più vicino nell'ultima scansione di ognuno dei suoi sensori:
+		   con le statistiche attive è già stato calcolato da new_scan, altrimenti cerca la misura
+		   valida (positiva e finita, come nelle statistiche) più piccola
+		2. il risultato di ogni sensore viene scritto nel suo stato (su una cache line sua) e alla fine
+		   viene scelto il più vicino; a parità di distanza vince il sensore con il numero più basso
+	*/
+	OstacoloFlotta FlottaLidar::closest_obstacle() {
+		auto cerca = [&](int s) {
+			Sensore &x = *sensori[s];
+			OstacoloFlotta o;
+			std::lock_guard<std::mutex> blocco(x.mutex);
+			if (x.driver.size() > 0) {
+				if (x.driver.statistiche_attive()) {
+					const StatisticheScansione &st = x.driver.scan_stats();
+					if (st.valide > 0)
+						o = {s, st.minimo, st.angoloMinimo};
+				} else {
+					VistaScansione v = x.driver.get_last_view();
+					for (int i = 0; i < v.size(); i++) {
+						double d = v[i];
+						if (d > 0 && std::isfinite(d) && (o.sensore < 0 || d < o.distanza))
+							o = {s, d, i * x.driver.get_resolution()};
+					}
+				}
+			}
+			x.ostacolo = o;
+		};
+		in_parallelo(cerca);
+
+		OstacoloFlotta migliore;
+		for (const std::unique_ptr<Sensore> &x : sensori)
+			if (x->ostacolo.sensore >= 0 && (migliore.sensore < 0 || x->ostacolo.distanza < migliore.distanza))
+				migliore = x->ostacolo;
+		return migliore;
+	}
+
+	/* Funzioni numero_sensori(), numero_lavoratori(), lavoratore_di(int s), get_dim_scansioni():
+		- restituiscono i parametri della flotta; lavoratore_di lancia "SensoreForaDaiRangeError" se s
+		  non è un sensore valido
+	*/
+	int FlottaLidar::numero_sensori() const {
+		return sensori.size();
+	}
+
+	int FlottaLidar::numero_lavoratori() const {
+		return lavoratori.size();
+	}
+
+	int FlottaLidar::lavoratore_di(int s) const {
+		if (s < 0 || s >= numero_sensori())
+			throw SensoreForaDaiRangeError();
+		return s % numero_lavoratori();
+	}
+
+	int FlottaLidar::get_dim_scansioni() const {
+		return dimScansioni;
+	}
+
+	/* Funzione scansioni_perse(int s):
+		- restituisce quante scansioni del sensore s sono state sovrascritte nella casella di arrivo
+		  prima che il suo lavoratore riuscisse a inserirle nel driver
+	*/
+	unsigned long long FlottaLidar::scansioni_perse(int s) const {
+		return sensore(s).arrivi.scansioni_perse();
+	}
+
+	/* Funzione sensore(int s):
+		- restituisce lo stato del sensore s, o lancia "SensoreForaDaiRangeError" se non esiste
+	*/
+	FlottaLidar::Sensore &FlottaLidar::sensore(int s) const {
+		if (s < 0 || s >= numero_sensori())
+			throw SensoreForaDaiRangeError();
+		return *sensori[s];
+	}
+
+	/* Funzione sveglia(int w):
+		- incrementa il campanello del lavoratore w e, se sta dormendo, lo sveglia
+	*/
+	void FlottaLidar::sveglia(int w) {
+		lavoratori[w]->campanello.fetch_add(1, std::memory_order_release);
+		lavoratori[w]->campanello.notify_one();
+	}
+
+	/* Funzione esegui(void (*f)(void *, int), void *c):
+		1. pubblica l'interrogazione (funzione e contesto), dice che mancano tutti i lavoratori e
+		   incrementa la generazione, poi sveglia i lavoratori
+		2. aspetta che il numero di lavoratori mancanti arrivi a 0
+
+		Osservazione:
+		- lavoro e contesto non sono atomici: vengono scritti prima dell'incremento (rilascio) della
+		  generazione e letti dai lavoratori dopo averla letta (acquisizione), e non cambiano finché
+		  tutti i lavoratori non hanno finito, perché il mutex permette una sola interrogazione alla volta
+	*/
+	void FlottaLidar::esegui(void (*f)(void *, int), void *c) {
+		std::lock_guard<std::mutex> blocco(interrogazione);
+		lavoro = f;
+		contesto = c;
+		mancanti.store(numero_lavoratori(), std::memory_order_relaxed);
+		generazione.fetch_add(1, std::memory_order_release);
+		for (int w = 0; w < numero_lavoratori(); w++)
+			sveglia(w);
+
+		int m;
+		while ((m = mancanti.load(std::memory_order_acquire)) != 0)
+			mancanti.wait(m, std::memory_order_acquire);
+	}
+
+	/* Funzione lavora(int w) - corpo del lavoratore w:
+		1. legge il campanello, così se qualcuno suona mentre lavora non si addormenta
+		2. legge la generazione delle interrogazioni
+		3. inserisce nei driver tutte le scansioni arrivate ai suoi sensori, prendendo il mutex del
+		   sensore solo per la new_scan (la copia dalla casella di arrivo è fuori dal mutex)
+		4. se c'è un'interrogazione nuova la esegue per i suoi sensori e, se è l'ultimo a finire,
+		   sveglia il thread che l'ha chiesta
+		5. dorme finché il campanello non cambia
+
+		Osservazioni:
+		1. la generazione viene letta prima di svuotare le caselle: così le scansioni inserite prima
+		   dell'interrogazione (dallo stesso thread) sono già visibili e vengono inserite prima di
+		   rispondere
+		2. la scansione viene copiata dalla casella in un vettore del lavoratore, allocato una volta
+		   sola, per cui l'inserimento non alloca memoria
+	*/
+	void FlottaLidar::lavora(int w) {
+		Lavoratore &io = *lavoratori[w];
+		int passo = numero_lavoratori();
+		unsigned long long fatta = 0;
+		std::vector<double> scansione(dimScansioni);
+
+		while (true) {
+			unsigned visto = io.campanello.load(std::memory_order_acquire);
+			if (fermo.load(std::memory_order_acquire))
+				return;
+			unsigned long long g = generazione.load(std::memory_order_acquire);
+
+			for (int s = w; s < numero_sensori(); s += passo) {
+				Sensore &x = *sensori[s];
+				// try_get_scan è false anche se erano tutte sovrascritte durante la lettura
+				while (x.arrivi.try_get_scan(scansione)) {
+					std::lock_guard<std::mutex> blocco(x.mutex);
+					x.driver.new_scan(scansione);
+				}
+			}
+
+			if (g != fatta) {
+				for (int s = w; s < numero_sensori(); s += passo)
+					lavoro(contesto, s);
+				fatta = g;
+				if (mancanti.fetch_sub(1, std::memory_order_acq_rel) == 1)
+					mancanti.notify_all();
+			}
+
+			io.campanello.wait(visto, std::memory_order_acquire);
+		}
+	}
+}
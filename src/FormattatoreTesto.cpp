@@ -0,0 +1,116 @@
+/*
+	FILE IMPLEMENTAZIONI FORMATTATORETESTO.CPP
+
+	Vengono implementate le funzioni della libreria FormattatoreTesto.h
+*/
+
+#include "../include/FormattatoreTesto.h"
+#include <charconv> // per std::to_chars
+#include <cmath>    // per std::round nella funzione formatta_settore
+#include <string>
+
+namespace lidar_driver {
+	/* Costruttore:
+		- salva le opzioni e riserva un po' di spazio per la stringa, che poi crescerà da sola fino
+		  alla dimensione necessaria e non verrà più riallocata
+	*/
+	FormattatoreTesto::FormattatoreTesto(OpzioniTesto opzioni) : opzioni{opzioni} {
+		testo.reserve(4096);
+	}
+
+	/* Funzione formatta(const VistaScansione &scansione):
+		- svuota la stringa (mantenendo la memoria) e ci scrive il testo della scansione
+	*/
+	std::string_view FormattatoreTesto::formatta(const VistaScansione &scansione) {
+		testo.clear();
+		aggiungi_scansione(scansione, 0, scansione.size());
+		return testo;
+	}
+
+	/* Funzione formatta_ultima(const LidarDriver &ld):
+		- testo dell'ultima scansione inserita nel driver, o opzioni.vuoto se il buffer è vuoto
+		- è la funzione usata dall'operatore << di LidarDriver
+	*/
+	std::string_view FormattatoreTesto::formatta_ultima(const LidarDriver &ld) {
+		if (ld.size() == 0)
+			return opzioni.vuoto;
+		return formatta(ld.get_last_view());
+	}
+
+	/* Funzione formatta_buffer(const LidarDriver &ld):
+		- testo di tutte le scansioni presenti nel buffer, una dopo l'altra dalla più vecchia alla
+		  più nuova, o opzioni.vuoto se il buffer è vuoto
+	*/
+	std::string_view FormattatoreTesto::formatta_buffer(const LidarDriver &ld) {
+		if (ld.size() == 0)
+			return opzioni.vuoto;
+
+		testo.clear();
+		for (int k = 0; k < ld.size(); k++) {
+			VistaScansione scansione = ld.get_view(k);
+			aggiungi_scansione(scansione, 0, scansione.size());
+		}
+		return testo;
+	}
+
+	/* Funzione formatta_settore(const LidarDriver &ld, double inizio, double fine):
+		1. controlla che il settore sia valido, altrimenti lancia "AngoloForaDaiRangeError"
+		2. converte gli angoli in indici come get_distance (indice più vicino)
+		3. scrive solo le misure dell'ultima scansione con indice compreso tra i due
+	*/
+	std::string_view FormattatoreTesto::formatta_settore(const LidarDriver &ld, double inizio, double fine) {
+		if (!(inizio >= 0 && inizio <= fine && fine <= 180))
+			throw LidarDriver::AngoloForaDaiRangeError();
+		if (ld.size() == 0)
+			return opzioni.vuoto;
+
+		VistaScansione scansione = ld.get_last_view();
+		int da = static_cast<int>(std::round(inizio / ld.get_resolution()));
+		int a = static_cast<int>(std::round(fine / ld.get_resolution())) + 1;
+		if (a > scansione.size())
+			a = scansione.size();
+		if (da >= a)
+			da = a - 1;
+
+		testo.clear();
+		aggiungi_scansione(scansione, da, a);
+		return testo;
+	}
+
+	/* Funzione get_opzioni():
+		- restituisce le opzioni di formattazione attuali
+	*/
+	const OpzioniTesto &FormattatoreTesto::get_opzioni() const {
+		return opzioni;
+	}
+
+	/* Funzione set_opzioni(const OpzioniTesto &):
+		- cambia le opzioni di formattazione per le chiamate successive
+	*/
+	void FormattatoreTesto::set_opzioni(const OpzioniTesto &nuoveOpzioni) {
+		opzioni = nuoveOpzioni;
+	}
+
+	/* Funzione aggiungi_scansione(const VistaScansione &scansione, int da, int a):
+		- aggiunge alla stringa apertura, misure con indice in [da, a) separate da separatore e chiusura
+		- ogni misura viene convertita con std::to_chars in un piccolo array nello stack e poi
+		  aggiunta alla stringa: con la capacità già sufficiente la append è una semplice copia
+
+		Osservazione:
+		- l'array è grande abbastanza per qualunque double in formato fisso (il più grande ha 309
+		  cifre intere) con fino a 60 cifre decimali; precisioni maggiori vengono limitate a 60
+	*/
+	void FormattatoreTesto::aggiungi_scansione(const VistaScansione &scansione, int da, int a) {
+		int precisione = (opzioni.precisione < 0) ? 0 : (opzioni.precisione > 60) ? 60 : opzioni.precisione;
+		char numero[400];
+
+		testo += opzioni.apertura;
+		for (int i = da; i < a; i++) {
+			std::to_chars_result r = std::to_chars(numero, numero + sizeof(numero), scansione[i], std::chars_format::fixed, precisione);
+			testo.append(numero, r.ptr);
+			if (i < a - 1)
+				testo += opzioni.separatore;
+		}
+		testo += opzioni.chiusura;
+	}
+}
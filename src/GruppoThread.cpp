@@ -0,0 +1,154 @@
+/*
+	FILE IMPLEMENTAZIONI GRUPPOTHREAD.CPP
+
+	Vengono implementate le funzioni della libreria GruppoThread.h
+*/
+
+#include "../include/GruppoThread.h"
+#include <algorithm> // per std::min
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+
+namespace lidar_driver {
+	// true nei thread del gruppo e nel thread che sta eseguendo un per_ogni (per i lavori annidati)
+	static thread_local bool dentroGruppo = false;
+
+	/* Costruttore con numero di thread:
+		- con 0 crea un thread per core meno uno, perché anche il thread che chiama per_ogni lavora
+		- avvia i thread, che si mettono subito a dormire in attesa del primo lavoro
+	*/
+	GruppoThread::GruppoThread(int numeroThread) {
+		if (numeroThread <= 0)
+			numeroThread = static_cast<int>(std::thread::hardware_concurrency()) - 1;
+		for (int w = 0; w < numeroThread; w++)
+			thread.emplace_back(&GruppoThread::lavora, this, w);
+	}
+
+	/* Distruttore:
+		- chiede ai thread di terminare, li sveglia e aspetta che abbiano finito
+	*/
+	GruppoThread::~GruppoThread() {
+		fermo.store(true, std::memory_order_release);
+		generazione.fetch_add(1, std::memory_order_release);
+		generazione.notify_all();
+		for (std::thread &t : thread)
+			t.join();
+	}
+
+	/* Funzione size():
+		- restituisce il numero di thread del gruppo, escluso quello che chiama per_ogni
+	*/
+	int GruppoThread::size() const {
+		return thread.size();
+	}
+
+	/* Funzione condiviso():
+		- restituisce il gruppo di thread condiviso, con un thread per core, creato alla prima chiamata
+		  (e distrutto all'uscita dal programma)
+	*/
+	GruppoThread &GruppoThread::condiviso() {
+		static GruppoThread gruppo;
+		return gruppo;
+	}
+
+	/* Funzione esegui(int n, void (*f)(void *, int), void *c, int massimo, int blocco):
+		1. calcola quanti thread del gruppo servono: non più di massimo - 1 (il thread che chiama lavora
+		   anche lui) e non più dei blocchi di indici meno uno
+		2. se non ne serve nessuno, o se è un lavoro annidato, chiama f(c, i) per ogni indice e finisce
+		3. altrimenti pubblica il lavoro e sveglia il gruppo, prende blocchi di indici finché ce ne
+		   sono, aspetta che tutti i thread del gruppo abbiano finito e rilancia l'eventuale eccezione
+
+		Osservazione:
+		- tutti i thread del gruppo vengono svegliati e contati in mancanti, anche quelli che non
+		  partecipano: così nessuno può ancora leggere i dati di un lavoro quando ne viene pubblicato
+		  un altro
+	*/
+	void GruppoThread::esegui(int n, void (*f)(void *, int), void *c, int massimo, int blocco) {
+		if (n <= 0)
+			return;
+		if (blocco < 1)
+			blocco = 1;
+
+		int aiutanti = (massimo <= 0) ? size() : std::min(massimo - 1, size());
+		aiutanti = std::min(aiutanti, (n - 1) / blocco);
+		if (dentroGruppo || aiutanti <= 0) {
+			for (int i = 0; i < n; i++)
+				f(c, i);
+			return;
+		}
+
+		std::lock_guard<std::mutex> bloccoGruppo(occupato);
+		lavoro = f;
+		contesto = c;
+		totale = n;
+		dimBlocco = blocco;
+		partecipanti = aiutanti;
+		errore = nullptr;
+		prossimo.store(0, std::memory_order_relaxed);
+		mancanti.store(size(), std::memory_order_relaxed);
+		generazione.fetch_add(1, std::memory_order_release);
+		generazione.notify_all();
+
+		dentroGruppo = true;
+		prendi_blocchi();
+		dentroGruppo = false;
+
+		int m;
+		while ((m = mancanti.load(std::memory_order_acquire)) != 0)
+			mancanti.wait(m, std::memory_order_acquire);
+
+		if (errore) {
+			std::exception_ptr e = errore;
+			errore = nullptr;
+			std::rethrow_exception(e);
+		}
+	}
+
+	/* Funzione lavora(int w) - corpo del thread w del gruppo:
+		- dorme finché la generazione non cambia, poi, se è tra i partecipanti, prende blocchi di indici
+		  finché ce ne sono; alla fine dice che ha finito e, se è l'ultimo, sveglia chi aspetta
+	*/
+	void GruppoThread::lavora(int w) {
+		dentroGruppo = true;
+		unsigned vista = 0;
+		while (true) {
+			generazione.wait(vista, std::memory_order_acquire);
+			vista = generazione.load(std::memory_order_acquire);
+			if (fermo.load(std::memory_order_acquire))
+				return;
+
+			if (w < partecipanti)
+				prendi_blocchi();
+			if (mancanti.fetch_sub(1, std::memory_order_acq_rel) == 1)
+				mancanti.notify_all();
+		}
+	}
+
+	/* Funzione prendi_blocchi():
+		- prende dal contatore condiviso il prossimo blocco di indici e chiama il lavoro su ognuno,
+		  finché gli indici non finiscono
+		- se il lavoro lancia un'eccezione la salva (solo la prima), porta il contatore in fondo così
+		  gli altri smettono di prendere blocchi, e finisce
+	*/
+	void GruppoThread::prendi_blocchi() {
+		while (true) {
+			int i = prossimo.fetch_add(dimBlocco, std::memory_order_relaxed);
+			if (i >= totale)
+				return;
+
+			int fine = std::min(i + dimBlocco, totale);
+			try {
+				for (; i < fine; i++)
+					lavoro(contesto, i);
+			} catch (...) {
+				std::lock_guard<std::mutex> bloccoErrore(mutexErrore);
+				if (!errore)
+					errore = std::current_exception();
+				prossimo.store(totale, std::memory_order_relaxed);
+				return;
+			}
+		}
+	}
+}
@@ -8,35 +8,100 @@
 */
 
 #include "../include/LidarDriver.h"
+#include "../include/FormattatoreTesto.h" // per overloading operator<<
+#include "../include/DiarioScansioni.h" // per apri_diario e registra
 #include <vector>  // per operazioni su vector
-#include <cmath>   // per std::round nella funzione get_distance
+#include <memory>  // per gli slot condivisi (std::shared_ptr)
+#include <atomic>  // per la fence nella funzione slot_scrivibile
+#include <memory_resource> // per la risorsa degli slot (nuovo_slot e set_risorsa)
+#include <chrono>  // per il timestamp delle scansioni
+#include <istream> // per read_scan e read_buffer
+#include <algorithm> // per std::min nelle funzioni new_scans e get_distances
+#include <cstring> // per std::memset e std::memcpy nelle funzioni new_scan e set_dim_buffer
+#include <climits> // per INT_MAX nel costruttore con budget di memoria e LLONG_MAX in trova_intervallo
+#include <cmath>   // per std::round nella funzione get_distance e std::cos e std::sin in calcola_tabelle
 #include <ostream> // per overloading operator<<
 #include <string>  // per overloading operator<<
+#include <span>    // per get_distances, to_points e sector_stats
+#include <utility> // per std::pair nelle funzioni trova_intervallo e closest_obstacle
+#include <limits>  // per l'infinito nella funzione fondi
+#include <numbers> // per pi greco nella funzione calcola_tabelle
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h> // per la versione vettorizzata di get_distances
+#endif
 
 namespace lidar_driver {
 	/* Costruttore con risoluzione:
 		1. riceve come parametro la risoluzione dello strumento e verifica che sia valida
-		2. imposta le variabili membro ai valori di default
-		3. ridimensiona il buffer alla dimensione necessaria
+		2. riceve (opzionalmente) il formato in cui memorizzare le misure e, per UINT16, la scala
+		   (di default le misure sono double come da specifiche)
+		3. imposta le variabili membro ai valori di default
+		4. alloca il buffer: un unico blocco da BUFFER_DIM * dimScansioni misure, che viene
+		   riusato per tutta la vita dell'oggetto
 
-		Osservazione:
+		Osservazioni:
 		- con la formula usata per calcolare il numero delle misure per scansione, non si supera mai
 		  il 180, ci si ferma sempre al massimo numero <= 180°
+		- con FLOAT il buffer occupa la metà della memoria, con UINT16 un quarto
+		- è il costruttore delle specifiche: il buffer ha la dimensione di default BUFFER_DIM
+	*/
+	LidarDriver::LidarDriver(double resolusion, FormatoCampioni formato, double scala)
+		: LidarDriver(resolusion, BUFFER_DIM, formato, scala) {}
+
+	/* Costruttore con risoluzione e dimensione del buffer:
+		1. come il costruttore con risoluzione, ma il buffer contiene dimBuffer scansioni invece
+		   di BUFFER_DIM
+		2. se dimBuffer è una potenza di 2, gli indici del buffer circolare vengono fatti "girare"
+		   con una maschera di bit invece che con il modulo
 	*/
-	LidarDriver::LidarDriver(double resolusion) {
-		// verifica che la risoluzione sia valida
+	LidarDriver::LidarDriver(double resolusion, int dimBuffer, FormatoCampioni formato, double scala) {
+		// verifica che risoluzione, dimensione del buffer e scala siano valide
 		if (resolusion < MIN_RESOLUTION || resolusion > MAX_RESOLUTION)
 			throw ResolusionForaDaiRangeError();
+		if (dimBuffer < 1)
+			throw DimBufferForaDaiRangeError();
+		if (!(scala > 0))
+			throw ScalaForaDaiRangeError();
 		
 		// inizializza le variabili ai valori di default
 		this->resolusion = resolusion;
+		this->formato = formato;
+		this->scala = scala;
+		this->dimBuffer = dimBuffer;
+		potenzaDi2 = (dimBuffer & (dimBuffer - 1)) == 0;
 		elPiNovo = elPiVecio = dimension = 0;
+		scansioniInserite = scansioniPerse = 0;
+		filtriAttivi = false;
 		dimScansioni = (MAX_ANGLE - MIN_ANGLE) / resolusion + 1;
+		statisticheAttive = false;
+		misurePerSettore = dimScansioni;
+		numeroSettori = 1;
+		dimCampione = dimensione_campione(formato);
+		risorsa = std::pmr::new_delete_resource();
+		metriche = nullptr;
 
-		// ridimensiona il buffer alla dimensione necessaria
-		secia.resize(BUFFER_DIM);
+		// alloca gli slot per tutte le scansioni (dopo si alloca solo per non toccare gli slot
+		// condivisi con una copia)
+		secia.resize(dimBuffer);
+		for (std::shared_ptr<unsigned char> &s : secia)
+			s = nuovo_slot();
+		generazioni.resize(dimBuffer);
+		tempi.resize(dimBuffer);
+		sequenze.resize(dimBuffer);
+		calcola_tabelle();
 	}
 
+	/* Costruttore con risoluzione e budget di memoria:
+		1. calcola quante scansioni stanno nel budget di byte indicato, tenendo conto della
+		   risoluzione (misure per scansione) e del formato (byte per misura)
+		2. costruisce il buffer con quel numero di scansioni
+
+		Osservazione:
+		- se nel budget non sta neanche una scansione viene lanciata DimBufferForaDaiRangeError
+	*/
+	LidarDriver::LidarDriver(double resolusion, BudgetMemoria budget, FormatoCampioni formato, double scala)
+		: LidarDriver(resolusion, dim_buffer_da_budget(resolusion, budget, formato), formato, scala) {}
+
 	/* Costruttore di copia:
 		1. riceve come parametro un oggetto da copiare
 		2. copia le variabili da copiare
@@ -44,6 +109,10 @@ namespace lidar_driver {
 		Osservazioni:
 		1. basterebbe semplicemente una shallow copy del costruttore di copia generato in automatico
 		   dal compilatore, ma siccome serve creare il costruttore di move, bisogna fare anche questo
+		2. il diario non viene copiato: la copia parte senza diario
+		3. le scansioni non vengono copiate: la copia condivide gli slot con l'originale finché uno
+		   dei due non li sovrascrive (vedi slot_scrivibile), per cui costa poco anche con un buffer
+		   grande e si può usare come istantanea del buffer
 	*/
 	LidarDriver::LidarDriver(const LidarDriver &ld) {
 		// inizializzazione variabili con i valori dell'oggetto da smembrare
@@ -52,9 +121,29 @@ namespace lidar_driver {
 		dimension = ld.dimension;
 		resolusion = ld.resolusion;
 		dimScansioni = ld.dimScansioni;
+		dimBuffer = ld.dimBuffer;
+		potenzaDi2 = ld.potenzaDi2;
+		scansioniInserite = ld.scansioniInserite;
+		scansioniPerse = ld.scansioniPerse;
+		filtri = ld.filtri;
+		filtriAttivi = ld.filtriAttivi;
+		statisticheAttive = ld.statisticheAttive;
+		misurePerSettore = ld.misurePerSettore;
+		numeroSettori = ld.numeroSettori;
+		formato = ld.formato;
+		scala = ld.scala;
+		dimCampione = ld.dimCampione;
+		risorsa = ld.risorsa;
+		metriche = ld.metriche;
 
-		// la classe std::vector gestisce in automatico la copia membro a mebro dei suoi elementi
+		// la classe std::vector gestisce in automatico la copia membro a mebro dei suoi elementi: gli
+		// slot e le tabelle sono shared_ptr, per cui vengono condivisi e non copiati
 		secia = ld.secia;
+		generazioni = ld.generazioni;
+		tempi = ld.tempi;
+		sequenze = ld.sequenze;
+		tabelle = ld.tabelle;
+		statistiche = ld.statistiche;
 	}
 
 	/* Costruttore di move:
@@ -63,8 +152,13 @@ namespace lidar_driver {
 		3. svuoto l'oggetto smembrato, invocando clear_buffer
 
 		Osservazioni:
-		1. la funzione di swap scambia i riferimenti dei dati memorizzati nei due vettori, per cui secia
-		   avrà i dati dell'argomento della funzione e l'argomento avrà i vecchi dati di secia
+		1. la funzione di swap scambia i riferimenti dei dati memorizzati nei due vettori, per cui
+		   generazioni, tempi, ecc. avranno i dati dell'argomento della funzione e l'argomento avrà i
+		   vecchi dati
+		2. gli slot invece vengono spostati e l'argomento resta senza: se ricevesse i vecchi slot non
+		   si saprebbe se hanno la dimensione giusta per le sue scansioni; clear_buffer gli lascia gli
+		   slot vuoti e li alloca slot_scrivibile quando servono
+		3. le tabelle sono condivise anche dopo la move: l'argomento ha la stessa risoluzione di prima
 	*/
 	LidarDriver::LidarDriver(LidarDriver &&ld) {
 		// inizializzazione variabili con i valori dell'oggetto da smembrare
@@ -73,51 +167,178 @@ namespace lidar_driver {
 		dimension = ld.dimension;
 		resolusion = ld.resolusion;
 		dimScansioni = ld.dimScansioni;
+		dimBuffer = ld.dimBuffer;
+		potenzaDi2 = ld.potenzaDi2;
+		scansioniInserite = ld.scansioniInserite;
+		scansioniPerse = ld.scansioniPerse;
+		filtri = ld.filtri;
+		filtriAttivi = ld.filtriAttivi;
+		statisticheAttive = ld.statisticheAttive;
+		misurePerSettore = ld.misurePerSettore;
+		numeroSettori = ld.numeroSettori;
+		formato = ld.formato;
+		scala = ld.scala;
+		dimCampione = ld.dimCampione;
+		risorsa = ld.risorsa;
+		metriche = ld.metriche;
 
-		// la funzione swap scambia i riferimenti dei dati tra i due vettori
-		secia.swap(ld.secia);
+		// la funzione swap scambia i riferimenti dei dati tra i due vettori (anche le generazioni,
+		// così le viste già create seguono i dati nel nuovo oggetto)
+		secia = std::move(ld.secia);
+		ld.secia.clear();
+		generazioni.swap(ld.generazioni);
+		tempi.swap(ld.tempi);
+		sequenze.swap(ld.sequenze);
+		tabelle = ld.tabelle;
+		statistiche.swap(ld.statistiche);
+		diario = std::move(ld.diario);
 
 		// svuoto l'oggetto smembrato
 		ld.clear_buffer();
 	}
 
-	/* Funzione new_scan(vector<double> v):
-		1. se la dimensione del vettore fornito non è quella richiesta, il vettore viene modificato
-		   con la funzione resize come richiesto dalle specifiche
-		2. il vettore viene inserito nel buffer con la funzione swap:
-			- il vettore da inserire e il vettore nella secia si scambiano i riferimenti dei dati
-			  per cui 0 copie :)
-			- il vettore nella secia conterrà i dati della scansione da inserire e il vettore-argomento
-			  conterrà i vecchi dati del vettore nella secia 
-			- al termine della funzione viene invocato il distruttore sul vettore-argomento, così
-			  vengono eliminati i vecchi dati sovrascritti, per cui 0 memory leak :)
-		3. vengono opportunamente incrementati gli indici di posizione e la dimensione occupata
-		
+	/* Funzione new_scan(span<const double> v):
+		1. si prepara lo slot in cui scrivere con prossimo_slot, che aggiorna indici e dimensione
+		2. la scansione viene copiata direttamente nel suo slot del buffer:
+			- se è più lunga di dimScansioni viene troncata, se è più corta le misure mancanti
+			  vengono messe a 0, come farebbe la funzione resize di std::vector richiesta dalle
+			  specifiche, ma senza riallocare niente
+			- se lo slot non è condiviso con una copia del driver viene riusato, per cui 0
+			  allocazioni :); se lo è (c'è un'istantanea che lo vede ancora) slot_scrivibile ne
+			  alloca uno nuovo dalla risorsa del driver (copy-on-write)
+			- le misure vengono convertite nel formato del buffer durante la copia
+
 		Osservazioni/scelte implementative:
-		1. ricevo il vettore da inserire come copia per due motivi:
-			- non vogliamo alterare il vettore della funzione chiamante perché non si sa mai cosa
-			  potrebbe voler fare l'utente dopo averlo inserito nel buffer
-			- vogliamo tenere distinti il vettore della funzione chiamante e quello nel buffer per
-			  evitare che ad un certo punto non si possa più accedere al vettore nel buffer perché
-			  è stato invocato il suo distruttore nella funzione chiamante per qualsiasi vago motivo
-		2. sappiamo che passando il vettore per reference (non const) è possibile effettuare l'inserimento
-		   in maniera molto efficiente con 0 copie, ma ci sembrava più corretto e user-proof farlo per copia
-		
+		1. la scansione viene sempre copiata nel buffer, così il vettore (o il pacchetto) del
+		   chiamante rimane intatto e può essere riusato o distrutto senza problemi
+		2. ricevendo uno span la copia è una sola, direttamente dai dati del chiamante allo slot,
+		   qualunque sia il contenitore di partenza (vector, array, pacchetto grezzo)
 	*/
-	void LidarDriver::new_scan(std::vector<double> v) {
-		// Si verifica se il vettore fornito rispetta le condizioni nel numero di elementi, nel caso
-		// il vettore viene modificato dalla funzione resize di std::vector;
-		if (v.size() != dimScansioni)
-			v.resize(dimScansioni, 0);
+	void LidarDriver::new_scan(std::span<const double> v) {
+		new_scan(v, tempo_attuale(), scansioniInserite);
+	}
+
+	/* Funzione new_scan(span<const double> v, long long timestamp):
+		- come new_scan(span), ma il timestamp della scansione (in ns, non minore di quello della
+		  scansione precedente, altrimenti viene lanciata "TimestampIndrioError") viene passato dal
+		  chiamante, ad esempio quello dato dallo strumento
+	*/
+	void LidarDriver::new_scan(std::span<const double> v, long long timestamp) {
+		new_scan(v, timestamp, scansioniInserite);
+	}
 
-		// INSERIMENTO VETTORE
+	/* Funzione new_scan(span<const double> v, long long timestamp, unsigned long long sequenza):
+		- come new_scan(span), con timestamp e numero di sequenza passati dal chiamante; le scansioni
+		  inserite dopo senza sequenza continuano la numerazione da questa
+		- è la versione usata da tutte le altre
+		- se il timestamp è minore di quello dell'ultima scansione nel buffer viene lanciata
+		  l'eccezione "TimestampIndrioError" (vedi controlla_tempo) e la scansione non viene inserita
+	*/
+	void LidarDriver::new_scan(std::span<const double> v, long long timestamp, unsigned long long sequenza) {
+		DURATA_LIDAR(OperazioneLidar::NEW_SCAN);
+		controlla_tempo(timestamp);
+		unsigned char *dest = prossimo_slot(timestamp, sequenza);
+
+		// Si copia la scansione nello slot: le misure in più vengono scartate, quelle mancanti
+		// vengono messe a 0 (in tutti i formati lo 0 ha tutti i byte a zero)
+		int daCopiare = (v.size() < static_cast<std::size_t>(dimScansioni)) ? static_cast<int>(v.size()) : dimScansioni;
+		METRICHE_LIDAR(conta(ContatoreLidar::COMPLETATE, v.size() < static_cast<std::size_t>(dimScansioni)));
+		METRICHE_LIDAR(conta(ContatoreLidar::TRONCATE, v.size() > static_cast<std::size_t>(dimScansioni)));
+		codifica_campioni(v.data(), daCopiare, dest, formato, scala);
+		std::memset(dest + daCopiare * dimCampione, 0, (dimScansioni - daCopiare) * dimCampione);
+		filtra(dest);
+		calcola_statistiche(elPiNovo);
+		registra(elPiNovo);
+	}
+
+	/* Funzione new_scan(const vector<double> &v):
+		- come new_scan(span), il vettore viene ricevuto per reference costante: non viene copiato
+		  nel passaggio del parametro (né per gli lvalue né per gli rvalue) e non viene modificato
+	*/
+	void LidarDriver::new_scan(const std::vector<double> &v) {
+		new_scan(std::span<const double>(v));
+	}
+
+	/* Funzione new_scans(span<const double> pacchetto, int misurePerScansione):
+		1. il pacchetto contiene più scansioni una dopo l'altra, ognuna da misurePerScansione misure
+		   (l'ultima può essere incompleta); ogni scansione viene troncata o completata con zeri
+		2. se le scansioni sono più di dimBuffer, quelle più vecchie verrebbero comunque sovrascritte,
+		   per cui vengono copiate solo le ultime dimBuffer
+		3. indici di posizione e dimensione vengono aggiornati una volta sola alla fine, con lo stesso
+		   risultato che si avrebbe chiamando new_scan per ogni scansione
+		4. se c'è un diario tutte le scansioni vanno registrate, per cui non se ne salta nessuna
+		5. tutte le scansioni del pacchetto hanno lo stesso timestamp (l'istante della chiamata, come
+		   in new_scan mai minore di quello dell'ultima scansione, vedi tempo_attuale) e
+		   numeri di sequenza consecutivi; quelle che sovrascrivono scansioni non lette vengono contate
+		   tra le perse
+	*/
+	void LidarDriver::new_scans(std::span<const double> pacchetto, int misurePerScansione) {
+		if (misurePerScansione <= 0)
+			throw DimensionOutputSbagliataError();
+
+		int quante = (pacchetto.size() + misurePerScansione - 1) / misurePerScansione;
+		if (quante == 0)
+			return;
+
+		// slot della prima scansione del pacchetto, come in prossimo_slot
+		int primo = (dimension == 0) ? elPiNovo : avanza(elPiNovo, 1);
+		int salta = (quante > dimBuffer && !diario) ? quante - dimBuffer : 0;
+		long long timestamp = tempo_attuale();
+
+		for (int j = salta; j < quante; j++) {
+			int indice = avanza(primo, j % dimBuffer);
+			unsigned char *dest = slot_scrivibile(indice);
+			std::span<const double> v = pacchetto.subspan(j * misurePerScansione);
+			int daCopiare = std::min({v.size(), static_cast<std::size_t>(misurePerScansione), static_cast<std::size_t>(dimScansioni)});
+			METRICHE_LIDAR(conta(ContatoreLidar::COMPLETATE, daCopiare < dimScansioni));
+			METRICHE_LIDAR(conta(ContatoreLidar::TRONCATE, misurePerScansione > dimScansioni && v.size() > static_cast<std::size_t>(dimScansioni)));
+			codifica_campioni(v.data(), daCopiare, dest, formato, scala);
+			std::memset(dest + daCopiare * dimCampione, 0, (dimScansioni - daCopiare) * dimCampione);
+			generazioni[indice]++;
+			tempi[indice] = timestamp;
+			sequenze[indice] = scansioniInserite + j;
+			filtra(dest);
+			calcola_statistiche(indice);
+			registra(indice);
+		}
+
+		// aggiornamento unico degli indici: se il buffer si riempie, la più vecchia è quella subito
+		// dopo la più nuova, altrimenti elPiVecio non si è mosso
+		elPiNovo = avanza(primo, (quante - 1) % dimBuffer);
+		scansioniInserite += quante;
+		scansioniPerse += (dimension + quante > dimBuffer) ? dimension + quante - dimBuffer : 0;
+		METRICHE_LIDAR(conta(ContatoreLidar::INSERITE, quante));
+		METRICHE_LIDAR(conta(ContatoreLidar::SOVRASCRITTE, (dimension + quante > dimBuffer) ? dimension + quante - dimBuffer : 0));
+		dimension = (dimension + quante > dimBuffer) ? dimBuffer : dimension + quante;
+		elPiVecio = (dimension == dimBuffer) ? avanza(elPiNovo, 1) : elPiVecio;
+	}
+
+	/* Funzione prossimo_slot(long long timestamp, unsigned long long sequenza):
+		1. fa avanzare gli indici di posizione e la dimensione occupata come se fosse stata inserita
+		   una nuova scansione e incrementa la generazione del nuovo slot
+		2. salva timestamp e sequenza della nuova scansione nello slot; se il buffer era pieno la
+		   scansione più vecchia viene sovrascritta senza essere stata letta e viene contata come persa
+		3. restituisce il puntatore allo slot, in cui il chiamante deve scrivere tutte le dimScansioni
+		   misure della nuova scansione (già convertite nel formato del buffer)
+
+		Osservazioni:
+		- è usata da tutte le versioni di new_scan, così la gestione degli indici sta in un posto solo
+		- prossimo_slot() senza parametri (nell'header) usa tempo_attuale() e la sequenza successiva
+	*/
+	unsigned char *LidarDriver::prossimo_slot(long long timestamp, unsigned long long sequenza) {
 		// elPiNovo punta all'ultimo elemento inserito, bisogna dunque farlo avanzare tranne nel caso
 		// in cui dimension = 0, in tal caso è sufficiente conservare l'indice attuale e procedere con
 		// l'inserimento. Occorre prevedere il caso in cui, incrementando, l'indice elPiNovo giunga al
 		// termine del buffer, in questo caso viene azzerato per ricominciare gli inserimenti dall'inizio
 		// del buffer.
-		elPiNovo = (dimension == 0) ? elPiNovo : (elPiNovo + 1) % BUFFER_DIM;
-		secia[elPiNovo].swap(v);
+		elPiNovo = (dimension == 0) ? elPiNovo : avanza(elPiNovo, 1);
+		generazioni[elPiNovo]++;
+		tempi[elPiNovo] = timestamp;
+		sequenze[elPiNovo] = sequenza;
+		scansioniInserite = sequenza + 1;
+		scansioniPerse += (dimension == dimBuffer);
+		METRICHE_LIDAR(conta(ContatoreLidar::INSERITE));
+		METRICHE_LIDAR(conta(ContatoreLidar::SOVRASCRITTE, dimension == dimBuffer));
 
 		// Ora vanno incrementati l'indice dell'elemento più vecchio e la variabile dimension:
 		//  - L'indice all'elemento più vecchio non viene alterato se il buffer non è pieno, nel caso
@@ -125,12 +346,34 @@ namespace lidar_driver {
 		//    gli elementi più vecchi, è quindi necessario incrementare l'indice elPiVecio;
 		//  - La dimension si incrementa fino ad arrivare al riempimento del buffer, in quel caso il
 		//    valore rimane stabile.
-		elPiVecio = (dimension == BUFFER_DIM) ? (elPiVecio + 1) % BUFFER_DIM : elPiVecio;
-		dimension = (dimension == BUFFER_DIM) ? BUFFER_DIM : dimension + 1;
+		elPiVecio = (dimension == dimBuffer) ? avanza(elPiVecio, 1) : elPiVecio;
+		dimension = (dimension == dimBuffer) ? dimBuffer : dimension + 1;
+
+		return slot_scrivibile(elPiNovo);
 	}
 
-	/* Funzione get_scan():
-		1. viene verificato se il buffer è vuoto, nel caso viene lanciata l'eccezione "NoGheSonVettoriError"
+	/* Funzione slot_scrivibile(int i):
+		- restituisce lo slot i per scriverci una nuova scansione: se lo slot è condiviso con una copia
+		  del driver (o non c'è, in un oggetto smembrato da una move) lo sostituisce con uno nuovo, così
+		  la copia continua a vedere la vecchia scansione
+		- il contenuto di uno slot nuovo non è inizializzato: il chiamante deve scriverlo tutto
+
+		Osservazione:
+		- se use_count() è 1 l'ultima copia che condivideva lo slot è stata distrutta, magari in un
+		  altro thread: la fence acquire fa sì che le sue letture dello slot siano finite prima che
+		  qui lo si sovrascriva (il contatore viene decrementato con un rilascio)
+	*/
+	unsigned char *LidarDriver::slot_scrivibile(int i) {
+		if (secia[i].use_count() != 1)
+			secia[i] = nuovo_slot();
+		else
+			std::atomic_thread_fence(std::memory_order_acquire);
+		return secia[i].get();
+	}
+
+	/* Funzione try_get_scan():
+		1. viene verificato se il buffer è vuoto, nel caso viene restituito l'errore BUFFER_VUOTO
+		   (senza lanciare eccezioni)
 		2. superato il controllo, la dimensione del buffer viene decrementata;
 		3. nella variabile "scoase" ("immondizia") viene salvato l'indice "elPiVecio", che viene
 		   modificato per puntare al successivo elemento presente da più tempo nel buffer;
@@ -140,10 +383,11 @@ namespace lidar_driver {
 		- il vettore non viene effettivamente rimosso dal buffer, ma si "marca" la cella come libera
 		  per un'eventuale nuovo inserimento
 	*/
-	std::vector<double> LidarDriver::get_scan() {
-		// Si verifica se ci sono scansioni, in caso contrario viene lanciata l'eccezione "NoGheSonVettoriError".
+	EsitoLidar<std::vector<double>> LidarDriver::try_get_scan() {
+		DURATA_LIDAR(OperazioneLidar::GET_SCAN);
+		// Si verifica se ci sono scansioni, in caso contrario viene restituito l'errore.
 		if (dimension == 0)
-			throw NoGheSonVettoriError();
+			return ErroreLidar::BUFFER_VUOTO;
 
 		// Se il vettore non è vuoto, contiene almeno un elemento, si può quindi decrementare dimension
 		dimension--;
@@ -152,42 +396,478 @@ namespace lidar_driver {
 		// Risulta necessario decrementare la variabile prima di ritornare. Salvo l'indice attuale
 		// in un'opportuna variabile, in modo da procedere poi con il ritorno del vettore di interesse.
 		int scoase = elPiVecio;
-		elPiVecio = (dimension != 0) ? (elPiVecio + 1) % BUFFER_DIM : elPiVecio;
-		return secia[scoase];
+		elPiVecio = (dimension != 0) ? avanza(elPiVecio, 1) : elPiVecio;
+		std::vector<double> v(dimScansioni);
+		decodifica_campioni(slot(scoase), dimScansioni, v.data(), formato, scala);
+		return v;
 	}
 
-	/* Funzione get_last():
+	/* Funzione get_scan():
+		- come try_get_scan, ma se il buffer è vuoto viene lanciata l'eccezione "NoGheSonVettoriError"
+	*/
+	std::vector<double> LidarDriver::get_scan() {
+		EsitoLidar<std::vector<double>> esito = try_get_scan();
+		if (!esito) {
+			METRICHE_LIDAR(conta_errore(OperazioneLidar::GET_SCAN));
+			lancia(esito.error());
+		}
+		return std::move(*esito);
+	}
+
+	/* Funzione try_get_scan_view():
+		- come try_get_scan rimuove dal buffer la scansione più vecchia, ma invece di copiarla
+		  restituisce una vista sul suo slot (o l'errore BUFFER_VUOTO)
+		- lo slot è marcato come libero, per cui la vista rimane valida solo finché una new_scan non
+		  lo sovrascrive (si controlla con VistaScansione::valida())
+	*/
+	EsitoLidar<VistaScansione> LidarDriver::try_get_scan_view() noexcept {
+		if (dimension == 0)
+			return ErroreLidar::BUFFER_VUOTO;
+
+		dimension--;
+		int scoase = elPiVecio;
+		elPiVecio = (dimension != 0) ? avanza(elPiVecio, 1) : elPiVecio;
+		return VistaScansione(slot(scoase), dimScansioni, &generazioni[scoase], formato, scala);
+	}
+
+	/* Funzione get_scan_view():
+		- come try_get_scan_view, ma se il buffer è vuoto viene lanciata l'eccezione "NoGheSonVettoriError"
+	*/
+	VistaScansione LidarDriver::get_scan_view() {
+		EsitoLidar<VistaScansione> esito = try_get_scan_view();
+		if (!esito) {
+			METRICHE_LIDAR(conta_errore(OperazioneLidar::GET_SCAN));
+			lancia(esito.error());
+		}
+		return *esito;
+	}
+
+	/* Funzione try_get_scan(vector<double> &v):
+		- come try_get_scan, ma la scansione viene copiata nel vettore passato come parametro, e
+		  restituisce false (senza toccare il vettore) se il buffer è vuoto
+		- se il vettore ha già la capacità necessaria (es. viene riusato a ogni ciclo) non viene
+		  allocato niente: una sola copia dal buffer al vettore del chiamante
+
+		Osservazione:
+		- gli slot sono blocchi di byte nel formato del buffer (anche FLOAT o UINT16) dati dalla
+		  risorsa del driver e condivisi con le copie, per cui non è possibile "cedere" lo slot al
+		  chiamante come vector con una move; questa è l'alternativa che non alloca
+	*/
+	bool LidarDriver::try_get_scan(std::vector<double> &v) {
+		DURATA_LIDAR(OperazioneLidar::GET_SCAN);
+		EsitoLidar<VistaScansione> vista = try_get_scan_view();
+		if (!vista)
+			return false;
+		v.resize(vista->size());
+		vista->copia_in(v.data());
+		return true;
+	}
+
+	/* Funzione get_scan(vector<double> &v):
+		- come try_get_scan(v), ma se il buffer è vuoto viene lanciata l'eccezione "NoGheSonVettoriError"
+	*/
+	void LidarDriver::get_scan(std::vector<double> &v) {
+		if (!try_get_scan(v)) {
+			METRICHE_LIDAR(conta_errore(OperazioneLidar::GET_SCAN));
+			throw NoGheSonVettoriError();
+		}
+	}
+
+	/* Funzione lancia(ErroreLidar errore):
+		- usata dalle funzioni che lanciano eccezioni, scritte sopra le try_: lancia l'eccezione che
+		  corrisponde all'errore dell'esito
+	*/
+	void LidarDriver::lancia(ErroreLidar errore) {
+		switch (errore) {
+			case ErroreLidar::BUFFER_VUOTO:          throw NoGheSonVettoriError();
+			case ErroreLidar::ANGOLO_FORA_DAI_RANGE: throw AngoloForaDaiRangeError();
+		}
+		throw NoGheSonVettoriError();
+	}
+
+	/* Funzione try_get_last():
 		- La funzione restituisce l'ultimo vettore inserito, in caso il buffer sia vuoto viene
-		  lanciata l'eccezione "NoGheSonVettoriError".
+		  restituito l'errore BUFFER_VUOTO (senza lanciare eccezioni).
+	*/
+	EsitoLidar<std::vector<double>> LidarDriver::try_get_last() const {
+		DURATA_LIDAR(OperazioneLidar::GET_LAST);
+		if (dimension == 0)
+			return ErroreLidar::BUFFER_VUOTO;
+		
+		std::vector<double> v(dimScansioni);
+		decodifica_campioni(slot(elPiNovo), dimScansioni, v.data(), formato, scala);
+		return v;
+	}
 
-		- La funzione non è richiesta dalle specifiche, ma viene usata nella helper function
-		  dell'overloading dell'operatore <<
+	/* Funzione get_last():
+		- come try_get_last, ma in caso il buffer sia vuoto viene lanciata l'eccezione
+		  "NoGheSonVettoriError".
 	*/
 	std::vector<double> LidarDriver::get_last() const {
+		EsitoLidar<std::vector<double>> esito = try_get_last();
+		if (!esito) {
+			METRICHE_LIDAR(conta_errore(OperazioneLidar::GET_LAST));
+			lancia(esito.error());
+		}
+		return std::move(*esito);
+	}
+
+	/* Funzione try_get_last_view():
+		- come try_get_last, ma restituisce una vista sullo slot dell'ultima scansione invece di una copia
+	*/
+	EsitoLidar<VistaScansione> LidarDriver::try_get_last_view() const noexcept {
 		if (dimension == 0)
+			return ErroreLidar::BUFFER_VUOTO;
+
+		return VistaScansione(slot(elPiNovo), dimScansioni, &generazioni[elPiNovo], formato, scala);
+	}
+
+	/* Funzione get_last_view():
+		- come try_get_last_view, ma in caso il buffer sia vuoto viene lanciata l'eccezione
+		  "NoGheSonVettoriError"
+	*/
+	VistaScansione LidarDriver::get_last_view() const {
+		EsitoLidar<VistaScansione> esito = try_get_last_view();
+		if (!esito)
+			lancia(esito.error());
+		return *esito;
+	}
+
+	/* Funzione get_view(int k):
+		- restituisce una vista sulla k-esima scansione presente nel buffer, contando dalla più vecchia
+		  (k = 0) alla più nuova (k = size() - 1), senza rimuoverla
+		- se k non corrisponde a nessuna scansione viene lanciata l'eccezione "NoGheSonVettoriError"
+	*/
+	VistaScansione LidarDriver::get_view(int k) const {
+		if (k < 0 || k >= dimension)
 			throw NoGheSonVettoriError();
-		
-		return secia[elPiNovo];
+
+		int i = avanza(elPiVecio, k);
+		return VistaScansione(slot(i), dimScansioni, &generazioni[i], formato, scala);
+	}
+
+	/* Funzione size():
+		- restituisce il numero di scansioni presenti nel buffer
+	*/
+	int LidarDriver::size() const {
+		return dimension;
+	}
+
+	/* Funzione get_resolution():
+		- restituisce la risoluzione angolare dello strumento
+	*/
+	double LidarDriver::get_resolution() const {
+		return resolusion;
+	}
+
+	/* Funzione get_dim_scansioni():
+		- restituisce il numero di misure di ogni scansione (da MIN_ANGLE a MAX_ANGLE compresi)
+	*/
+	int LidarDriver::get_dim_scansioni() const {
+		return dimScansioni;
+	}
+
+	/* Funzione get_timestamp(int k):
+		- restituisce il timestamp (ns) della k-esima scansione del buffer, contata come in get_view
+		- se k non corrisponde a nessuna scansione viene lanciata l'eccezione "NoGheSonVettoriError"
+	*/
+	long long LidarDriver::get_timestamp(int k) const {
+		if (k < 0 || k >= dimension)
+			throw NoGheSonVettoriError();
+
+		return tempi[avanza(elPiVecio, k)];
+	}
+
+	/* Funzione get_sequenza(int k):
+		- restituisce il numero di sequenza della k-esima scansione del buffer, contata come in get_view
+		- se k non corrisponde a nessuna scansione viene lanciata l'eccezione "NoGheSonVettoriError"
+	*/
+	unsigned long long LidarDriver::get_sequenza(int k) const {
+		if (k < 0 || k >= dimension)
+			throw NoGheSonVettoriError();
+
+		return sequenze[avanza(elPiVecio, k)];
+	}
+
+	/* Funzione trova_vicina(long long t):
+		1. con una ricerca binaria (primo_da) trova la prima scansione con timestamp >= t
+		2. restituisce la posizione (come in get_view) tra quella e la precedente, quella con il
+		   timestamp più vicino a t (a parità, la più vecchia)
+		3. se il buffer è vuoto viene lanciata l'eccezione "NoGheSonVettoriError"
+	*/
+	int LidarDriver::trova_vicina(long long t) const {
+		if (dimension == 0)
+			throw NoGheSonVettoriError();
+
+		int k = primo_da(t);
+		if (k == dimension)
+			return dimension - 1;
+		if (k == 0)
+			return 0;
+		return (t - tempi[avanza(elPiVecio, k - 1)] <= tempi[avanza(elPiVecio, k)] - t) ? k - 1 : k;
+	}
+
+	/* Funzione trova_intervallo(long long t0, long long t1):
+		- restituisce le posizioni (come in get_view) [prima, ultima + 1) delle scansioni con
+		  timestamp compreso tra t0 e t1 (estremi inclusi), trovate con due ricerche binarie
+		- se non ce ne sono le due posizioni sono uguali (ciclo for da prima a ultima + 1 vuoto)
+	*/
+	std::pair<int, int> LidarDriver::trova_intervallo(long long t0, long long t1) const {
+		int prima = primo_da(t0);
+		int dopo = (t1 == LLONG_MAX) ? dimension : primo_da(t1 + 1);
+		return {prima, (dopo > prima) ? dopo : prima};
+	}
+
+	/* Funzione scansioni_perse():
+		- restituisce il numero di scansioni sovrascritte da new_scan (buffer pieno) prima di essere
+		  state lette con get_scan
+	*/
+	unsigned long long LidarDriver::scansioni_perse() const {
+		return scansioniPerse;
+	}
+
+	/* Funzione to_points(span<double> x, span<double> y):
+		- converte l'ultima scansione inserita in punti del piano dello strumento (misura * coseno,
+		  misura * seno dell'angolo) e scrive le coordinate in x e y (formato "struttura di array",
+		  comodo per i cicli vettorizzati di chi usa i punti)
+		- se il buffer è vuoto viene lanciata l'eccezione "NoGheSonVettoriError", se uno dei due span
+		  ha meno di dimScansioni misure "DimensionOutputSbagliataError"
+		- le misure a 0 (mancanti o riempimento di new_scan) diventano il punto (0, 0)
+	*/
+	void LidarDriver::to_points(std::span<double> x, std::span<double> y) const {
+		to_points(dimension - 1, x, y);
+	}
+
+	/* Funzione to_points(int k, span<double> x, span<double> y):
+		- come to_points(x, y), ma per la k-esima scansione del buffer contando dalla più vecchia
+		  (k = 0) alla più nuova (k = size() - 1), come get_view
+	*/
+	void LidarDriver::to_points(int k, std::span<double> x, std::span<double> y) const {
+		if (k < 0 || k >= dimension)
+			throw NoGheSonVettoriError();
+		if (x.size() < static_cast<std::size_t>(dimScansioni) || y.size() < static_cast<std::size_t>(dimScansioni))
+			throw DimensionOutputSbagliataError();
+
+		punti(slot(avanza(elPiVecio, k)), x.data(), y.data());
+	}
+
+	/* Funzione punti(const unsigned char *dati, double *x, double *y):
+		1. con il formato DOUBLE le misure vengono lette direttamente dallo slot, altrimenti prima
+		   vengono convertite in double dentro x (decodifica_campioni)
+		2. un unico ciclo moltiplica ogni misura per coseno e seno dalle tabelle: non ci sono
+		   chiamate a funzione né dipendenze tra le iterazioni, per cui il compilatore lo vettorizza
+	*/
+	void LidarDriver::punti(const unsigned char *dati, double *x, double *y) const {
+		const double *misure = reinterpret_cast<const double *>(dati);
+		if (formato != FormatoCampioni::DOUBLE) {
+			decodifica_campioni(dati, dimScansioni, x, formato, scala);
+			misure = x;
+		}
+
+		const double *c = tabelle->coseni.data();
+		const double *s = tabelle->seni.data();
+		for (int j = 0; j < dimScansioni; j++) {
+			double r = misure[j];
+			y[j] = r * s[j];
+			x[j] = r * c[j];
+		}
+	}
+
+	/* Funzione larghezza_settore():
+		- restituisce la larghezza dei settori delle statistiche in gradi, cioè quella passata a
+		  set_statistiche arrotondata a un numero intero di misure
+	*/
+	double LidarDriver::larghezza_settore() const {
+		return misurePerSettore * resolusion;
+	}
+
+	/* Funzione statistiche_attive():
+		- restituisce true se new_scan sta calcolando le statistiche (set_statistiche(true, ...))
+	*/
+	bool LidarDriver::statistiche_attive() const {
+		return statisticheAttive;
+	}
+
+	/* Funzione scan_stats():
+		- restituisce le statistiche dell'ultima scansione inserita, calcolate da new_scan
+		- se le statistiche non sono attive viene lanciata l'eccezione "StatisticheSpenteError", se il
+		  buffer è vuoto "NoGheSonVettoriError"
+	*/
+	const StatisticheScansione &LidarDriver::scan_stats() const {
+		return scan_stats(dimension - 1);
+	}
+
+	/* Funzione scan_stats(int k):
+		- come scan_stats(), per la k-esima scansione del buffer (come get_view)
+	*/
+	const StatisticheScansione &LidarDriver::scan_stats(int k) const {
+		if (!statisticheAttive)
+			throw StatisticheSpenteError();
+		if (k < 0 || k >= dimension)
+			throw NoGheSonVettoriError();
+
+		return statistiche[avanza(elPiVecio, k) * (numeroSettori + 1)];
+	}
+
+	/* Funzione sector_stats(int k):
+		- restituisce le statistiche di tutti i settori della k-esima scansione del buffer (come
+		  get_view): l'elemento s è il settore che inizia all'angolo s * larghezza_settore()
+		- lancia le stesse eccezioni di scan_stats
+	*/
+	std::span<const StatisticheScansione> LidarDriver::sector_stats(int k) const {
+		const StatisticheScansione &tutta = scan_stats(k);
+		return std::span<const StatisticheScansione>(&tutta + 1, numeroSettori);
+	}
+
+	/* Funzione closest_obstacle():
+		- restituisce distanza e angolo (in quest'ordine) dell'ostacolo più vicino nell'ultima
+		  scansione, cioè della misura valida più piccola; se non ci sono misure valide sono 0 e 0
+		- lancia le stesse eccezioni di scan_stats
+	*/
+	std::pair<double, double> LidarDriver::closest_obstacle() const {
+		const StatisticheScansione &st = scan_stats();
+		return {st.minimo, st.angoloMinimo};
+	}
+
+	/* Funzione primo_da(long long t):
+		- ricerca binaria sull'ordine del buffer (dalla più vecchia alla più nuova, in cui i timestamp
+		  sono non decrescenti): restituisce la posizione della prima scansione con timestamp >= t, o
+		  dimension se non ce ne sono
+	*/
+	int LidarDriver::primo_da(long long t) const {
+		int basso = 0, alto = dimension;
+		while (basso < alto) {
+			int medio = basso + (alto - basso) / 2;
+			if (tempi[avanza(elPiVecio, medio)] < t)
+				basso = medio + 1;
+			else
+				alto = medio;
+		}
+		return basso;
+	}
+
+	/* Funzione adesso():
+		- funzione statica che restituisce l'istante attuale in ns dell'orologio monotono
+		  (std::chrono::steady_clock), usato come timestamp delle scansioni se non viene passato
+	*/
+	long long LidarDriver::adesso() {
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	/* Funzione tempo_attuale():
+		- il timestamp delle scansioni inserite senza timestamp: l'istante attuale (adesso), ma mai
+		  minore di quello dell'ultima scansione nel buffer, che può venire da un altro orologio (quello
+		  dello strumento passato a new_scan, o quello di un diario riaperto)
+	*/
+	long long LidarDriver::tempo_attuale() const {
+		long long t = adesso();
+		return (dimension > 0 && t < tempi[elPiNovo]) ? tempi[elPiNovo] : t;
+	}
+
+	/* Funzione controlla_tempo(long long timestamp):
+		- controlla un timestamp passato dal chiamante (new_scan) o letto da un file (read_scan,
+		  read_buffer) prima di inserire la scansione: se è minore di quello dell'ultima scansione nel
+		  buffer viene lanciata l'eccezione "TimestampIndrioError" e il buffer non viene toccato
+		- serve perché le ricerche per tempo (trova_vicina, trova_intervallo) sono binarie: una sola
+		  scansione fuori ordine darebbe risultati sbagliati finché resta nel buffer
+	*/
+	void LidarDriver::controlla_tempo(long long timestamp) const {
+		if (dimension > 0 && timestamp < tempi[elPiNovo])
+			throw TimestampIndrioError();
 	}
 
 	/* Funzione clear_buffer():
 		1. reimposta gli indici di posizione e la dimensione
-		2. rialloco il vettore del buffer
+		2. se serve, rialloco il vettore del buffer
 
-		Osservazione:
-		- non effettuo controlli se il buffer è vuoto, perché anche se dimension = 0, non è detto
-		  che tutti i vettori 
+		Osservazioni:
+		- non serve cancellare i dati delle scansioni: con dimension = 0 nessuno slot viene più
+		  letto e new_scan sovrascrive sempre tutto lo slot, basta incrementare le generazioni per
+		  invalidare le viste
+		- gli slot e i vettori restano allocati, per cui svuotare e riempire di nuovo il buffer non
+		  alloca niente; per restituire la memoria degli slot vuoti c'è shrink_to_fit
+		- il blocco va riallocato solo se non ha la dimensione giusta, cioè se l'oggetto è stato
+		  "smembrato" da una move e si è ritrovato con il buffer di un altro oggetto (lo stesso vale
+		  per le tabelle di to_points)
 	 */
 	void LidarDriver::clear_buffer() {
 		// Reimposta le variabili dell'oggetto
 		elPiNovo = elPiVecio = dimension = 0;
 
-		// rialloco il vettore del buffer come nel costruttore
-		std::vector<std::vector<double>>(BUFFER_DIM).swap(secia);
+		// gli slot restano quelli di prima; in un oggetto smembrato da una move non ci sono, e vengono
+		// allocati da slot_scrivibile quando servono
+		secia.resize(dimBuffer);
+		if (static_cast<int>(generazioni.size()) < dimBuffer)
+			generazioni.resize(dimBuffer);	// mai più corta: le viste puntano ai suoi elementi
+		tempi.resize(dimBuffer);
+		sequenze.resize(dimBuffer);
+		if (!tabelle)
+			calcola_tabelle();
+		if (statisticheAttive)
+			statistiche.resize(dimBuffer * (numeroSettori + 1));
+
+		// le scansioni non ci sono più: le viste ancora in giro non sono più valide
+		for (unsigned long long &g : generazioni)
+			g++;
 	}
 
-	/* Funzione get_distance(double):
-		1. controlla che esista il valore da restituire: buffer non vuoto e angolo valido
+	/* Funzione rinnova_generazioni():
+		- invalida tutte le viste del driver quando gli slot cambiano posto o contenuto in blocco
+		  (set_dim_buffer, assegnamento di copia): ogni generazione diventa più grande di tutte quelle
+		  che c'erano, così nessuna vista già creata può tornare valida con gli incrementi successivi
+		- allunga le generazioni fino a dimBuffer, ma non le accorcia mai: sono in una deque, che
+		  aggiungendo in fondo non sposta gli elementi, per cui le viste vecchie non puntano mai a
+		  memoria liberata
+	*/
+	void LidarDriver::rinnova_generazioni() {
+		unsigned long long massima = 0;
+		for (unsigned long long g : generazioni)
+			massima = std::max(massima, g);
+		if (static_cast<int>(generazioni.size()) < dimBuffer)
+			generazioni.resize(dimBuffer);
+		std::fill(generazioni.begin(), generazioni.end(), massima + 1);
+	}
+
+	/* Funzione calcola_tabelle():
+		- calcola coseno e seno dell'angolo di ogni misura (indice * resolusion, in gradi) e li salva
+		  nelle tabelle usate da to_points
+		- viene chiamata dal costruttore (e da clear_buffer se le tabelle non ci sono); dopo non
+		  cambiano più, perché risoluzione e numero di misure restano quelli del costruttore, per cui
+		  le copie del driver le condividono
+	*/
+	void LidarDriver::calcola_tabelle() {
+		std::shared_ptr<TabellePunti> t = std::make_shared<TabellePunti>();
+		t->coseni.resize(dimScansioni);
+		t->seni.resize(dimScansioni);
+		for (int j = 0; j < dimScansioni; j++) {
+			double angolo = (MIN_ANGLE + j * resolusion) * std::numbers::pi / 180;
+			t->coseni[j] = std::cos(angolo);
+			t->seni[j] = std::sin(angolo);
+		}
+		tabelle = std::move(t);
+	}
+
+	/* Funzione nuovo_slot():
+		- alloca uno slot per una scansione (dimScansioni misure nel formato del buffer), allineato
+		  alla cache line come i buffer di AllocatoreAllineato; lo slot viene liberato quando non lo
+		  usa più nessuna copia del driver
+		- sia lo slot che il blocco di controllo dello shared_ptr vengono presi dalla risorsa del
+		  driver (vedi set_risorsa): con una RiservaSlot, una volta riservati abbastanza blocchi,
+		  nuovo_slot non tocca più l'heap
+	*/
+	std::shared_ptr<unsigned char> LidarDriver::nuovo_slot() const {
+		std::size_t byte = static_cast<std::size_t>(dimScansioni) * dimCampione;
+		std::pmr::memory_resource *r = risorsa;
+		return std::shared_ptr<unsigned char>(static_cast<unsigned char *>(r->allocate(byte, ALLINEAMENTO_SLOT)),
+		                                      [r, byte](unsigned char *p) { r->deallocate(p, byte, ALLINEAMENTO_SLOT); },
+		                                      std::pmr::polymorphic_allocator<unsigned char>(r));
+	}
+
+	/* Funzione try_get_distance(double):
+		1. controlla che esista il valore da restituire: buffer non vuoto e angolo valido (come in
+		   get_distances, anche un angolo NaN non è valido), altrimenti restituisce l'errore
+		   BUFFER_VUOTO o ANGOLO_FORA_DAI_RANGE senza lanciare eccezioni
 		2. trova l'indice dell'elemento cercato (conversione angolo -> indice)
 		3. restituisce il valore cercato
 
@@ -217,23 +897,875 @@ namespace lidar_driver {
 			correttamente la divisione per fare ciò usiamo la funzione double std::round(double) e un
 			cast esplicito da double a int
 	 */
-	double LidarDriver::get_distance(double angolo) const {
+	EsitoLidar<double> LidarDriver::try_get_distance(double angolo) const noexcept {
+		DURATA_LIDAR(OperazioneLidar::GET_DISTANCE);
 		// fa gli eventuali controlli necessari
 		if (dimension == 0)
-			throw NoGheSonVettoriError();
-		if (angolo < MIN_ANGLE || angolo > MAX_ANGLE)
-			throw AngoloForaDaiRangeError();
+			return ErroreLidar::BUFFER_VUOTO;
+		if (!(angolo >= MIN_ANGLE && angolo <= MAX_ANGLE))
+			return ErroreLidar::ANGOLO_FORA_DAI_RANGE;
 		
 		// conversione angolo -> indice come descritto sopra
 		int index = static_cast<int>(std::round(angolo / resolusion));
 
-		// restituisce quanto cercato
-		return secia[elPiNovo][index];
+		// con risoluzioni che non dividono 180 (es. 0.65) l'angolo 180 si arrotonderebbe a un indice
+		// oltre l'ultima misura: in quel caso la misura più vicina è l'ultima
+		if (index >= dimScansioni)
+			index = dimScansioni - 1;
+
+		// restituisce quanto cercato, convertito in double
+		return leggi_campione(slot(elPiNovo), index, formato, scala);
+	}
+
+	/* Funzione get_distance(double):
+		- come try_get_distance, ma se il buffer è vuoto o l'angolo non è valido vengono lanciate le
+		  eccezioni "NoGheSonVettoriError" e "AngoloForaDaiRangeError"
+	*/
+	double LidarDriver::get_distance(double angolo) const {
+		EsitoLidar<double> esito = try_get_distance(angolo);
+		if (!esito) {
+			METRICHE_LIDAR(conta_errore(OperazioneLidar::GET_DISTANCE));
+			lancia(esito.error());
+		}
+		return *esito;
+	}
+
+	/* Funzione get_distances(span<const double> angoli, span<double> out):
+		1. fa i controlli una sola volta per tutti gli angoli: buffer non vuoto, out abbastanza grande
+		   e tutti gli angoli nel range (altrimenti non viene scritto niente in out)
+		2. converte gli angoli in indici e legge le misure dell'ultima scansione con raccogli_distanze
+
+		Osservazione:
+		- il controllo sugli angoli è scritto come !(angolo >= MIN && angolo <= MAX) così anche un
+		  angolo NaN viene rifiutato invece di diventare un indice a caso
+	*/
+	void LidarDriver::get_distances(std::span<const double> angoli, std::span<double> out) const {
+		if (dimension == 0)
+			throw NoGheSonVettoriError();
+		if (out.size() < angoli.size())
+			throw DimensionOutputSbagliataError();
+
+		bool foraDalRange = false;
+		for (double angolo : angoli)
+			foraDalRange |= !(angolo >= MIN_ANGLE && angolo <= MAX_ANGLE);
+		if (foraDalRange)
+			throw AngoloForaDaiRangeError();
+
+		raccogli_distanze(angoli.data(), out.data(), angoli.size());
+	}
+
+	/* Funzione get_distances(double inizio, double fine, double passo, span<double> out):
+		1. controlla che il settore sia valido: inizio e fine nel range e passo positivo
+		2. gli angoli del settore sono inizio, inizio + passo, inizio + 2*passo, ... fino a fine compreso
+		3. gli angoli vengono generati a blocchi in un piccolo array nello stack e passati a
+		   raccogli_distanze, così non serve allocare il vettore degli angoli
+		4. restituisce il numero di misure scritte in out
+
+		Osservazione:
+		- il numero di angoli è calcolato con una piccola tolleranza, così ad esempio il settore
+		  [0, 1] con passo 0.1 comprende anche l'angolo 1 nonostante gli errori di arrotondamento
+		- se gli angoli non stanno in out (anche con un passo così piccolo che il loro numero non
+		  sarebbe rappresentabile come int) lancia DimensionOutputSbagliataError
+	*/
+	int LidarDriver::get_distances(double inizio, double fine, double passo, std::span<double> out) const {
+		if (dimension == 0)
+			throw NoGheSonVettoriError();
+		if (!(inizio >= MIN_ANGLE && inizio <= MAX_ANGLE) || !(fine >= inizio && fine <= MAX_ANGLE))
+			throw AngoloForaDaiRangeError();
+		if (!(passo > 0))
+			throw DimensionOutputSbagliataError();
+
+		// il conteggio resta double finché non si sa che sta in out: con un passo piccolissimo
+		// supererebbe il range di int
+		double conteggio = std::floor((fine - inizio) / passo + 1e-9) + 1;
+		if (!(conteggio <= static_cast<double>(out.size())))
+			throw DimensionOutputSbagliataError();
+		int n = static_cast<int>(conteggio);
+
+		constexpr int BLOCCO{256};
+		double angoli[BLOCCO];
+		for (int i = 0; i < n; i += BLOCCO) {
+			int quanti = (n - i < BLOCCO) ? n - i : BLOCCO;
+			for (int j = 0; j < quanti; j++) {
+				// l'ultimo angolo potrebbe superare fine di pochissimo per gli arrotondamenti
+				double angolo = inizio + (i + j) * passo;
+				angoli[j] = (angolo > fine) ? fine : angolo;
+			}
+			raccogli_distanze(angoli, out.data() + i, quanti);
+		}
+		return n;
+	}
+
+	/* Funzione raccogli_distanze(const double *angoli, double *out, int n):
+		- per ogni angolo calcola l'indice come in get_distance e scrive in out la misura corrispondente
+		  dell'ultima scansione, senza fare nessun controllo (già fatti dal chiamante)
+		- con AVX2 lavora su 4 angoli per volta: divisione, arrotondamento e lettura delle misure
+		  (gather) sono fatti con un'unica istruzione vettoriale ciascuno
+		- con SSE2 lavora su 2 angoli per volta (SSE2 non ha il gather, le misure si leggono una a una)
+		- le versioni SIMD sono usate solo con il formato DOUBLE, con gli altri formati ogni misura
+		  viene letta e convertita con leggi_campione
+		- gli angoli rimasti (o tutti, senza SIMD) vengono convertiti uno alla volta
+		- come in get_distance, l'indice non può superare quello dell'ultima misura
+
+		Osservazione:
+		- std::round arrotonda i .5 per eccesso, mentre le istruzioni di conversione SIMD arrotondano
+		  al pari: per avere lo stesso risultato di get_distance si somma 0.5 e si tronca, che per
+		  numeri non negativi è equivalente
+	*/
+	void LidarDriver::raccogli_distanze(const double *angoli, double *out, int n) const {
+		const unsigned char *dati = slot(elPiNovo);
+		const int ultimo = dimScansioni - 1;
+		int i = 0;
+
+		// le versioni SIMD leggono direttamente i double, per cui valgono solo per il formato DOUBLE
+		if (formato == FormatoCampioni::DOUBLE) {
+			const double *misure = reinterpret_cast<const double *>(dati);
+#if defined(__AVX2__)
+			const __m256d res4 = _mm256_set1_pd(resolusion);
+			const __m256d mezzo4 = _mm256_set1_pd(0.5);
+			const __m128i ultimo4 = _mm_set1_epi32(ultimo);
+			for (; i + 4 <= n; i += 4) {
+				__m256d q = _mm256_add_pd(_mm256_div_pd(_mm256_loadu_pd(angoli + i), res4), mezzo4);
+				__m128i indici = _mm_min_epi32(_mm256_cvttpd_epi32(q), ultimo4);
+				_mm256_storeu_pd(out + i, _mm256_i32gather_pd(misure, indici, sizeof(double)));
+			}
+#elif defined(__SSE2__)
+			const __m128d res2 = _mm_set1_pd(resolusion);
+			const __m128d mezzo2 = _mm_set1_pd(0.5);
+			for (; i + 2 <= n; i += 2) {
+				__m128d q = _mm_add_pd(_mm_div_pd(_mm_loadu_pd(angoli + i), res2), mezzo2);
+				__m128i indici = _mm_cvttpd_epi32(q);
+				out[i] = misure[std::min(_mm_cvtsi128_si32(indici), ultimo)];
+				out[i + 1] = misure[std::min(_mm_cvtsi128_si32(_mm_shuffle_epi32(indici, 1)), ultimo)];
+			}
+#endif
+		}
+
+		for (; i < n; i++)
+			out[i] = leggi_campione(dati, std::min(static_cast<int>(angoli[i] / resolusion + 0.5), ultimo), formato, scala);
+	}
+
+	/* Funzione get_distance_interpolata(double angolo):
+		1. fa gli stessi controlli di get_distance
+		2. la posizione dell'angolo tra le misure (angolo / resolusion) in generale cade tra due indici:
+		   la misura restituita è la media delle due pesata con la distanza da ciascuno
+			es: resolusion = 0.5, angolo = 0.6 -> posizione 1.2 -> 0.8 * misura[1] + 0.2 * misura[2]
+		3. se una delle due misure è 0 (misura mancante o riempimento di new_scan) viene restituita
+		   l'altra, per non mescolare una distanza vera con uno 0
+	*/
+	double LidarDriver::get_distance_interpolata(double angolo) const {
+		if (dimension == 0)
+			throw NoGheSonVettoriError();
+		if (!(angolo >= MIN_ANGLE && angolo <= MAX_ANGLE))	// vero anche per NaN
+			throw AngoloForaDaiRangeError();
+
+		double posizione = angolo / resolusion;
+		int prima = static_cast<int>(posizione);
+		if (prima >= dimScansioni - 1)
+			return leggi_campione(slot(elPiNovo), dimScansioni - 1, formato, scala);
+
+		double peso = posizione - prima;
+		double a = leggi_campione(slot(elPiNovo), prima, formato, scala);
+		double b = leggi_campione(slot(elPiNovo), prima + 1, formato, scala);
+		if (a == 0 || b == 0)
+			return (a == 0) ? b : a;
+		return a + (b - a) * peso;
+	}
+
+	/* Funzione get_distance_fusa(double angolo, int ultime, Fusione modo):
+		1. fa gli stessi controlli di get_distance (e ultime deve essere positivo, altrimenti viene
+		   lanciata "DimensionOutputSbagliataError")
+		2. trova l'indice della misura come get_distance e la fonde con fondi su un blocco di una
+		   sola misura
+	*/
+	double LidarDriver::get_distance_fusa(double angolo, int ultime, Fusione modo) const {
+		if (dimension == 0)
+			throw NoGheSonVettoriError();
+		if (!(angolo >= MIN_ANGLE && angolo <= MAX_ANGLE))	// vero anche per NaN
+			throw AngoloForaDaiRangeError();
+		if (ultime < 1)
+			throw DimensionOutputSbagliataError();
+
+		int index = static_cast<int>(std::round(angolo / resolusion));
+		if (index >= dimScansioni)
+			index = dimScansioni - 1;
+
+		double risultato;
+		fondi(index, index + 1, ultime, modo, &risultato);
+		return risultato;
+	}
+
+	/* Funzione get_scan_fusa(int ultime, Fusione modo, span<double> out):
+		- scrive in out la fusione (media o mediana) delle ultime scansioni per tutte le dimScansioni
+		  misure, ad esempio per togliere il rumore prima di usare la scansione
+		- se out ha meno di dimScansioni misure o ultime non è positivo viene lanciata l'eccezione
+		  "DimensionOutputSbagliataError", se il buffer è vuoto "NoGheSonVettoriError"
+	*/
+	void LidarDriver::get_scan_fusa(int ultime, Fusione modo, std::span<double> out) const {
+		if (dimension == 0)
+			throw NoGheSonVettoriError();
+		if (ultime < 1 || out.size() < static_cast<std::size_t>(dimScansioni))
+			throw DimensionOutputSbagliataError();
+
+		fondi(0, dimScansioni, ultime, modo, out.data());
+	}
+
+	/* Funzione fondi(int da, int a, int ultime, Fusione modo, double *out):
+		1. per ogni misura con indice in [da, a) fonde i valori delle ultime scansioni del buffer (al
+		   massimo dimension) e scrive il risultato in out[indice - da]; le misure a 0 non vengono
+		   considerate e se sono tutte 0 il risultato è 0
+		2. le misure vengono elaborate a blocchi di BLOCCO_FUSIONE: per ogni scansione la parte del
+		   blocco viene convertita in double (decodifica_campioni) in un array nello stack, così i dati
+		   del blocco restano nella cache mentre si passa da uno slot all'altro del buffer
+		3. MEDIA: somma e conteggio delle misure non nulle, con cicli senza salti che il compilatore
+		   vettorizza
+		4. MEDIANA: le misure nulle diventano +infinito e le righe (una per scansione) vengono passate
+		   a mediana_righe
+
+		Osservazione:
+		- la rete fa ultime * ultime / 2 confronti per misura, per cui si usa solo fino a
+		  MAX_RETE_MEDIANA scansioni; oltre si usa std::nth_element misura per misura
+	*/
+	void LidarDriver::fondi(int da, int a, int ultime, Fusione modo, double *out) const {
+		if (ultime > dimension)
+			ultime = dimension;
+		int prima = dimension - ultime;	// posizione (come in get_view) della prima scansione da fondere
+		const double infinito = std::numeric_limits<double>::infinity();
+
+		for (int b = da; b < a; b += BLOCCO_FUSIONE) {
+			int n = std::min(BLOCCO_FUSIONE, a - b);
+			double conta[BLOCCO_FUSIONE];
+			for (int j = 0; j < n; j++)
+				conta[j] = 0;
+
+			if (modo == Fusione::MEDIA) {
+				double somma[BLOCCO_FUSIONE], riga[BLOCCO_FUSIONE];
+				for (int j = 0; j < n; j++)
+					somma[j] = 0;
+				for (int k = prima; k < dimension; k++) {
+					decodifica_campioni(slot(avanza(elPiVecio, k)) + b * dimCampione, n, riga, formato, scala);
+					for (int j = 0; j < n; j++) {
+						somma[j] += riga[j];
+						conta[j] += (riga[j] != 0) ? 1 : 0;
+					}
+				}
+				for (int j = 0; j < n; j++)
+					out[b - da + j] = (conta[j] > 0) ? somma[j] / conta[j] : 0;
+			}
+			else if (ultime <= MAX_RETE_MEDIANA) {
+				double righe[MAX_RETE_MEDIANA][BLOCCO_FUSIONE];
+				for (int r = 0; r < ultime; r++) {
+					decodifica_campioni(slot(avanza(elPiVecio, prima + r)) + b * dimCampione, n, righe[r], formato, scala);
+					for (int j = 0; j < n; j++) {
+						conta[j] += (righe[r][j] != 0) ? 1 : 0;
+						righe[r][j] = (righe[r][j] != 0) ? righe[r][j] : infinito;
+					}
+				}
+
+				mediana_righe(righe, ultime, n, conta, out + b - da);
+			}
+			else {
+				std::vector<double> colonna;
+				colonna.reserve(ultime);
+				for (int j = 0; j < n; j++) {
+					colonna.clear();
+					for (int k = prima; k < dimension; k++) {
+						double v = leggi_campione(slot(avanza(elPiVecio, k)), b + j, formato, scala);
+						if (v != 0)
+							colonna.push_back(v);
+					}
+					int c = colonna.size();
+					if (c == 0) {
+						out[b - da + j] = 0;
+						continue;
+					}
+					std::nth_element(colonna.begin(), colonna.begin() + c / 2, colonna.end());
+					double alta = colonna[c / 2];
+					double bassa = (c % 2 == 1) ? alta : *std::max_element(colonna.begin(), colonna.begin() + c / 2);
+					out[b - da + j] = (bassa + alta) / 2;
+				}
+			}
+		}
+	}
+
+	/* Funzione mediana_righe(double righe[][BLOCCO_FUSIONE], int quante, int n, const double *conta, double *out):
+		1. riceve "quante" righe di n misure, in cui le misure nulle sono già state messe a +infinito,
+		   e per ogni colonna j il numero conta[j] di misure non nulle
+		2. ordina ogni colonna con una rete di ordinamento pari-dispari: ogni passo è un min e un max
+		   tra due righe intere, senza salti, per cui il compilatore lo vettorizza
+		3. per ogni colonna scrive in out[j] il valore centrale tra quelli non nulli, che dopo
+		   l'ordinamento sono i primi conta[j] (media dei due centrali se sono pari, 0 se non ce ne sono)
+
+		Osservazione:
+		- funzione statica usata dalla fusione (righe = scansioni) e dallo smoothing dei filtri
+		  (righe = la scansione spostata di una misura per volta)
+	*/
+	void LidarDriver::mediana_righe(double (*righe)[BLOCCO_FUSIONE], int quante, int n, const double *conta, double *out) {
+		// rete pari-dispari: dopo "quante" passate ogni colonna è ordinata
+		for (int passata = 0; passata < quante; passata++) {
+			for (int r = passata % 2; r + 1 < quante; r += 2) {
+				double *sopra = righe[r], *sotto = righe[r + 1];
+				for (int j = 0; j < n; j++) {
+					double minimo = std::min(sopra[j], sotto[j]);
+					double massimo = std::max(sopra[j], sotto[j]);
+					sopra[j] = minimo;
+					sotto[j] = massimo;
+				}
+			}
+		}
+
+		for (int j = 0; j < n; j++) {
+			int c = static_cast<int>(conta[j]);
+			out[j] = (c == 0) ? 0 : (righe[(c - 1) / 2][j] + righe[c / 2][j]) / 2;
+		}
+	}
+
+	/* Funzione set_filtri(const Filtri &nuovi):
+		- imposta i filtri che new_scan (in tutte le versioni) applica a ogni nuova scansione, dopo
+		  averla scritta nel suo slot: così la scansione filtrata viene calcolata una volta sola e
+		  tutti i lettori (get_scan, viste, get_distance, diario...) la trovano già pronta
+		- le scansioni già nel buffer non vengono toccate, e neanche quelle lette con read_scan e
+		  read_buffer, qualunque sia il loro formato nel file (sono già state registrate come erano
+		  nel buffer)
+		- se la finestra non è dispari o è più larga di MAX_RETE_MEDIANA - 1 viene lanciata
+		  l'eccezione "FiltroSbagliatoError"
+	*/
+	void LidarDriver::set_filtri(const Filtri &nuovi) {
+		if (nuovi.finestra < 1 || nuovi.finestra % 2 == 0 || nuovi.finestra >= MAX_RETE_MEDIANA)
+			throw FiltroSbagliatoError();
+
+		filtri = nuovi;
+		filtriAttivi = filtri.mascheraInvalidi || filtri.massimo > filtri.minimo || filtri.sogliaPicchi > 0 || filtri.finestra > 1;
+	}
+
+	/* Funzione get_filtri():
+		- restituisce i filtri impostati con set_filtri
+	*/
+	const Filtri &LidarDriver::get_filtri() const {
+		return filtri;
+	}
+
+	/* Funzione set_metriche(MetricheLidar *m):
+		- da qui in poi il driver aggiorna le metriche indicate (nullptr per smettere): contatori delle
+		  scansioni inserite, sovrascritte, completate e troncate, errori e durate delle operazioni
+		- le copie del driver aggiornano le stesse metriche, che devono vivere più a lungo di tutti
+		- funziona solo se il driver è compilato con LIDAR_METRICHE (vedi MetricheLidar.h), altrimenti
+		  le metriche restano a zero
+	*/
+	void LidarDriver::set_metriche(MetricheLidar *m) {
+		metriche = m;
+	}
+
+	/* Funzione get_metriche():
+		- restituisce le metriche collegate con set_metriche, o nullptr se non ce ne sono
+	*/
+	MetricheLidar *LidarDriver::get_metriche() const {
+		return metriche;
+	}
+
+	/* Funzione filtra(unsigned char *dest):
+		1. se non ci sono filtri attivi non fa niente (è chiamata da tutte le new_scan)
+		2. converte la scansione dello slot in double nello spazio di lavoro, dove tra una scansione e
+		   l'altra ci sono sempre MAX_RETE_MEDIANA / 2 zeri (così le finestre non escono mai dai dati
+		   e gli zeri, che sono misure mancanti, vengono ignorati)
+		3. applica nell'ordine: maschera dei valori non validi, limiti, rimozione dei picchi e smoothing;
+		   ogni filtro è un ciclo senza salti sulla scansione intera (o su blocchi di BLOCCO_FUSIONE
+		   per la mediana), che il compilatore vettorizza
+		4. riconverte il risultato nel formato del buffer, direttamente nello slot
+
+		Osservazioni:
+		- le misure a 0 restano 0: i filtri non inventano misure dove lo strumento non le ha date
+		- i filtri che guardano le misure vicine scrivono nella seconda metà dello spazio di lavoro,
+		  così leggono sempre i valori prima del filtro
+		- lo spazio di lavoro viene riallocato (a zero) se non ha esattamente la dimensione giusta per
+		  dimScansioni, non solo se è troppo piccolo: con uno spazio più grande gli zeri del bordo
+		  non sarebbero dove le finestre li cercano (vedi anche gli assegnamenti, che lo svuotano)
+	*/
+	void LidarDriver::filtra(unsigned char *dest) {
+		if (!filtriAttivi)
+			return;
+
+		const int bordo = MAX_RETE_MEDIANA / 2;
+		const int n = dimScansioni;
+		if (lavoro.size() != static_cast<std::size_t>(2 * (n + 2 * bordo)))
+			lavoro.assign(2 * (n + 2 * bordo), 0);
+		double *a = lavoro.data() + bordo;
+		double *b = a + n + 2 * bordo;
+		const double infinito = std::numeric_limits<double>::infinity();
+
+		decodifica_campioni(dest, n, a, formato, scala);
+
+		if (filtri.mascheraInvalidi) {
+			for (int j = 0; j < n; j++)
+				a[j] = (a[j] >= 0 && a[j] < infinito) ? a[j] : 0;	// anche NaN diventa 0
+		}
+
+		if (filtri.massimo > filtri.minimo) {
+			const double minimo = filtri.minimo, massimo = filtri.massimo;
+			for (int j = 0; j < n; j++) {
+				double v = std::min(std::max(a[j], minimo), massimo);
+				a[j] = (a[j] != 0) ? v : 0;
+			}
+		}
+
+		if (filtri.sogliaPicchi > 0) {
+			const double s = filtri.sogliaPicchi;
+			b[0] = a[0];
+			b[n - 1] = a[n - 1];
+			for (int j = 1; j < n - 1; j++) {
+				double prima = a[j - 1], dopo = a[j + 1], x = a[j];
+				bool picco = x != 0 && prima != 0 && dopo != 0
+				             && ((x - prima > s && x - dopo > s) || (prima - x > s && dopo - x > s));
+				b[j] = picco ? (prima + dopo) / 2 : x;
+			}
+			std::swap(a, b);
+		}
+
+		if (filtri.finestra > 1) {
+			const int meta = filtri.finestra / 2;
+			for (int blocco = 0; blocco < n; blocco += BLOCCO_FUSIONE) {
+				int quante = std::min(BLOCCO_FUSIONE, n - blocco);
+				const double *x = a + blocco;
+				double conta[BLOCCO_FUSIONE];
+				for (int j = 0; j < quante; j++)
+					conta[j] = 0;
+
+				if (filtri.smoothing == Fusione::MEDIA) {
+					double somma[BLOCCO_FUSIONE];
+					for (int j = 0; j < quante; j++)
+						somma[j] = 0;
+					for (int d = -meta; d <= meta; d++) {
+						for (int j = 0; j < quante; j++) {
+							somma[j] += x[j + d];
+							conta[j] += (x[j + d] != 0) ? 1 : 0;
+						}
+					}
+					for (int j = 0; j < quante; j++)
+						b[blocco + j] = (x[j] != 0) ? somma[j] / conta[j] : 0;
+				}
+				else {
+					double righe[MAX_RETE_MEDIANA][BLOCCO_FUSIONE];
+					for (int d = -meta; d <= meta; d++) {
+						for (int j = 0; j < quante; j++) {
+							conta[j] += (x[j + d] != 0) ? 1 : 0;
+							righe[d + meta][j] = (x[j + d] != 0) ? x[j + d] : infinito;
+						}
+					}
+					mediana_righe(righe, filtri.finestra, quante, conta, b + blocco);
+					for (int j = 0; j < quante; j++)
+						b[blocco + j] = (x[j] != 0) ? b[blocco + j] : 0;
+				}
+			}
+			std::swap(a, b);
+		}
+
+		codifica_campioni(a, n, dest, formato, scala);
+	}
+
+	/* Funzione set_statistiche(bool attive, double larghezza):
+		1. la larghezza dei settori (in gradi) deve essere tra 0 e 180, altrimenti viene lanciata
+		   l'eccezione "AngoloForaDaiRangeError"; 0 vuol dire un solo settore con tutta la scansione
+		2. la larghezza viene arrotondata a un numero intero di misure (almeno una) e i settori sono
+		   quanti servono a coprire tutte le misure (l'ultimo può essere più stretto)
+		3. riserva le statistiche per tutti gli slot e le calcola subito per le scansioni già nel
+		   buffer, così sono sempre disponibili per tutte le scansioni presenti
+		4. con attive = false le statistiche vengono tolte e la memoria liberata
+	*/
+	void LidarDriver::set_statistiche(bool attive, double larghezza) {
+		if (!(larghezza >= 0 && larghezza <= MAX_ANGLE - MIN_ANGLE))
+			throw AngoloForaDaiRangeError();
+
+		statisticheAttive = attive;
+		misurePerSettore = (larghezza == 0) ? dimScansioni : std::max(1, static_cast<int>(std::round(larghezza / resolusion)));
+		numeroSettori = (dimScansioni + misurePerSettore - 1) / misurePerSettore;
+		if (!attive) {
+			std::vector<StatisticheScansione>().swap(statistiche);
+			return;
+		}
+
+		statistiche.assign(dimBuffer * (numeroSettori + 1), StatisticheScansione{});
+		for (int k = 0; k < dimension; k++)
+			calcola_statistiche(avanza(elPiVecio, k));
+	}
+
+	/* Funzione calcola_statistiche(int indice):
+		1. se le statistiche non sono attive non fa niente (è chiamata da tutte le new_scan, dopo i
+		   filtri, e quando una scansione viene letta da un file o dal diario)
+		2. con il formato DOUBLE le misure vengono lette direttamente dallo slot, altrimenti vengono
+		   convertite in double in un array nello stack (al massimo MAX_MISURE misure)
+		3. calcola con riassumi_settore le statistiche di ogni settore, mentre la scansione appena
+		   scritta è ancora nella cache
+		4. le statistiche di tutta la scansione si ottengono unendo quelle dei settori (minimo dei
+		   minimi, massimo dei massimi, somma delle somme): le misure vengono lette una volta sola
+	*/
+	void LidarDriver::calcola_statistiche(int indice) {
+		if (!statisticheAttive)
+			return;
+
+		double decodificate[MAX_MISURE];
+		const double *x = reinterpret_cast<const double *>(slot(indice));
+		if (formato != FormatoCampioni::DOUBLE) {
+			decodifica_campioni(slot(indice), dimScansioni, decodificate, formato, scala);
+			x = decodificate;
+		}
+
+		StatisticheScansione *st = statistiche.data() + indice * (numeroSettori + 1);
+		StatisticheScansione totale;
+		double somma = 0;
+		for (int s = 0; s < numeroSettori; s++) {
+			int da = s * misurePerSettore;
+			int a = std::min(da + misurePerSettore, dimScansioni);
+			const StatisticheScansione &parte = st[s + 1];
+			somma += riassumi_settore(x, da, a, st[s + 1]);
+			if (parte.valide == 0)
+				continue;
+
+			if (totale.valide == 0 || parte.minimo < totale.minimo) {
+				totale.minimo = parte.minimo;
+				totale.angoloMinimo = parte.angoloMinimo;
+			}
+			totale.massimo = std::max(totale.massimo, parte.massimo);
+			totale.valide += parte.valide;
+		}
+		totale.media = (totale.valide == 0) ? 0 : somma / totale.valide;
+		st[0] = totale;
+	}
+
+	/* Funzione riassumi_settore(const double *x, int da, int a, StatisticheScansione &st):
+		1. scrive in st le statistiche delle misure x[da], ..., x[a - 1] e restituisce la loro somma
+		   (per la media di tutta la scansione)
+		2. minimo (con il suo indice), massimo, somma e conteggio sono calcolati nello stesso ciclo,
+		   senza salti: le misure non valide diventano +infinito per il minimo e 0 per il resto
+		3. con AVX2 lavora su 4 misure per volta, con SSE2 su 2: ogni elemento dei registri ha i suoi
+		   accumulatori (anche l'indice del suo minimo), che alla fine vengono uniti
+		4. le misure rimaste (o tutte, senza SIMD) vengono elaborate una alla volta
+
+		Osservazioni:
+		- il compilatore non vettorizza da solo queste riduzioni: cambierebbero l'ordine delle somme in
+		  virgola mobile, e il minimo con il suo indice non lo riconosce proprio
+		- a parità di minimo vince l'indice più piccolo, come in un ciclo scalare con <
+	*/
+	double LidarDriver::riassumi_settore(const double *x, int da, int a, StatisticheScansione &st) const {
+		const double infinito = std::numeric_limits<double>::infinity();
+		double minimi[4], indici[4], massimi[4], somme[4], conte[4];
+		int corsie = 0;
+		int j = da;
+
+#if defined(__AVX2__)
+		const __m256d zero4 = _mm256_setzero_pd();
+		const __m256d infinito4 = _mm256_set1_pd(infinito);
+		const __m256d uno4 = _mm256_set1_pd(1);
+		const __m256d passo4 = _mm256_set1_pd(4);
+		__m256d minimo4 = infinito4, indiceMinimo4 = zero4, massimo4 = zero4, somma4 = zero4, conta4 = zero4;
+		__m256d indice4 = _mm256_setr_pd(da, da + 1, da + 2, da + 3);
+		for (; j + 4 <= a; j += 4) {
+			__m256d v = _mm256_loadu_pd(x + j);
+			__m256d valida = _mm256_and_pd(_mm256_cmp_pd(v, zero4, _CMP_GT_OQ), _mm256_cmp_pd(v, infinito4, _CMP_LT_OQ));
+			__m256d z = _mm256_and_pd(v, valida);
+			__m256d nuovo = _mm256_cmp_pd(_mm256_blendv_pd(infinito4, v, valida), minimo4, _CMP_LT_OQ);
+			minimo4 = _mm256_blendv_pd(minimo4, v, nuovo);
+			indiceMinimo4 = _mm256_blendv_pd(indiceMinimo4, indice4, nuovo);
+			massimo4 = _mm256_max_pd(massimo4, z);
+			somma4 = _mm256_add_pd(somma4, z);
+			conta4 = _mm256_add_pd(conta4, _mm256_and_pd(valida, uno4));
+			indice4 = _mm256_add_pd(indice4, passo4);
+		}
+		_mm256_storeu_pd(minimi, minimo4);
+		_mm256_storeu_pd(indici, indiceMinimo4);
+		_mm256_storeu_pd(massimi, massimo4);
+		_mm256_storeu_pd(somme, somma4);
+		_mm256_storeu_pd(conte, conta4);
+		corsie = 4;
+#elif defined(__SSE2__)
+		// SSE2 non ha blendv: la scelta tra due valori con una maschera si fa con and, andnot e or
+		const __m128d zero2 = _mm_setzero_pd();
+		const __m128d infinito2 = _mm_set1_pd(infinito);
+		const __m128d uno2 = _mm_set1_pd(1);
+		const __m128d passo2 = _mm_set1_pd(2);
+		__m128d minimo2 = infinito2, indiceMinimo2 = zero2, massimo2 = zero2, somma2 = zero2, conta2 = zero2;
+		__m128d indice2 = _mm_setr_pd(da, da + 1);
+		for (; j + 2 <= a; j += 2) {
+			__m128d v = _mm_loadu_pd(x + j);
+			__m128d valida = _mm_and_pd(_mm_cmpgt_pd(v, zero2), _mm_cmplt_pd(v, infinito2));
+			__m128d z = _mm_and_pd(v, valida);
+			__m128d nuovo = _mm_cmplt_pd(_mm_or_pd(z, _mm_andnot_pd(valida, infinito2)), minimo2);
+			minimo2 = _mm_or_pd(_mm_and_pd(nuovo, v), _mm_andnot_pd(nuovo, minimo2));
+			indiceMinimo2 = _mm_or_pd(_mm_and_pd(nuovo, indice2), _mm_andnot_pd(nuovo, indiceMinimo2));
+			massimo2 = _mm_max_pd(massimo2, z);
+			somma2 = _mm_add_pd(somma2, z);
+			conta2 = _mm_add_pd(conta2, _mm_and_pd(valida, uno2));
+			indice2 = _mm_add_pd(indice2, passo2);
+		}
+		_mm_storeu_pd(minimi, minimo2);
+		_mm_storeu_pd(indici, indiceMinimo2);
+		_mm_storeu_pd(massimi, massimo2);
+		_mm_storeu_pd(somme, somma2);
+		_mm_storeu_pd(conte, conta2);
+		corsie = 2;
+#endif
+
+		// unione degli accumulatori dei registri
+		double minimo = infinito, massimo = 0, somma = 0, conta = 0;
+		int indiceMinimo = da;
+		for (int c = 0; c < corsie; c++) {
+			if (minimi[c] < minimo || (minimi[c] == minimo && indici[c] < indiceMinimo)) {
+				minimo = minimi[c];
+				indiceMinimo = static_cast<int>(indici[c]);
+			}
+			massimo = std::max(massimo, massimi[c]);
+			somma += somme[c];
+			conta += conte[c];
+		}
+
+		for (; j < a; j++) {
+			double v = x[j];
+			if (!(v > 0 && v < infinito))
+				continue;
+			if (v < minimo) {
+				minimo = v;
+				indiceMinimo = j;
+			}
+			massimo = std::max(massimo, v);
+			somma += v;
+			conta++;
+		}
+
+		st.valide = static_cast<int>(conta);
+		st.minimo = (st.valide == 0) ? 0 : minimo;
+		st.angoloMinimo = (st.valide == 0) ? 0 : MIN_ANGLE + indiceMinimo * resolusion;
+		st.massimo = massimo;
+		st.media = (st.valide == 0) ? 0 : somma / st.valide;
+		return somma;
+	}
+
+	/* Funzione get_formato():
+		- restituisce il formato in cui sono memorizzate le misure nel buffer
+	*/
+	FormatoCampioni LidarDriver::get_formato() const {
+		return formato;
+	}
+
+	/* Funzione memoria_buffer():
+		- restituisce i byte occupati dalle misure di tutte le scansioni del buffer
+	*/
+	std::size_t LidarDriver::memoria_buffer() const {
+		return static_cast<std::size_t>(dimBuffer) * dimScansioni * dimCampione;
+	}
+
+	/* Funzione memoria_condivisa():
+		- restituisce i byte degli slot che il driver condivide con delle copie (o con l'originale, se
+		  è una copia), cioè la memoria che la copia non ha dovuto allocare
+	*/
+	std::size_t LidarDriver::memoria_condivisa() const {
+		std::size_t condivisi = 0;
+		for (const std::shared_ptr<unsigned char> &s : secia)
+			condivisi += (s.use_count() > 1);
+		return condivisi * dimScansioni * dimCampione;
+	}
+
+	/* Funzione get_dim_buffer():
+		- restituisce il numero massimo di scansioni che il buffer può contenere
+	*/
+	int LidarDriver::get_dim_buffer() const {
+		return dimBuffer;
+	}
+
+	/* Funzione set_dim_buffer(int nuovaDim):
+		1. prepara un nuovo vettore di nuovaDim slot
+		2. ci sposta, in ordine dalla più vecchia alla più nuova, gli slot delle scansioni presenti nel
+		   buffer (senza copiare le misure): se non ci stanno tutte vengono tenute le più nuove
+		3. riusa gli slot avanzati per i posti vuoti e alloca solo quelli che mancano, poi riparte con
+		   la più vecchia nello slot 0
+
+		Osservazioni:
+		- è l'unica funzione (oltre ai costruttori) che alloca slot senza che ci sia una copia da non
+		  toccare, va chiamata solo quando serve cambiare la profondità della storia (es. per
+		  registrare un secondo a 40 Hz)
+		- tutte le VistaScansione ottenute prima della chiamata diventano non valide (valida() restituisce
+		  false), anche quelle sulle scansioni tenute, che hanno cambiato slot
+	*/
+	void LidarDriver::set_dim_buffer(int nuovaDim) {
+		if (nuovaDim < 1)
+			throw DimBufferForaDaiRangeError();
+
+		int tenute = (dimension < nuovaDim) ? dimension : nuovaDim;
+		std::vector<std::shared_ptr<unsigned char>> nuovaSecia(nuovaDim);
+
+		// la prima da tenere è quella che segue le (dimension - tenute) più vecchie
+		std::vector<long long> nuoviTempi(nuovaDim);
+		std::vector<unsigned long long> nuoveSequenze(nuovaDim);
+		int passo = statisticheAttive ? numeroSettori + 1 : 0;
+		std::vector<StatisticheScansione> nuoveStatistiche(nuovaDim * passo);
+		for (int k = 0; k < tenute; k++) {
+			int i = avanza(elPiVecio, dimension - tenute + k);
+			nuovaSecia[k] = std::move(secia[i]);
+			nuoviTempi[k] = tempi[i];
+			nuoveSequenze[k] = sequenze[i];
+			std::copy_n(statistiche.begin() + i * passo, passo, nuoveStatistiche.begin() + k * passo);
+		}
+		int libero = 0;
+		for (int k = tenute; k < nuovaDim; k++) {
+			while (libero < static_cast<int>(secia.size()) && !secia[libero])
+				libero++;
+			nuovaSecia[k] = (libero < static_cast<int>(secia.size())) ? std::move(secia[libero]) : nuovo_slot();
+		}
+
+		secia.swap(nuovaSecia);
+		tempi.swap(nuoviTempi);
+		sequenze.swap(nuoveSequenze);
+		statistiche.swap(nuoveStatistiche);
+		dimBuffer = nuovaDim;
+		rinnova_generazioni();
+		potenzaDi2 = (dimBuffer & (dimBuffer - 1)) == 0;
+		elPiVecio = 0;
+		elPiNovo = (tenute == 0) ? 0 : tenute - 1;
+		dimension = tenute;
+	}
+
+	/* Funzione shrink_to_fit():
+		- restituisce alla risorsa degli slot quelli che non contengono scansioni (per esempio dopo
+		  clear_buffer o dopo tanti get_scan) e libera lo spazio di lavoro dei filtri
+		- gli slot restituiti vengono riallocati da slot_scrivibile quando servono di nuovo, per cui
+		  è il contrario di clear_buffer: da chiamare quando il buffer resterà vuoto per un po'
+
+		Osservazioni:
+		- come in set_dim_buffer gli slot ancora condivisi con una copia non vengono liberati finché
+		  anche la copia non li lascia
+		- la generazione degli slot restituiti viene incrementata, così le viste ottenute prima (ad
+		  esempio con get_scan_view) risultano non valide invece di puntare a memoria liberata
+	*/
+	void LidarDriver::shrink_to_fit() {
+		std::vector<bool> occupati(dimBuffer, false);
+		for (int k = 0; k < dimension; k++)
+			occupati[avanza(elPiVecio, k)] = true;
+		for (int i = 0; i < static_cast<int>(secia.size()); i++)
+			if (!occupati[i] && secia[i]) {
+				secia[i].reset();
+				generazioni[i]++;	// le viste sullo slot (es. di get_scan_view) non sono più valide
+			}
+		std::vector<double>().swap(lavoro);
+	}
+
+	/* Funzione set_risorsa(std::pmr::memory_resource *r, int scorta):
+		1. da qui in poi gli slot del driver vengono allocati dalla risorsa r (ad esempio una
+		   RiservaSlot condivisa da più driver), anche quelli delle copie che si faranno del driver
+		2. sposta nella nuova risorsa gli slot che ha già, copiando le scansioni presenti una volta
+		   sola (gli slot vecchi restano alle copie che li condividevano, o tornano alla vecchia risorsa)
+		3. alloca e libera subito "scorta" slot in più: con una RiservaSlot restano nella riserva
+		   pronti per le copie del driver (ogni copia usa uno slot in più per ogni scansione che il
+		   driver sovrascrive mentre la copia esiste), con le altre risorse non serve
+
+		Osservazioni:
+		- la risorsa deve vivere più a lungo del driver e di tutte le sue copie
+		- con nullptr si torna all'heap (std::pmr::new_delete_resource)
+		- tutte le scansioni cambiano slot, per cui le viste ottenute prima della chiamata non sono
+		  più valide (la generazione degli slot spostati viene incrementata)
+	*/
+	void LidarDriver::set_risorsa(std::pmr::memory_resource *r, int scorta) {
+		risorsa = r ? r : std::pmr::new_delete_resource();
+
+		std::size_t byte = static_cast<std::size_t>(dimScansioni) * dimCampione;
+		std::vector<bool> occupati(dimBuffer, false);
+		for (int k = 0; k < dimension; k++)
+			occupati[avanza(elPiVecio, k)] = true;
+		for (int i = 0; i < static_cast<int>(secia.size()); i++) {
+			if (!secia[i])
+				continue;
+			std::shared_ptr<unsigned char> nuovo = nuovo_slot();
+			if (occupati[i])
+				std::memcpy(nuovo.get(), secia[i].get(), byte);
+			secia[i] = std::move(nuovo);
+			generazioni[i]++;	// le viste puntano ancora allo slot vecchio, che può essere liberato
+		}
+
+		std::vector<std::shared_ptr<unsigned char>> scorte(scorta > 0 ? scorta : 0);
+		for (std::shared_ptr<unsigned char> &s : scorte)
+			s = nuovo_slot();
+	}
+
+	/* Funzione dim_buffer_da_budget(double resolusion, BudgetMemoria budget, FormatoCampioni formato):
+		- funzione statica usata dal costruttore con budget: calcola quante scansioni intere con
+		  quella risoluzione e quel formato stanno nel numero di byte indicato
+	*/
+	int LidarDriver::dim_buffer_da_budget(double resolusion, BudgetMemoria budget, FormatoCampioni formato) {
+		if (resolusion < MIN_RESOLUTION || resolusion > MAX_RESOLUTION)
+			throw ResolusionForaDaiRangeError();
+
+		int dimScansioni = (MAX_ANGLE - MIN_ANGLE) / resolusion + 1;
+		std::size_t scansioni = budget.byte / (dimScansioni * dimensione_campione(formato));
+		if (scansioni < 1 || scansioni > INT_MAX)
+			throw DimBufferForaDaiRangeError();
+		return scansioni;
+	}
+
+	/* Funzione apri_diario(const std::string &percorso, int numeroRecord):
+		1. apre (o crea) il diario su file con i parametri del driver e il numero di record indicato
+		   (vedi DiarioScansioni.h), se il file esiste con parametri diversi viene lanciata
+		   l'eccezione "FileSbagliatoError"
+		2. se il diario è nuovo ci vengono scritte le scansioni già presenti nel buffer
+		3. se il diario contiene già delle scansioni (ad esempio dopo un crash) il buffer viene
+		   svuotato e riempito con le più nuove del diario, copiate dalla mappatura con memcpy, con
+		   il timestamp e la sequenza con cui erano state inserite (come read_buffer); le scansioni
+		   inserite dopo continuano la numerazione dall'ultima
+		4. da qui in poi ogni scansione inserita viene registrata anche nel diario
+
+		Osservazioni:
+		- clear_buffer e get_scan non toccano il diario, che conserva tutta la storia
+		- i timestamp vengono ricaricati così come sono: se erano del driver (steady_clock) hanno
+		  senso solo fino al riavvio della macchina, se erano dello strumento restano quelli; un
+		  timestamp minore del precedente (diario scritto da un driver che non li controllava) viene
+		  portato a quello del precedente, così le ricerche per tempo restano corrette
+	*/
+	void LidarDriver::apri_diario(const std::string &percorso, int numeroRecord) {
+		diario = std::make_shared<DiarioScansioni>(percorso, numeroRecord, resolusion, dimScansioni, formato, scala);
+
+		if (diario->size() == 0) {
+			for (int k = 0; k < dimension; k++)
+				registra(avanza(elPiVecio, k));
+			return;
+		}
+
+		clear_buffer();
+		int daCaricare = (diario->size() < dimBuffer) ? diario->size() : dimBuffer;
+		for (int k = diario->size() - daCaricare; k < diario->size(); k++) {
+			const IntestazioneScansione &intestazione = diario->intestazione(k);
+			long long timestamp = (dimension > 0 && intestazione.timestamp < tempi[elPiNovo]) ? tempi[elPiNovo] : intestazione.timestamp;
+			std::memcpy(prossimo_slot(timestamp, intestazione.sequenza), diario->misure(k), dimScansioni * dimCampione);
+			calcola_statistiche(elPiNovo);
+		}
+	}
+
+	/* Funzione chiudi_diario():
+		- il driver smette di scrivere nel diario (il file resta sul disco e si può riaprire)
+	*/
+	void LidarDriver::chiudi_diario() {
+		diario.reset();
+	}
+
+	/* Funzione get_diario():
+		- restituisce il diario aperto, per rileggere la storia, o nullptr se non c'è
+	*/
+	const DiarioScansioni *LidarDriver::get_diario() const {
+		return diario.get();
+	}
+
+	/* Funzione registra(int i):
+		- chiamata da tutte le versioni di new_scan dopo aver scritto lo slot i: se c'è un diario ci
+		  scrive la scansione appena inserita, con il suo timestamp e la sua sequenza (anche quelli
+		  passati dal chiamante), altrimenti non fa niente
+	*/
+	void LidarDriver::registra(int i) {
+		if (diario)
+			diario->scrivi(slot(i), dimScansioni, formato, tempi[i], sequenze[i]);
 	}
 
 	/* Overloading assegnamento di copia:
 		1. riceve come parametro un oggetto da copiare
-		2. copia le variabili da copiare
+		2. copia le variabili da copiare (gli slot vengono condivisi, come nel costruttore di copia)
+		3. come nel costruttore di copia il diario non viene copiato, e quello aperto viene chiuso:
+		   ha i parametri (numero di misure, formato) del vecchio driver, non di quello copiato
+		4. le generazioni non vengono copiate ma rinnovate (rinnova_generazioni): le viste ottenute
+		   prima dell'assegnamento diventano non valide, senza puntare a memoria liberata
 	*/
 	LidarDriver& LidarDriver::operator=(const LidarDriver& ld) {
 		// controllo che l'oggetto assegnato non sia se stesso
@@ -242,7 +1774,29 @@ namespace lidar_driver {
 			elPiVecio = ld.elPiVecio;
 			dimension = ld.dimension;
 			resolusion = ld.resolusion;
+			dimScansioni = ld.dimScansioni;
+			dimBuffer = ld.dimBuffer;
+			potenzaDi2 = ld.potenzaDi2;
+			scansioniInserite = ld.scansioniInserite;
+			scansioniPerse = ld.scansioniPerse;
+			filtri = ld.filtri;
+			filtriAttivi = ld.filtriAttivi;
+			statisticheAttive = ld.statisticheAttive;
+			misurePerSettore = ld.misurePerSettore;
+			numeroSettori = ld.numeroSettori;
+			formato = ld.formato;
+			scala = ld.scala;
+			dimCampione = ld.dimCampione;
+			risorsa = ld.risorsa;
+			metriche = ld.metriche;
 			secia = ld.secia;
+			rinnova_generazioni();	// le viste sul vecchio contenuto non sono più valide
+			tempi = ld.tempi;
+			sequenze = ld.sequenze;
+			tabelle = ld.tabelle;
+			statistiche = ld.statistiche;
+			diario.reset();
+			lavoro.clear();	// era per le scansioni del vecchio driver: filtra lo rialloca
 		}
 		return *this;
 	}
@@ -253,8 +1807,13 @@ namespace lidar_driver {
 		3. svuoto l'oggetto smembrato, invocando clear_buffer
 
 		Osservazioni:
-		1. la funzione di swap scambia i riferimenti dei dati memorizzati nei due vettori, per cui secia
-		   avrà i dati dell'argomento della funzione e l'argomento avrà i vecchi dati di secia
+		1. la funzione di swap scambia i riferimenti dei dati memorizzati nei due vettori, per cui
+		   generazioni, tempi, ecc. avranno i dati dell'argomento della funzione e l'argomento avrà i
+		   vecchi dati
+		2. gli slot invece vengono spostati e l'argomento resta senza: se ricevesse i vecchi slot non
+		   si saprebbe se hanno la dimensione giusta per le sue scansioni; clear_buffer gli lascia gli
+		   slot vuoti e li alloca slot_scrivibile quando servono
+		3. le tabelle sono condivise anche dopo la move: l'argomento ha la stessa risoluzione di prima
 	*/
 	void LidarDriver::operator=(LidarDriver &&ld) {
 		// inizializzazione variabili con i valori dell'oggetto da smembrare
@@ -262,37 +1821,301 @@ namespace lidar_driver {
 		elPiVecio = ld.elPiVecio;
 		dimension = ld.dimension;
 		resolusion = ld.resolusion;
+		dimScansioni = ld.dimScansioni;
+		dimBuffer = ld.dimBuffer;
+		potenzaDi2 = ld.potenzaDi2;
+		scansioniInserite = ld.scansioniInserite;
+		scansioniPerse = ld.scansioniPerse;
+		filtri = ld.filtri;
+		filtriAttivi = ld.filtriAttivi;
+		statisticheAttive = ld.statisticheAttive;
+		misurePerSettore = ld.misurePerSettore;
+		numeroSettori = ld.numeroSettori;
+		formato = ld.formato;
+		scala = ld.scala;
+		dimCampione = ld.dimCampione;
+		risorsa = ld.risorsa;
+		metriche = ld.metriche;
 
-		// la funzione swap scambia i riferimenti dei dati tra i due vettori
-		secia.swap(ld.secia);
+		// la funzione swap scambia i riferimenti dei dati tra i due vettori (anche le generazioni,
+		// così le viste già create seguono i dati nel nuovo oggetto)
+		secia = std::move(ld.secia);
+		ld.secia.clear();
+		generazioni.swap(ld.generazioni);
+		tempi.swap(ld.tempi);
+		sequenze.swap(ld.sequenze);
+		tabelle = ld.tabelle;
+		statistiche.swap(ld.statistiche);
+		diario = std::move(ld.diario);
+		lavoro.clear();	// era per le scansioni del vecchio driver: filtra lo rialloca
 
 		// svuoto l'oggetto smembrato
 		ld.clear_buffer();
 	}
   
 	/* Overloading dell'operatore <<
-		Con un try - catch viene gestito il caso in cui il buffer sia vuoto:
-		- la funzione get_last lancia infatti l'eccezione "NoGheSonVettori", che, recepita dalla presente
-		  funzione, permette di inviare immediatamente allo stream di output una generica stampa di un array
-		  vuoto
-		- nel caso l'eccezione non si presenti, sintomo che il buffer non è vuoto, l'ultimo vettore inserito
-		  viene restituito dalla funzione get_last() e stampato con un'opportuna formattazione.
+		- l'ultima scansione inserita viene letta direttamente dal buffer e convertita in testo da un
+		  FormattatoreTesto con le opzioni di default ("{ a, b, ... }\n" con 6 decimali, "{ }\n" se
+		  il buffer è vuoto), senza copiare la scansione né lanciare eccezioni
+		- il formattatore è thread_local: la sua stringa viene riusata da tutte le stampe dello stesso
+		  thread, per cui dopo la prima non ci sono più allocazioni
+		- per cambiare precisione e separatori, o stampare tutto il buffer o un settore, si usa
+		  direttamente un FormattatoreTesto (vedi FormattatoreTesto.h)
 	*/
 	std::ostream &operator<<(std::ostream& os, const LidarDriver& ld) {
-		try {
-			std::vector<double> temp = ld.get_last(); // <- qui si potrebbe lanciare l'eccezione
-			std::string s = "{ ";
-			for (int i = 0; i < temp.size(); i++) {
-				s += std::to_string(temp[i]);
-				if (i < temp.size() - 1)
-					s += ", ";
-			}
-			s += " }\n";
+		thread_local FormattatoreTesto formattatore;
+		return os << formattatore.formatta_ultima(ld);
+	}
+
+	/* Funzione write_scan(ostream &os):
+		1. scrive nello stream l'intestazione binaria dell'ultima scansione inserita (vedi
+		   FormatoBinario.h) con risoluzione, numero di misure, numero progressivo e timestamp
+		2. scrive le misure così come sono nel buffer, con un'unica write
 
-			return os << s;
+		Osservazione:
+		- chiamata dopo ogni new_scan permette di registrare tutte le scansioni ricevute, che si
+		  possono poi reinserire in un altro driver con read_scan
+	*/
+	void LidarDriver::write_scan(std::ostream &os) const {
+		if (dimension == 0)
+			throw NoGheSonVettoriError();
+
+		IntestazioneScansione intestazione = intestazione_scansione(elPiNovo);
+		os.write(reinterpret_cast<const char *>(&intestazione), sizeof(intestazione));
+		os.write(reinterpret_cast<const char *>(slot(elPiNovo)), dimScansioni * dimCampione);
+	}
+
+	/* Funzione write_buffer(ostream &os):
+		- scrive nello stream l'intestazione del buffer e poi tutte le scansioni presenti, dalla più
+		  vecchia alla più nuova, ognuna con la sua intestazione come in write_scan
+	*/
+	void LidarDriver::write_buffer(std::ostream &os) const {
+		IntestazioneBuffer intestazione = intestazione_buffer();
+		os.write(reinterpret_cast<const char *>(&intestazione), sizeof(intestazione));
+
+		for (int k = 0; k < dimension; k++) {
+			IntestazioneScansione scansione = intestazione_scansione(avanza(elPiVecio, k));
+			os.write(reinterpret_cast<const char *>(&scansione), sizeof(scansione));
+			os.write(reinterpret_cast<const char *>(slot(avanza(elPiVecio, k))), dimScansioni * dimCampione);
+		}
+	}
+
+	/* Funzione write_buffer(span<unsigned char> out):
+		- come write_buffer(ostream &), ma scrive nella memoria passata come parametro
+		- restituisce il numero di byte scritti, se la memoria non basta viene lanciata l'eccezione
+		  "DimensionOutputSbagliataError" (i byte necessari si sanno con dimensione_binaria)
+	*/
+	std::size_t LidarDriver::write_buffer(std::span<unsigned char> out) const {
+		if (out.size() < dimensione_binaria())
+			throw DimensionOutputSbagliataError();
+
+		unsigned char *p = out.data();
+		IntestazioneBuffer intestazione = intestazione_buffer();
+		std::memcpy(p, &intestazione, sizeof(intestazione));
+		p += sizeof(intestazione);
+
+		for (int k = 0; k < dimension; k++) {
+			IntestazioneScansione scansione = intestazione_scansione(avanza(elPiVecio, k));
+			std::memcpy(p, &scansione, sizeof(scansione));
+			p += sizeof(scansione);
+			std::memcpy(p, slot(avanza(elPiVecio, k)), dimScansioni * dimCampione);
+			p += dimScansioni * dimCampione;
+		}
+		return p - out.data();
+	}
+
+	/* Funzione dimensione_binaria():
+		- restituisce il numero di byte che write_buffer scrive con il contenuto attuale del buffer
+	*/
+	std::size_t LidarDriver::dimensione_binaria() const {
+		return sizeof(IntestazioneBuffer) + dimension * (sizeof(IntestazioneScansione) + dimScansioni * dimCampione);
+	}
+
+	/* Funzione read_scan(istream &is):
+		1. legge dallo stream una scansione scritta da write_scan (o da write_buffer) e la inserisce
+		   nel buffer come farebbe new_scan
+		2. se la scansione ha lo stesso formato del buffer, le misure vengono copiate nello slot così
+		   come sono; altrimenti vengono convertite nel formato del buffer (vedi inserisci_misure)
+		3. a differenza di new_scan, i filtri non vengono applicati (in nessuno dei due casi)
+
+		Osservazioni:
+		- se l'intestazione non è valida o la risoluzione non è quella del driver viene lanciata
+		  l'eccezione "FileSbagliatoError"
+		- se lo stream finisce a metà della scansione viene lanciata l'eccezione "FileSbagliatoError"
+		  e il buffer resta com'era prima della chiamata (le misure vengono lette prima in uno spazio
+		  a parte e inserite solo se sono tutte)
+		- come in new_scan, se la scansione letta è più vecchia dell'ultima del buffer viene lanciata
+		  l'eccezione "TimestampIndrioError" e il buffer resta com'era
+	*/
+	void LidarDriver::read_scan(std::istream &is) {
+		IntestazioneScansione intestazione;
+		if (!is.read(reinterpret_cast<char *>(&intestazione), sizeof(intestazione)))
+			throw FileSbagliatoError();
+		controlla_intestazione(intestazione);
+		leggi_misure(is, intestazione);
+	}
+
+	/* Funzione leggi_misure(istream &is, const IntestazioneScansione &intestazione):
+		1. legge dallo stream le misure della scansione di cui è già stata letta (e controllata)
+		   l'intestazione, in uno spazio a parte (thread_local, così non si alloca a ogni lettura)
+		2. solo se sono state lette tutte le inserisce nel buffer con inserisci_misure: se lo stream
+		   finisce prima, nessuno slot è stato toccato (né le sue misure, né generazione, timestamp e
+		   sequenza)
+	*/
+	void LidarDriver::leggi_misure(std::istream &is, const IntestazioneScansione &intestazione) {
+		thread_local std::vector<unsigned char> dati;
+		dati.resize(dimScansioni * dimensione_campione(static_cast<FormatoCampioni>(intestazione.formato)));
+		if (!is.read(reinterpret_cast<char *>(dati.data()), dati.size()))
+			throw FileSbagliatoError();
+		inserisci_misure(dati.data(), intestazione);
+	}
+
+	/* Funzione inserisci_misure(const unsigned char *dati, const IntestazioneScansione &intestazione):
+		- inserisce nel buffer le misure lette (da uno stream o dalla memoria) di una scansione con
+		  l'intestazione indicata, già controllata; è usata da read_scan e da entrambe le read_buffer
+		0. se il timestamp è minore di quello dell'ultima scansione nel buffer viene lanciata
+		   l'eccezione "TimestampIndrioError" (vedi controlla_tempo), prima di toccare il buffer
+		1. se la scansione ha lo stesso formato e la stessa scala del buffer, le misure vengono copiate
+		   nello slot con memcpy
+		2. altrimenti vengono convertite in double e poi nel formato del buffer, direttamente nello slot
+		3. in entrambi i casi vengono calcolate le statistiche e la scansione viene registrata nel diario
+
+		Osservazione:
+		- i filtri non vengono applicati in nessuno dei due casi: una scansione letta è già stata
+		  registrata come era nel buffer (filtrata o no), per cui viene memorizzata così com'è,
+		  qualunque sia il suo formato nel file (vedi set_filtri)
+	*/
+	void LidarDriver::inserisci_misure(const unsigned char *dati, const IntestazioneScansione &intestazione) {
+		controlla_tempo(intestazione.timestamp);
+		FormatoCampioni formatoDati = static_cast<FormatoCampioni>(intestazione.formato);
+		unsigned char *dest;
+		if (formatoDati == formato && intestazione.scala == scala) {
+			dest = prossimo_slot(intestazione.timestamp, intestazione.sequenza);
+			std::memcpy(dest, dati, dimScansioni * dimCampione);
+		}
+		else {
+			std::vector<double> misure(dimScansioni);
+			decodifica_campioni(dati, dimScansioni, misure.data(), formatoDati, intestazione.scala);
+			dest = prossimo_slot(intestazione.timestamp, intestazione.sequenza);
+			codifica_campioni(misure.data(), dimScansioni, dest, formato, scala);
+		}
+		calcola_statistiche(elPiNovo);
+		registra(elPiNovo);
+	}
+
+	/* Funzione read_buffer(istream &is):
+		1. legge l'intestazione del buffer e crea un LidarDriver con la stessa risoluzione,
+		   dimensione del buffer e formato
+		2. legge e inserisce tutte le scansioni come read_scan
+		3. riprende la numerazione delle scansioni da dove era arrivato il driver salvato
+	*/
+	LidarDriver LidarDriver::read_buffer(std::istream &is) {
+		IntestazioneBuffer intestazione;
+		if (!is.read(reinterpret_cast<char *>(&intestazione), sizeof(intestazione)))
+			throw FileSbagliatoError();
+		LidarDriver ld = da_intestazione(intestazione);
+
+		for (unsigned int k = 0; k < intestazione.numeroScansioni; k++) {
+			IntestazioneScansione scansione;
+			if (!is.read(reinterpret_cast<char *>(&scansione), sizeof(scansione)))
+				throw FileSbagliatoError();
+			ld.controlla_intestazione(scansione);
+			ld.leggi_misure(is, scansione);
 		}
-		catch (LidarDriver::NoGheSonVettoriError) {
-			return os << "{ }\n";
+		return ld;
+	}
+
+	/* Funzione read_buffer(span<const unsigned char> dati):
+		- come read_buffer(istream &), ma legge dalla memoria passata come parametro (ad esempio
+		  riempita da write_buffer o mappata da un file); le misure vengono inserite con
+		  inserisci_misure come in read_scan (copiate con memcpy, con le statistiche)
+		- tutte le scansioni devono avere il formato e la scala del buffer, altrimenti viene lanciata
+		  l'eccezione "FileSbagliatoError"
+	*/
+	LidarDriver LidarDriver::read_buffer(std::span<const unsigned char> dati) {
+		if (dati.size() < sizeof(IntestazioneBuffer))
+			throw FileSbagliatoError();
+		IntestazioneBuffer intestazione;
+		std::memcpy(&intestazione, dati.data(), sizeof(intestazione));
+		LidarDriver ld = da_intestazione(intestazione);
+
+		std::size_t pos = sizeof(intestazione);
+		std::size_t dimMisure = ld.dimScansioni * ld.dimCampione;
+		for (unsigned int k = 0; k < intestazione.numeroScansioni; k++) {
+			IntestazioneScansione scansione;
+			if (dati.size() - pos < sizeof(scansione) + dimMisure)
+				throw FileSbagliatoError();
+			std::memcpy(&scansione, dati.data() + pos, sizeof(scansione));
+			ld.controlla_intestazione(scansione);
+			if (scansione.formato != intestazione.formato || scansione.scala != intestazione.scala)
+				throw FileSbagliatoError();
+			pos += sizeof(scansione);
+
+			ld.inserisci_misure(dati.data() + pos, scansione);
+			pos += dimMisure;
 		}
+		return ld;
+	}
+
+	/* Funzione intestazione_scansione(int i):
+		- prepara l'intestazione binaria della scansione nello slot i, con il suo numero di sequenza
+		  e il suo timestamp
+	*/
+	IntestazioneScansione LidarDriver::intestazione_scansione(int i) const {
+		IntestazioneScansione intestazione{};
+		std::memcpy(intestazione.magia, MAGIA_SCANSIONE, sizeof(MAGIA_SCANSIONE));
+		intestazione.versione = VERSIONE_FORMATO;
+		intestazione.formato = static_cast<std::uint8_t>(formato);
+		intestazione.dimScansioni = dimScansioni;
+		intestazione.resolusion = resolusion;
+		intestazione.scala = scala;
+		intestazione.sequenza = sequenze[i];
+		intestazione.timestamp = tempi[i];
+		return intestazione;
+	}
+
+	/* Funzione intestazione_buffer():
+		- prepara l'intestazione binaria del buffer con i parametri del driver
+	*/
+	IntestazioneBuffer LidarDriver::intestazione_buffer() const {
+		IntestazioneBuffer intestazione{};
+		std::memcpy(intestazione.magia, MAGIA_BUFFER, sizeof(MAGIA_BUFFER));
+		intestazione.versione = VERSIONE_FORMATO;
+		intestazione.formato = static_cast<std::uint8_t>(formato);
+		intestazione.dimScansioni = dimScansioni;
+		intestazione.dimBuffer = dimBuffer;
+		intestazione.resolusion = resolusion;
+		intestazione.scala = scala;
+		intestazione.numeroScansioni = dimension;
+		return intestazione;
+	}
+
+	/* Funzione controlla_intestazione(const IntestazioneScansione &intestazione):
+		- verifica che l'intestazione sia di una scansione, con una versione e un formato conosciuti
+		  e con la stessa risoluzione (e quindi lo stesso numero di misure) del driver, altrimenti
+		  viene lanciata l'eccezione "FileSbagliatoError"
+	*/
+	void LidarDriver::controlla_intestazione(const IntestazioneScansione &intestazione) const {
+		if (std::memcmp(intestazione.magia, MAGIA_SCANSIONE, sizeof(MAGIA_SCANSIONE)) != 0
+			|| intestazione.versione != VERSIONE_FORMATO
+			|| intestazione.formato > static_cast<std::uint8_t>(FormatoCampioni::UINT16)
+			|| intestazione.resolusion != resolusion
+			|| intestazione.dimScansioni != static_cast<std::uint32_t>(dimScansioni))
+			throw FileSbagliatoError();
+	}
+
+	/* Funzione da_intestazione(const IntestazioneBuffer &intestazione):
+		- funzione statica che verifica l'intestazione di un buffer salvato e crea un LidarDriver
+		  vuoto con gli stessi parametri
+	*/
+	LidarDriver LidarDriver::da_intestazione(const IntestazioneBuffer &intestazione) {
+		if (std::memcmp(intestazione.magia, MAGIA_BUFFER, sizeof(MAGIA_BUFFER)) != 0
+			|| intestazione.versione != VERSIONE_FORMATO
+			|| intestazione.formato > static_cast<std::uint8_t>(FormatoCampioni::UINT16)
+			|| intestazione.numeroScansioni > intestazione.dimBuffer)
+			throw FileSbagliatoError();
+
+		return LidarDriver(intestazione.resolusion, static_cast<int>(intestazione.dimBuffer),
+		                   static_cast<FormatoCampioni>(intestazione.formato), intestazione.scala);
 	}
 }
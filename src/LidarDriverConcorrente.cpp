@@ -0,0 +1,364 @@
+/*
+	FILE IMPLEMENTAZIONI LIDARDRIVERCONCORRENTE.CPP
+
+	Vengono implementate le funzioni della libreria LidarDriverConcorrente.h
+*/
+
+#include "../include/LidarDriverConcorrente.h"
+#include <atomic> // per contatori e std::atomic_ref
+#include <chrono> // per i tempi massimi di attesa
+#include <coroutine>
+#include <functional>
+#include <mutex>
+#include <span>   // per la new_scan da span
+#include <stop_token>
+#include <thread> // per il thread di subscribe
+#include <vector> // per operazioni su vector
+
+namespace lidar_driver {
+	/* Costruttore con risoluzione:
+		1. riceve come parametro la risoluzione dello strumento e verifica che sia valida
+		2. imposta contatori e numeri di sequenza a zero
+		3. alloca una volta per tutte lo spazio per BUFFER_DIM scansioni
+	*/
+	LidarDriverConcorrente::LidarDriverConcorrente(double resolusion)
+		: scritti{0}, letti{0}, persi{0}, soglia{NESSUNA} {
+		// verifica che la risoluzione sia valida
+		if (resolusion < MIN_RESOLUTION || resolusion > MAX_RESOLUTION)
+			throw ResolusionForaDaiRangeError();
+
+		this->resolusion = resolusion;
+		dimScansioni = (MAX_ANGLE - MIN_ANGLE) / resolusion + 1;
+
+		// alloca il buffer e i numeri di sequenza (tutti pari = slot stabile)
+		secia.resize(BUFFER_DIM * dimScansioni);
+		sequenze = std::make_unique<std::atomic<unsigned long long>[]>(BUFFER_DIM);
+		for (int i = 0; i < BUFFER_DIM; i++)
+			sequenze[i].store(0, std::memory_order_relaxed);
+	}
+
+	/* Funzione new_scan(const vector<double> &v) - solo thread produttore:
+		- come la new_scan da span
+	*/
+	void LidarDriverConcorrente::new_scan(const std::vector<double> &v) {
+		new_scan(std::span<const double>(v));
+	}
+
+	/* Funzione new_scan(std::span<const double> v) - solo thread produttore:
+		1. calcola lo slot in cui scrivere dal numero di scansioni già scritte
+		2. marca lo slot come "in scrittura" (numero di sequenza dispari)
+		3. copia la scansione nello slot troncando o completando con zeri come in LidarDriver
+		4. marca lo slot come stabile (numero di sequenza pari) e pubblica la scansione
+		   incrementando scritti
+		5. se il consumatore aspetta e la sua soglia è raggiunta lo sveglia (solo in questo caso
+		   prende il mutex dell'attesa)
+
+		Osservazioni:
+		1. il produttore non legge mai il contatore del consumatore: se il buffer è pieno lo slot
+		   più vecchio viene semplicemente sovrascritto, sarà il consumatore ad accorgersene
+		2. il numero di sequenza della scansione n-esima è 2n+1 durante la scrittura e 2n+2 alla
+		   fine, così il consumatore sa anche QUALE scansione contiene lo slot
+	*/
+	void LidarDriverConcorrente::new_scan(std::span<const double> v) {
+		unsigned long long n = scritti.load(std::memory_order_relaxed);
+		int slot = n % BUFFER_DIM;
+		double *dest = secia.data() + slot * dimScansioni;
+
+		// slot in scrittura: la fence impedisce che le scritture dei campioni vengano anticipate
+		sequenze[slot].store(2 * n + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+
+		// copia troncando o completando con zeri
+		int daCopiare = (v.size() < static_cast<std::size_t>(dimScansioni)) ? static_cast<int>(v.size()) : dimScansioni;
+		for (int i = 0; i < daCopiare; i++)
+			std::atomic_ref<double>(dest[i]).store(v[i], std::memory_order_relaxed);
+		for (int i = daCopiare; i < dimScansioni; i++)
+			std::atomic_ref<double>(dest[i]).store(0, std::memory_order_relaxed);
+
+		// slot stabile e scansione pubblicata
+		sequenze[slot].store(2 * n + 2, std::memory_order_release);
+		scritti.store(n + 1, std::memory_order_release);
+
+		// la fence ordina la pubblicazione prima della lettura della soglia (vedi l'header)
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (n + 1 >= soglia.load(std::memory_order_relaxed))
+			sveglia(n + 1);
+	}
+
+	/* Funzione get_scan() - solo thread consumatore:
+		1. se non ci sono scansioni da leggere viene lanciata l'eccezione "NoGheSonVettoriError"
+		2. se il produttore ha già sovrascritto le scansioni più vecchie, queste vengono contate
+		   come perse e si riparte dalla più vecchia ancora presente nel buffer
+		3. la scansione viene copiata e il numero di sequenza viene ricontrollato: se nel frattempo
+		   il produttore ha iniziato a sovrascrivere lo slot, la copia non è valida, la scansione
+		   viene contata come persa e si riprova con la successiva
+
+		Osservazione:
+		- il ciclo termina sempre: a ogni giro letti avanza, e ogni giro fallisce solo se il
+		  produttore ha scritto qualcosa di nuovo nel frattempo
+	*/
+	std::vector<double> LidarDriverConcorrente::get_scan() {
+		std::vector<double> v;
+		get_scan(v);
+		return v;
+	}
+
+	/* Funzione get_scan(std::vector<double> &v) - solo thread consumatore:
+		- come get_scan(), ma copia la scansione in v (ridimensionato a dimScansioni) invece di
+		  restituire un vettore nuovo: se v ha già la dimensione giusta non viene allocato niente, per
+		  cui un consumatore che legge sempre nello stesso vettore non alloca mai
+	*/
+	void LidarDriverConcorrente::get_scan(std::vector<double> &v) {
+		if (!try_get_scan(v))
+			throw NoGheSonVettoriError();
+	}
+
+	/* Funzione try_get_scan(std::vector<double> &v) - solo thread consumatore:
+		- come get_scan(v), ma se non ci sono scansioni da leggere (anche perché erano tutte
+		  sovrascritte durante la lettura) restituisce false invece di lanciare l'eccezione: è la
+		  funzione da usare in un ciclo che svuota il buffer, dove trovarlo vuoto è il caso normale
+	*/
+	bool LidarDriverConcorrente::try_get_scan(std::vector<double> &v) {
+		return leggi(letti, persi, v);
+	}
+
+	/* Funzione leggi(atomic &cursore, atomic &perse, std::vector<double> &v) - thread del lettore:
+		1. se non ci sono scansioni dopo il cursore restituisce false
+		2. se il produttore ha già sovrascritto le scansioni dopo il cursore, queste vengono contate
+		   in "perse" e si riparte dalla più vecchia ancora presente nel buffer
+		3. copia la scansione e ricontrolla il numero di sequenza (seqlock, vedi l'header): se nel
+		   frattempo lo slot è stato sovrascritto la scansione è persa e si riprova con la successiva
+
+		Osservazione:
+		- legge soltanto il buffer e i numeri di sequenza, e scrive solo il cursore e il contatore
+		  passati: il consumatore e ogni Lettore hanno i loro, per cui possono leggere tutti insieme
+		  senza mutex e senza disturbarsi (né disturbare il produttore)
+	*/
+	bool LidarDriverConcorrente::leggi(std::atomic<unsigned long long> &cursore, std::atomic<unsigned long long> &perse, std::vector<double> &v) const {
+		while (true) {
+			unsigned long long l = cursore.load(std::memory_order_relaxed);
+			unsigned long long s = scritti.load(std::memory_order_acquire);
+			if (l == s)
+				return false;
+			v.resize(dimScansioni);
+
+			// scansioni già sovrascritte dal produttore
+			if (s - l > BUFFER_DIM) {
+				perse.store(perse.load(std::memory_order_relaxed) + (s - l - BUFFER_DIM), std::memory_order_relaxed);
+				l = s - BUFFER_DIM;
+			}
+
+			int slot = l % BUFFER_DIM;
+			const double *src = secia.data() + slot * dimScansioni;
+
+			// lo slot deve contenere proprio la scansione l-esima, completa
+			unsigned long long seq = sequenze[slot].load(std::memory_order_acquire);
+			if (seq == 2 * l + 2) {
+				for (int i = 0; i < dimScansioni; i++)
+					v[i] = std::atomic_ref<const double>(src[i]).load(std::memory_order_relaxed);
+
+				// la fence impedisce che la rilettura della sequenza venga anticipata alla copia
+				std::atomic_thread_fence(std::memory_order_acquire);
+				if (sequenze[slot].load(std::memory_order_relaxed) == seq) {
+					cursore.store(l + 1, std::memory_order_release);
+					return true;
+				}
+			}
+
+			// lo slot è stato (o sta per essere) sovrascritto: scansione persa
+			perse.store(perse.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+			cursore.store(l + 1, std::memory_order_release);
+		}
+	}
+
+	/* Funzione wait_scan(std::vector<double> &v, std::chrono::nanoseconds tempo) - solo consumatore:
+		1. prova a leggere una scansione con try_get_scan
+		2. se non c'è, aspetta (dormendo) che il produttore ne inserisca una, al massimo per il tempo
+		   indicato, e riprova; restituisce false se allo scadere del tempo non ha letto niente
+
+		Osservazione:
+		- si riprova in un ciclo perché la scansione arrivata può essere sovrascritta mentre viene
+		  letta, nel qual caso try_get_scan restituisce false e si aspetta la successiva
+	*/
+	bool LidarDriverConcorrente::wait_scan(std::vector<double> &v, std::chrono::nanoseconds tempo) {
+		std::chrono::steady_clock::time_point inizio = std::chrono::steady_clock::now();
+		while (!try_get_scan(v)) {
+			std::chrono::nanoseconds rimasto = tempo - (std::chrono::steady_clock::now() - inizio);
+			if (rimasto <= std::chrono::nanoseconds{0} || aspetta(1, rimasto, std::stop_token()) == 0)
+				return false;
+		}
+		return true;
+	}
+
+	/* Funzione wait_scans(int quante, std::chrono::nanoseconds tempo) - solo consumatore:
+		- aspetta (dormendo) che ci siano almeno "quante" scansioni da leggere o che scada il tempo, e
+		  restituisce quante ce ne sono: il consumatore viene svegliato una volta sola per tutto il
+		  gruppo di scansioni, che poi legge con try_get_scan
+		- "quante" viene limitato a [1, BUFFER_DIM]: di più non ce ne possono essere
+	*/
+	int LidarDriverConcorrente::wait_scans(int quante, std::chrono::nanoseconds tempo) {
+		return aspetta(quante, tempo, std::stop_token());
+	}
+
+	/* Funzione subscribe(std::function<void(std::span<const double>)> f, int ogni, std::chrono::nanoseconds intervallo):
+		1. crea un thread che diventa il consumatore: aspetta che ci siano "ogni" scansioni (o che
+		   passi l'intervallo, se non è 0) e chiama f per ognuna delle scansioni presenti
+		2. la scansione passata a f è valida solo durante la chiamata (è un vettore riusato dal thread)
+		3. il thread termina quando viene chiesto di fermarlo (std::jthread::request_stop, che viene
+		   chiamata anche dal distruttore del std::jthread restituito), anche mentre dorme
+
+		Osservazione:
+		- le scansioni già nel buffer e quelle che arrivano mentre f lavora vengono lette tutte alla
+		  sveglia successiva, per cui con una f lenta i gruppi si allungano invece di perdere scansioni
+		  (finché non si supera BUFFER_DIM)
+	*/
+	std::jthread LidarDriverConcorrente::subscribe(std::function<void(std::span<const double>)> f, int ogni, std::chrono::nanoseconds intervallo) {
+		return std::jthread([this, f = std::move(f), ogni, intervallo](std::stop_token stop) {
+			std::vector<double> v(dimScansioni);
+			std::chrono::nanoseconds tempo = (intervallo > std::chrono::nanoseconds{0}) ? intervallo : std::chrono::nanoseconds::max();
+			while (!stop.stop_requested()) {
+				aspetta(ogni, tempo, stop);
+				while (!stop.stop_requested() && try_get_scan(v))
+					f(std::span<const double>(v));
+			}
+		});
+	}
+
+	/* Funzione size():
+		- restituisce il numero di scansioni presenti nel buffer, può essere chiamata da qualsiasi
+		  thread ma il valore è solo indicativo se nel frattempo gli altri thread lavorano
+	*/
+	int LidarDriverConcorrente::size() const {
+		unsigned long long l = letti.load(std::memory_order_acquire);
+		unsigned long long s = scritti.load(std::memory_order_acquire);
+		return (s - l > BUFFER_DIM) ? BUFFER_DIM : s - l;
+	}
+
+	/* Funzione scansioni_perse():
+		- restituisce quante scansioni sono state sovrascritte dal produttore prima che il
+		  consumatore riuscisse a leggerle
+	*/
+	unsigned long long LidarDriverConcorrente::scansioni_perse() const {
+		return persi.load(std::memory_order_relaxed);
+	}
+
+	/* Costruttore di Lettore con il driver:
+		- il lettore parte dalla prossima scansione che verrà inserita: quelle già nel buffer le
+		  vedono solo i lettori creati prima
+	*/
+	LidarDriverConcorrente::Lettore::Lettore(const LidarDriverConcorrente &ld)
+		: ld{ld}, letti{ld.scritti.load(std::memory_order_acquire)}, persi{0} {}
+
+	/* Funzione Lettore::try_get_scan(std::vector<double> &v) - thread del lettore:
+		- come LidarDriverConcorrente::try_get_scan, ma con il cursore del lettore: la scansione
+		  rimane nel buffer per il consumatore e per gli altri lettori
+	*/
+	bool LidarDriverConcorrente::Lettore::try_get_scan(std::vector<double> &v) {
+		return ld.leggi(letti, persi, v);
+	}
+
+	/* Funzione Lettore::size():
+		- scansioni ancora nel buffer che il lettore non ha letto (al massimo BUFFER_DIM)
+	*/
+	int LidarDriverConcorrente::Lettore::size() const {
+		unsigned long long r = ritardo();
+		return (r > BUFFER_DIM) ? BUFFER_DIM : r;
+	}
+
+	/* Funzione Lettore::ritardo():
+		- scansioni inserite che il lettore non ha ancora letto, comprese quelle già sovrascritte
+		  (se è più di BUFFER_DIM, le più vecchie verranno contate come perse alla prossima lettura);
+		  si può chiamare da qualsiasi thread, ad esempio per controllare i lettori lenti
+		- il cursore viene letto prima di scritti, così il risultato non è mai "negativo"
+	*/
+	unsigned long long LidarDriverConcorrente::Lettore::ritardo() const {
+		unsigned long long l = letti.load(std::memory_order_acquire);
+		return ld.scritti.load(std::memory_order_acquire) - l;
+	}
+
+	/* Funzione Lettore::scansioni_perse():
+		- scansioni sovrascritte dal produttore prima che il lettore riuscisse a leggerle
+	*/
+	unsigned long long LidarDriverConcorrente::Lettore::scansioni_perse() const {
+		return persi.load(std::memory_order_relaxed);
+	}
+
+	/* Funzione scansioni_da_aspettare(int quante):
+		- limita il numero di scansioni da aspettare a [1, BUFFER_DIM]
+	*/
+	int LidarDriverConcorrente::scansioni_da_aspettare(int quante) const {
+		return (quante < 1) ? 1 : (quante > BUFFER_DIM) ? BUFFER_DIM : quante;
+	}
+
+	/* Funzione aspetta(int quante, std::chrono::nanoseconds tempo, std::stop_token stop) - solo consumatore:
+		1. se ci sono già abbastanza scansioni non prende nemmeno il mutex
+		2. altrimenti, con il mutex, scrive la soglia (letti + quante) e dorme finché il produttore non
+		   la raggiunge, non scade il tempo o non viene chiesto di fermarsi (stop)
+		3. toglie la soglia, così il produttore torna a non prendere il mutex, e restituisce quante
+		   scansioni ci sono da leggere
+
+		Osservazione:
+		- un tempo così lungo che l'istante di scadenza non si può rappresentare (es.
+		  nanoseconds::max()) vuol dire aspettare senza limite
+	*/
+	int LidarDriverConcorrente::aspetta(int quante, std::chrono::nanoseconds tempo, std::stop_token stop) {
+		quante = scansioni_da_aspettare(quante);
+		if (size() >= quante)
+			return size();
+
+		std::chrono::steady_clock::time_point adesso = std::chrono::steady_clock::now();
+		unsigned long long obiettivo = letti.load(std::memory_order_relaxed) + quante;
+		auto arrivate = [&] { return scritti.load(std::memory_order_acquire) >= obiettivo; };
+
+		std::unique_lock<std::mutex> blocco(mutexAttesa);
+		soglia.store(obiettivo, std::memory_order_relaxed);
+		// la fence ordina la scrittura della soglia prima della lettura di scritti (vedi l'header)
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (tempo >= std::chrono::steady_clock::time_point::max() - adesso)
+			attesa.wait(blocco, stop, arrivate);
+		else
+			attesa.wait_until(blocco, stop, adesso + tempo, arrivate);
+		soglia.store(NESSUNA, std::memory_order_relaxed);
+		return size();
+	}
+
+	/* Funzione sospendi(std::coroutine_handle<> h, int quante) - await_suspend di async_wait_scans:
+		- come aspetta, ma invece di dormire lascia la coroutine al produttore, che la riprende quando
+		  raggiunge la soglia
+		- se le scansioni sono arrivate nel frattempo restituisce false, così la coroutine non viene
+		  sospesa (e non viene ripresa due volte)
+	*/
+	bool LidarDriverConcorrente::sospendi(std::coroutine_handle<> h, int quante) {
+		unsigned long long obiettivo = letti.load(std::memory_order_relaxed) + scansioni_da_aspettare(quante);
+
+		std::lock_guard<std::mutex> blocco(mutexAttesa);
+		soglia.store(obiettivo, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (scritti.load(std::memory_order_acquire) >= obiettivo) {
+			soglia.store(NESSUNA, std::memory_order_relaxed);
+			return false;
+		}
+		coroutine = h;
+		return true;
+	}
+
+	/* Funzione sveglia(unsigned long long n) - thread produttore, solo con la soglia raggiunta:
+		1. con il mutex, ricontrolla la soglia (chi aspettava può essersene andato per il tempo
+		   scaduto), la toglie e prende l'eventuale coroutine sospesa
+		2. sveglia chi dorme in aspetta e riprende la coroutine, fuori dal mutex
+	*/
+	void LidarDriverConcorrente::sveglia(unsigned long long n) {
+		std::coroutine_handle<> h;
+		{
+			std::lock_guard<std::mutex> blocco(mutexAttesa);
+			if (n < soglia.load(std::memory_order_relaxed))
+				return;
+			soglia.store(NESSUNA, std::memory_order_relaxed);
+			h = coroutine;
+			coroutine = nullptr;
+		}
+		attesa.notify_all();
+		if (h)
+			h.resume();
+	}
+}
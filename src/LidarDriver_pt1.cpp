@@ -6,46 +6,571 @@
 */
 
 #include "../include/LidarDriver.h"
+#include "../include/FormattatoreTesto.h" // per overloading operator<<
 #include <vector>  // per operazioni su vector
+#include <cstring> // per std::memcpy nel formato binario
+#include <chrono>  // per il timestamp delle scansioni
+#include <climits> // per LLONG_MAX nella funzione trova_intervallo
+#include <istream> // per read_scan e read_buffer
+#include <span>    // per to_points e sector_stats
+#include <utility> // per std::pair nelle funzioni trova_intervallo e closest_obstacle
 
 namespace lidar_driver {
-	/* Funzione get_last():
+	/* Funzione try_get_last():
 		- La funzione restituisce l'ultimo vettore inserito, in caso il buffer sia vuoto viene
-		  lanciata l'eccezione "NoGheSonVettoriError".
+		  restituito l'errore BUFFER_VUOTO (senza lanciare eccezioni).
+	*/
+	EsitoLidar<std::vector<double>> LidarDriver::try_get_last() const {
+		DURATA_LIDAR(OperazioneLidar::GET_LAST);
+		if (dimension == 0)
+			return ErroreLidar::BUFFER_VUOTO;
+		
+		std::vector<double> v(dimScansioni);
+		decodifica_campioni(slot(elPiNovo), dimScansioni, v.data(), formato, scala);
+		return v;
+	}
 
-		- La funzione non è richiesta dalle specifiche, ma viene usata nella helper function
-		  dell'overloading dell'operatore <<
+	/* Funzione get_last():
+		- come try_get_last, ma in caso il buffer sia vuoto viene lanciata l'eccezione
+		  "NoGheSonVettoriError".
 	*/
 	std::vector<double> LidarDriver::get_last() const {
+		EsitoLidar<std::vector<double>> esito = try_get_last();
+		if (!esito) {
+			METRICHE_LIDAR(conta_errore(OperazioneLidar::GET_LAST));
+			lancia(esito.error());
+		}
+		return std::move(*esito);
+	}
+
+	/* Funzione try_get_last_view():
+		- come try_get_last, ma restituisce una vista sullo slot dell'ultima scansione invece di una copia
+	*/
+	EsitoLidar<VistaScansione> LidarDriver::try_get_last_view() const noexcept {
 		if (dimension == 0)
+			return ErroreLidar::BUFFER_VUOTO;
+
+		return VistaScansione(slot(elPiNovo), dimScansioni, &generazioni[elPiNovo], formato, scala);
+	}
+
+	/* Funzione get_last_view():
+		- come try_get_last_view, ma in caso il buffer sia vuoto viene lanciata l'eccezione
+		  "NoGheSonVettoriError"
+	*/
+	VistaScansione LidarDriver::get_last_view() const {
+		EsitoLidar<VistaScansione> esito = try_get_last_view();
+		if (!esito)
+			lancia(esito.error());
+		return *esito;
+	}
+
+	/* Funzione get_view(int k):
+		- restituisce una vista sulla k-esima scansione presente nel buffer, contando dalla più vecchia
+		  (k = 0) alla più nuova (k = size() - 1), senza rimuoverla
+		- se k non corrisponde a nessuna scansione viene lanciata l'eccezione "NoGheSonVettoriError"
+	*/
+	VistaScansione LidarDriver::get_view(int k) const {
+		if (k < 0 || k >= dimension)
 			throw NoGheSonVettoriError();
-		
-		return secia[elPiNovo];
+
+		int i = avanza(elPiVecio, k);
+		return VistaScansione(slot(i), dimScansioni, &generazioni[i], formato, scala);
+	}
+
+	/* Funzione size():
+		- restituisce il numero di scansioni presenti nel buffer
+	*/
+	int LidarDriver::size() const {
+		return dimension;
+	}
+
+	/* Funzione get_resolution():
+		- restituisce la risoluzione angolare dello strumento
+	*/
+	double LidarDriver::get_resolution() const {
+		return resolusion;
+	}
+
+	/* Funzione get_dim_scansioni():
+		- restituisce il numero di misure di ogni scansione (da MIN_ANGLE a MAX_ANGLE compresi)
+	*/
+	int LidarDriver::get_dim_scansioni() const {
+		return dimScansioni;
+	}
+
+	/* Funzione get_timestamp(int k):
+		- restituisce il timestamp (ns) della k-esima scansione del buffer, contata come in get_view
+		- se k non corrisponde a nessuna scansione viene lanciata l'eccezione "NoGheSonVettoriError"
+	*/
+	long long LidarDriver::get_timestamp(int k) const {
+		if (k < 0 || k >= dimension)
+			throw NoGheSonVettoriError();
+
+		return tempi[avanza(elPiVecio, k)];
+	}
+
+	/* Funzione get_sequenza(int k):
+		- restituisce il numero di sequenza della k-esima scansione del buffer, contata come in get_view
+		- se k non corrisponde a nessuna scansione viene lanciata l'eccezione "NoGheSonVettoriError"
+	*/
+	unsigned long long LidarDriver::get_sequenza(int k) const {
+		if (k < 0 || k >= dimension)
+			throw NoGheSonVettoriError();
+
+		return sequenze[avanza(elPiVecio, k)];
+	}
+
+	/* Funzione trova_vicina(long long t):
+		1. con una ricerca binaria (primo_da) trova la prima scansione con timestamp >= t
+		2. restituisce la posizione (come in get_view) tra quella e la precedente, quella con il
+		   timestamp più vicino a t (a parità, la più vecchia)
+		3. se il buffer è vuoto viene lanciata l'eccezione "NoGheSonVettoriError"
+	*/
+	int LidarDriver::trova_vicina(long long t) const {
+		if (dimension == 0)
+			throw NoGheSonVettoriError();
+
+		int k = primo_da(t);
+		if (k == dimension)
+			return dimension - 1;
+		if (k == 0)
+			return 0;
+		return (t - tempi[avanza(elPiVecio, k - 1)] <= tempi[avanza(elPiVecio, k)] - t) ? k - 1 : k;
+	}
+
+	/* Funzione trova_intervallo(long long t0, long long t1):
+		- restituisce le posizioni (come in get_view) [prima, ultima + 1) delle scansioni con
+		  timestamp compreso tra t0 e t1 (estremi inclusi), trovate con due ricerche binarie
+		- se non ce ne sono le due posizioni sono uguali (ciclo for da prima a ultima + 1 vuoto)
+	*/
+	std::pair<int, int> LidarDriver::trova_intervallo(long long t0, long long t1) const {
+		int prima = primo_da(t0);
+		int dopo = (t1 == LLONG_MAX) ? dimension : primo_da(t1 + 1);
+		return {prima, (dopo > prima) ? dopo : prima};
+	}
+
+	/* Funzione scansioni_perse():
+		- restituisce il numero di scansioni sovrascritte da new_scan (buffer pieno) prima di essere
+		  state lette con get_scan
+	*/
+	unsigned long long LidarDriver::scansioni_perse() const {
+		return scansioniPerse;
+	}
+
+	/* Funzione to_points(span<double> x, span<double> y):
+		- converte l'ultima scansione inserita in punti del piano dello strumento (misura * coseno,
+		  misura * seno dell'angolo) e scrive le coordinate in x e y (formato "struttura di array",
+		  comodo per i cicli vettorizzati di chi usa i punti)
+		- se il buffer è vuoto viene lanciata l'eccezione "NoGheSonVettoriError", se uno dei due span
+		  ha meno di dimScansioni misure "DimensionOutputSbagliataError"
+		- le misure a 0 (mancanti o riempimento di new_scan) diventano il punto (0, 0)
+	*/
+	void LidarDriver::to_points(std::span<double> x, std::span<double> y) const {
+		to_points(dimension - 1, x, y);
+	}
+
+	/* Funzione to_points(int k, span<double> x, span<double> y):
+		- come to_points(x, y), ma per la k-esima scansione del buffer contando dalla più vecchia
+		  (k = 0) alla più nuova (k = size() - 1), come get_view
+	*/
+	void LidarDriver::to_points(int k, std::span<double> x, std::span<double> y) const {
+		if (k < 0 || k >= dimension)
+			throw NoGheSonVettoriError();
+		if (x.size() < static_cast<std::size_t>(dimScansioni) || y.size() < static_cast<std::size_t>(dimScansioni))
+			throw DimensionOutputSbagliataError();
+
+		punti(slot(avanza(elPiVecio, k)), x.data(), y.data());
+	}
+
+	/* Funzione punti(const unsigned char *dati, double *x, double *y):
+		1. con il formato DOUBLE le misure vengono lette direttamente dallo slot, altrimenti prima
+		   vengono convertite in double dentro x (decodifica_campioni)
+		2. un unico ciclo moltiplica ogni misura per coseno e seno dalle tabelle: non ci sono
+		   chiamate a funzione né dipendenze tra le iterazioni, per cui il compilatore lo vettorizza
+	*/
+	void LidarDriver::punti(const unsigned char *dati, double *x, double *y) const {
+		const double *misure = reinterpret_cast<const double *>(dati);
+		if (formato != FormatoCampioni::DOUBLE) {
+			decodifica_campioni(dati, dimScansioni, x, formato, scala);
+			misure = x;
+		}
+
+		const double *c = tabelle->coseni.data();
+		const double *s = tabelle->seni.data();
+		for (int j = 0; j < dimScansioni; j++) {
+			double r = misure[j];
+			y[j] = r * s[j];
+			x[j] = r * c[j];
+		}
+	}
+
+	/* Funzione larghezza_settore():
+		- restituisce la larghezza dei settori delle statistiche in gradi, cioè quella passata a
+		  set_statistiche arrotondata a un numero intero di misure
+	*/
+	double LidarDriver::larghezza_settore() const {
+		return misurePerSettore * resolusion;
+	}
+
+	/* Funzione statistiche_attive():
+		- restituisce true se new_scan sta calcolando le statistiche (set_statistiche(true, ...))
+	*/
+	bool LidarDriver::statistiche_attive() const {
+		return statisticheAttive;
+	}
+
+	/* Funzione scan_stats():
+		- restituisce le statistiche dell'ultima scansione inserita, calcolate da new_scan
+		- se le statistiche non sono attive viene lanciata l'eccezione "StatisticheSpenteError", se il
+		  buffer è vuoto "NoGheSonVettoriError"
+	*/
+	const StatisticheScansione &LidarDriver::scan_stats() const {
+		return scan_stats(dimension - 1);
+	}
+
+	/* Funzione scan_stats(int k):
+		- come scan_stats(), per la k-esima scansione del buffer (come get_view)
+	*/
+	const StatisticheScansione &LidarDriver::scan_stats(int k) const {
+		if (!statisticheAttive)
+			throw StatisticheSpenteError();
+		if (k < 0 || k >= dimension)
+			throw NoGheSonVettoriError();
+
+		return statistiche[avanza(elPiVecio, k) * (numeroSettori + 1)];
+	}
+
+	/* Funzione sector_stats(int k):
+		- restituisce le statistiche di tutti i settori della k-esima scansione del buffer (come
+		  get_view): l'elemento s è il settore che inizia all'angolo s * larghezza_settore()
+		- lancia le stesse eccezioni di scan_stats
+	*/
+	std::span<const StatisticheScansione> LidarDriver::sector_stats(int k) const {
+		const StatisticheScansione &tutta = scan_stats(k);
+		return std::span<const StatisticheScansione>(&tutta + 1, numeroSettori);
+	}
+
+	/* Funzione closest_obstacle():
+		- restituisce distanza e angolo (in quest'ordine) dell'ostacolo più vicino nell'ultima
+		  scansione, cioè della misura valida più piccola; se non ci sono misure valide sono 0 e 0
+		- lancia le stesse eccezioni di scan_stats
+	*/
+	std::pair<double, double> LidarDriver::closest_obstacle() const {
+		const StatisticheScansione &st = scan_stats();
+		return {st.minimo, st.angoloMinimo};
+	}
+
+	/* Funzione primo_da(long long t):
+		- ricerca binaria sull'ordine del buffer (dalla più vecchia alla più nuova, in cui i timestamp
+		  sono non decrescenti): restituisce la posizione della prima scansione con timestamp >= t, o
+		  dimension se non ce ne sono
+	*/
+	int LidarDriver::primo_da(long long t) const {
+		int basso = 0, alto = dimension;
+		while (basso < alto) {
+			int medio = basso + (alto - basso) / 2;
+			if (tempi[avanza(elPiVecio, medio)] < t)
+				basso = medio + 1;
+			else
+				alto = medio;
+		}
+		return basso;
+	}
+
+	/* Funzione adesso():
+		- funzione statica che restituisce l'istante attuale in ns dell'orologio monotono
+		  (std::chrono::steady_clock), usato come timestamp delle scansioni se non viene passato
+	*/
+	long long LidarDriver::adesso() {
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	/* Funzione tempo_attuale():
+		- il timestamp delle scansioni inserite senza timestamp: l'istante attuale (adesso), ma mai
+		  minore di quello dell'ultima scansione nel buffer, che può venire da un altro orologio (quello
+		  dello strumento passato a new_scan, o quello di un diario riaperto)
+	*/
+	long long LidarDriver::tempo_attuale() const {
+		long long t = adesso();
+		return (dimension > 0 && t < tempi[elPiNovo]) ? tempi[elPiNovo] : t;
+	}
+
+	/* Funzione controlla_tempo(long long timestamp):
+		- controlla un timestamp passato dal chiamante (new_scan) o letto da un file (read_scan,
+		  read_buffer) prima di inserire la scansione: se è minore di quello dell'ultima scansione nel
+		  buffer viene lanciata l'eccezione "TimestampIndrioError" e il buffer non viene toccato
+		- serve perché le ricerche per tempo (trova_vicina, trova_intervallo) sono binarie: una sola
+		  scansione fuori ordine darebbe risultati sbagliati finché resta nel buffer
+	*/
+	void LidarDriver::controlla_tempo(long long timestamp) const {
+		if (dimension > 0 && timestamp < tempi[elPiNovo])
+			throw TimestampIndrioError();
 	}
 
 	/* Overloading dell'operatore <<
-		Con un try - catch viene gestito il caso in cui il buffer sia vuoto:
-		- la funzione get_last lancia infatti l'eccezione "NoGheSonVettori", che, recepita dalla presente
-		  funzione, permette di inviare immediatamente allo stream di output una generica stampa di un array
-		  vuoto
-		- nel caso l'eccezione non si presenti, sintomo che il buffer non è vuoto, l'ultimo vettore inserito
-		  viene restituito dalla funzione get_last() e stampato con un'opportuna formattazione.
+		- l'ultima scansione inserita viene letta direttamente dal buffer e convertita in testo da un
+		  FormattatoreTesto con le opzioni di default ("{ a, b, ... }\n" con 6 decimali, "{ }\n" se
+		  il buffer è vuoto), senza copiare la scansione né lanciare eccezioni
+		- il formattatore è thread_local: la sua stringa viene riusata da tutte le stampe dello stesso
+		  thread, per cui dopo la prima non ci sono più allocazioni
+		- per cambiare precisione e separatori, o stampare tutto il buffer o un settore, si usa
+		  direttamente un FormattatoreTesto (vedi FormattatoreTesto.h)
 	*/
 	std::ostream &operator<<(std::ostream& os, const LidarDriver& ld) {
-		try {
-			std::vector<double> temp = ld.get_last(); // <- qui si potrebbe lanciare l'eccezione
-			std::string s = "{ ";
-			for (int i = 0; i < temp.size(); i++) {
-				s += std::to_string(temp[i]);
-				if (i < temp.size() - 1)
-					s += ", ";
-			}
-			s += " }\n";
+		thread_local FormattatoreTesto formattatore;
+		return os << formattatore.formatta_ultima(ld);
+	}
+
+	/* Funzione write_scan(ostream &os):
+		1. scrive nello stream l'intestazione binaria dell'ultima scansione inserita (vedi
+		   FormatoBinario.h) con risoluzione, numero di misure, numero progressivo e timestamp
+		2. scrive le misure così come sono nel buffer, con un'unica write
+
+		Osservazione:
+		- chiamata dopo ogni new_scan permette di registrare tutte le scansioni ricevute, che si
+		  possono poi reinserire in un altro driver con read_scan
+	*/
+	void LidarDriver::write_scan(std::ostream &os) const {
+		if (dimension == 0)
+			throw NoGheSonVettoriError();
+
+		IntestazioneScansione intestazione = intestazione_scansione(elPiNovo);
+		os.write(reinterpret_cast<const char *>(&intestazione), sizeof(intestazione));
+		os.write(reinterpret_cast<const char *>(slot(elPiNovo)), dimScansioni * dimCampione);
+	}
+
+	/* Funzione write_buffer(ostream &os):
+		- scrive nello stream l'intestazione del buffer e poi tutte le scansioni presenti, dalla più
+		  vecchia alla più nuova, ognuna con la sua intestazione come in write_scan
+	*/
+	void LidarDriver::write_buffer(std::ostream &os) const {
+		IntestazioneBuffer intestazione = intestazione_buffer();
+		os.write(reinterpret_cast<const char *>(&intestazione), sizeof(intestazione));
+
+		for (int k = 0; k < dimension; k++) {
+			IntestazioneScansione scansione = intestazione_scansione(avanza(elPiVecio, k));
+			os.write(reinterpret_cast<const char *>(&scansione), sizeof(scansione));
+			os.write(reinterpret_cast<const char *>(slot(avanza(elPiVecio, k))), dimScansioni * dimCampione);
+		}
+	}
+
+	/* Funzione write_buffer(span<unsigned char> out):
+		- come write_buffer(ostream &), ma scrive nella memoria passata come parametro
+		- restituisce il numero di byte scritti, se la memoria non basta viene lanciata l'eccezione
+		  "DimensionOutputSbagliataError" (i byte necessari si sanno con dimensione_binaria)
+	*/
+	std::size_t LidarDriver::write_buffer(std::span<unsigned char> out) const {
+		if (out.size() < dimensione_binaria())
+			throw DimensionOutputSbagliataError();
+
+		unsigned char *p = out.data();
+		IntestazioneBuffer intestazione = intestazione_buffer();
+		std::memcpy(p, &intestazione, sizeof(intestazione));
+		p += sizeof(intestazione);
+
+		for (int k = 0; k < dimension; k++) {
+			IntestazioneScansione scansione = intestazione_scansione(avanza(elPiVecio, k));
+			std::memcpy(p, &scansione, sizeof(scansione));
+			p += sizeof(scansione);
+			std::memcpy(p, slot(avanza(elPiVecio, k)), dimScansioni * dimCampione);
+			p += dimScansioni * dimCampione;
+		}
+		return p - out.data();
+	}
+
+	/* Funzione dimensione_binaria():
+		- restituisce il numero di byte che write_buffer scrive con il contenuto attuale del buffer
+	*/
+	std::size_t LidarDriver::dimensione_binaria() const {
+		return sizeof(IntestazioneBuffer) + dimension * (sizeof(IntestazioneScansione) + dimScansioni * dimCampione);
+	}
+
+	/* Funzione read_scan(istream &is):
+		1. legge dallo stream una scansione scritta da write_scan (o da write_buffer) e la inserisce
+		   nel buffer come farebbe new_scan
+		2. se la scansione ha lo stesso formato del buffer, le misure vengono copiate nello slot così
+		   come sono; altrimenti vengono convertite nel formato del buffer (vedi inserisci_misure)
+		3. a differenza di new_scan, i filtri non vengono applicati (in nessuno dei due casi)
+
+		Osservazioni:
+		- se l'intestazione non è valida o la risoluzione non è quella del driver viene lanciata
+		  l'eccezione "FileSbagliatoError"
+		- se lo stream finisce a metà della scansione viene lanciata l'eccezione "FileSbagliatoError"
+		  e il buffer resta com'era prima della chiamata (le misure vengono lette prima in uno spazio
+		  a parte e inserite solo se sono tutte)
+		- come in new_scan, se la scansione letta è più vecchia dell'ultima del buffer viene lanciata
+		  l'eccezione "TimestampIndrioError" e il buffer resta com'era
+	*/
+	void LidarDriver::read_scan(std::istream &is) {
+		IntestazioneScansione intestazione;
+		if (!is.read(reinterpret_cast<char *>(&intestazione), sizeof(intestazione)))
+			throw FileSbagliatoError();
+		controlla_intestazione(intestazione);
+		leggi_misure(is, intestazione);
+	}
+
+	/* Funzione leggi_misure(istream &is, const IntestazioneScansione &intestazione):
+		1. legge dallo stream le misure della scansione di cui è già stata letta (e controllata)
+		   l'intestazione, in uno spazio a parte (thread_local, così non si alloca a ogni lettura)
+		2. solo se sono state lette tutte le inserisce nel buffer con inserisci_misure: se lo stream
+		   finisce prima, nessuno slot è stato toccato (né le sue misure, né generazione, timestamp e
+		   sequenza)
+	*/
+	void LidarDriver::leggi_misure(std::istream &is, const IntestazioneScansione &intestazione) {
+		thread_local std::vector<unsigned char> dati;
+		dati.resize(dimScansioni * dimensione_campione(static_cast<FormatoCampioni>(intestazione.formato)));
+		if (!is.read(reinterpret_cast<char *>(dati.data()), dati.size()))
+			throw FileSbagliatoError();
+		inserisci_misure(dati.data(), intestazione);
+	}
+
+	/* Funzione inserisci_misure(const unsigned char *dati, const IntestazioneScansione &intestazione):
+		- inserisce nel buffer le misure lette (da uno stream o dalla memoria) di una scansione con
+		  l'intestazione indicata, già controllata; è usata da read_scan e da entrambe le read_buffer
+		0. se il timestamp è minore di quello dell'ultima scansione nel buffer viene lanciata
+		   l'eccezione "TimestampIndrioError" (vedi controlla_tempo), prima di toccare il buffer
+		1. se la scansione ha lo stesso formato e la stessa scala del buffer, le misure vengono copiate
+		   nello slot con memcpy
+		2. altrimenti vengono convertite in double e poi nel formato del buffer, direttamente nello slot
+		3. in entrambi i casi vengono calcolate le statistiche e la scansione viene registrata nel diario
+
+		Osservazione:
+		- i filtri non vengono applicati in nessuno dei due casi: una scansione letta è già stata
+		  registrata come era nel buffer (filtrata o no), per cui viene memorizzata così com'è,
+		  qualunque sia il suo formato nel file (vedi set_filtri)
+	*/
+	void LidarDriver::inserisci_misure(const unsigned char *dati, const IntestazioneScansione &intestazione) {
+		controlla_tempo(intestazione.timestamp);
+		FormatoCampioni formatoDati = static_cast<FormatoCampioni>(intestazione.formato);
+		unsigned char *dest;
+		if (formatoDati == formato && intestazione.scala == scala) {
+			dest = prossimo_slot(intestazione.timestamp, intestazione.sequenza);
+			std::memcpy(dest, dati, dimScansioni * dimCampione);
+		}
+		else {
+			std::vector<double> misure(dimScansioni);
+			decodifica_campioni(dati, dimScansioni, misure.data(), formatoDati, intestazione.scala);
+			dest = prossimo_slot(intestazione.timestamp, intestazione.sequenza);
+			codifica_campioni(misure.data(), dimScansioni, dest, formato, scala);
+		}
+		calcola_statistiche(elPiNovo);
+		registra(elPiNovo);
+	}
+
+	/* Funzione read_buffer(istream &is):
+		1. legge l'intestazione del buffer e crea un LidarDriver con la stessa risoluzione,
+		   dimensione del buffer e formato
+		2. legge e inserisce tutte le scansioni come read_scan
+		3. riprende la numerazione delle scansioni da dove era arrivato il driver salvato
+	*/
+	LidarDriver LidarDriver::read_buffer(std::istream &is) {
+		IntestazioneBuffer intestazione;
+		if (!is.read(reinterpret_cast<char *>(&intestazione), sizeof(intestazione)))
+			throw FileSbagliatoError();
+		LidarDriver ld = da_intestazione(intestazione);
 
-			return os << s;
+		for (unsigned int k = 0; k < intestazione.numeroScansioni; k++) {
+			IntestazioneScansione scansione;
+			if (!is.read(reinterpret_cast<char *>(&scansione), sizeof(scansione)))
+				throw FileSbagliatoError();
+			ld.controlla_intestazione(scansione);
+			ld.leggi_misure(is, scansione);
 		}
-		catch (LidarDriver::NoGheSonVettoriError) {
-			return os << "{ }\n";
+		return ld;
+	}
+
+	/* Funzione read_buffer(span<const unsigned char> dati):
+		- come read_buffer(istream &), ma legge dalla memoria passata come parametro (ad esempio
+		  riempita da write_buffer o mappata da un file); le misure vengono inserite con
+		  inserisci_misure come in read_scan (copiate con memcpy, con le statistiche)
+		- tutte le scansioni devono avere il formato e la scala del buffer, altrimenti viene lanciata
+		  l'eccezione "FileSbagliatoError"
+	*/
+	LidarDriver LidarDriver::read_buffer(std::span<const unsigned char> dati) {
+		if (dati.size() < sizeof(IntestazioneBuffer))
+			throw FileSbagliatoError();
+		IntestazioneBuffer intestazione;
+		std::memcpy(&intestazione, dati.data(), sizeof(intestazione));
+		LidarDriver ld = da_intestazione(intestazione);
+
+		std::size_t pos = sizeof(intestazione);
+		std::size_t dimMisure = ld.dimScansioni * ld.dimCampione;
+		for (unsigned int k = 0; k < intestazione.numeroScansioni; k++) {
+			IntestazioneScansione scansione;
+			if (dati.size() - pos < sizeof(scansione) + dimMisure)
+				throw FileSbagliatoError();
+			std::memcpy(&scansione, dati.data() + pos, sizeof(scansione));
+			ld.controlla_intestazione(scansione);
+			if (scansione.formato != intestazione.formato || scansione.scala != intestazione.scala)
+				throw FileSbagliatoError();
+			pos += sizeof(scansione);
+
+			ld.inserisci_misure(dati.data() + pos, scansione);
+			pos += dimMisure;
 		}
+		return ld;
+	}
+
+	/* Funzione intestazione_scansione(int i):
+		- prepara l'intestazione binaria della scansione nello slot i, con il suo numero di sequenza
+		  e il suo timestamp
+	*/
+	IntestazioneScansione LidarDriver::intestazione_scansione(int i) const {
+		IntestazioneScansione intestazione{};
+		std::memcpy(intestazione.magia, MAGIA_SCANSIONE, sizeof(MAGIA_SCANSIONE));
+		intestazione.versione = VERSIONE_FORMATO;
+		intestazione.formato = static_cast<std::uint8_t>(formato);
+		intestazione.dimScansioni = dimScansioni;
+		intestazione.resolusion = resolusion;
+		intestazione.scala = scala;
+		intestazione.sequenza = sequenze[i];
+		intestazione.timestamp = tempi[i];
+		return intestazione;
+	}
+
+	/* Funzione intestazione_buffer():
+		- prepara l'intestazione binaria del buffer con i parametri del driver
+	*/
+	IntestazioneBuffer LidarDriver::intestazione_buffer() const {
+		IntestazioneBuffer intestazione{};
+		std::memcpy(intestazione.magia, MAGIA_BUFFER, sizeof(MAGIA_BUFFER));
+		intestazione.versione = VERSIONE_FORMATO;
+		intestazione.formato = static_cast<std::uint8_t>(formato);
+		intestazione.dimScansioni = dimScansioni;
+		intestazione.dimBuffer = dimBuffer;
+		intestazione.resolusion = resolusion;
+		intestazione.scala = scala;
+		intestazione.numeroScansioni = dimension;
+		return intestazione;
+	}
+
+	/* Funzione controlla_intestazione(const IntestazioneScansione &intestazione):
+		- verifica che l'intestazione sia di una scansione, con una versione e un formato conosciuti
+		  e con la stessa risoluzione (e quindi lo stesso numero di misure) del driver, altrimenti
+		  viene lanciata l'eccezione "FileSbagliatoError"
+	*/
+	void LidarDriver::controlla_intestazione(const IntestazioneScansione &intestazione) const {
+		if (std::memcmp(intestazione.magia, MAGIA_SCANSIONE, sizeof(MAGIA_SCANSIONE)) != 0
+			|| intestazione.versione != VERSIONE_FORMATO
+			|| intestazione.formato > static_cast<std::uint8_t>(FormatoCampioni::UINT16)
+			|| intestazione.resolusion != resolusion
+			|| intestazione.dimScansioni != static_cast<std::uint32_t>(dimScansioni))
+			throw FileSbagliatoError();
+	}
+
+	/* Funzione da_intestazione(const IntestazioneBuffer &intestazione):
+		- funzione statica che verifica l'intestazione di un buffer salvato e crea un LidarDriver
+		  vuoto con gli stessi parametri
+	*/
+	LidarDriver LidarDriver::da_intestazione(const IntestazioneBuffer &intestazione) {
+		if (std::memcmp(intestazione.magia, MAGIA_BUFFER, sizeof(MAGIA_BUFFER)) != 0
+			|| intestazione.versione != VERSIONE_FORMATO
+			|| intestazione.formato > static_cast<std::uint8_t>(FormatoCampioni::UINT16)
+			|| intestazione.numeroScansioni > intestazione.dimBuffer)
+			throw FileSbagliatoError();
+
+		return LidarDriver(intestazione.resolusion, static_cast<int>(intestazione.dimBuffer),
+		                   static_cast<FormatoCampioni>(intestazione.formato), intestazione.scala);
 	}
 }
@@ -7,21 +7,97 @@
 
 #include "../include/LidarDriver.h"
 #include <vector>  // per operazioni su vector
+#include <algorithm> // per std::max e std::fill nella funzione rinnova_generazioni
+#include <memory>  // per gli slot condivisi e le tabelle (std::shared_ptr)
+#include <memory_resource> // per la risorsa degli slot nella funzione nuovo_slot
+#include <cmath>   // per std::cos e std::sin nella funzione calcola_tabelle
+#include <numbers> // per pi greco nella funzione calcola_tabelle
 
 namespace lidar_driver {
 	/* Funzione clear_buffer():
 		1. reimposta gli indici di posizione e la dimensione
-		2. rialloco il vettore del buffer
+		2. se serve, rialloco il vettore del buffer
 
-		Osservazione:
-		- non effettuo controlli se il buffer è vuoto, perché anche se dimension = 0, non è detto
-		  che tutti i vettori 
+		Osservazioni:
+		- non serve cancellare i dati delle scansioni: con dimension = 0 nessuno slot viene più
+		  letto e new_scan sovrascrive sempre tutto lo slot, basta incrementare le generazioni per
+		  invalidare le viste
+		- gli slot e i vettori restano allocati, per cui svuotare e riempire di nuovo il buffer non
+		  alloca niente; per restituire la memoria degli slot vuoti c'è shrink_to_fit
+		- il blocco va riallocato solo se non ha la dimensione giusta, cioè se l'oggetto è stato
+		  "smembrato" da una move e si è ritrovato con il buffer di un altro oggetto (lo stesso vale
+		  per le tabelle di to_points)
 	 */
 	void LidarDriver::clear_buffer() {
 		// Reimposta le variabili dell'oggetto
 		elPiNovo = elPiVecio = dimension = 0;
 
-		// rialloco il vettore del buffer come nel costruttore
-		std::vector<std::vector<double>>(BUFFER_DIM).swap(secia);
+		// gli slot restano quelli di prima; in un oggetto smembrato da una move non ci sono, e vengono
+		// allocati da slot_scrivibile quando servono
+		secia.resize(dimBuffer);
+		if (static_cast<int>(generazioni.size()) < dimBuffer)
+			generazioni.resize(dimBuffer);	// mai più corta: le viste puntano ai suoi elementi
+		tempi.resize(dimBuffer);
+		sequenze.resize(dimBuffer);
+		if (!tabelle)
+			calcola_tabelle();
+		if (statisticheAttive)
+			statistiche.resize(dimBuffer * (numeroSettori + 1));
+
+		// le scansioni non ci sono più: le viste ancora in giro non sono più valide
+		for (unsigned long long &g : generazioni)
+			g++;
+	}
+
+	/* Funzione rinnova_generazioni():
+		- invalida tutte le viste del driver quando gli slot cambiano posto o contenuto in blocco
+		  (set_dim_buffer, assegnamento di copia): ogni generazione diventa più grande di tutte quelle
+		  che c'erano, così nessuna vista già creata può tornare valida con gli incrementi successivi
+		- allunga le generazioni fino a dimBuffer, ma non le accorcia mai: sono in una deque, che
+		  aggiungendo in fondo non sposta gli elementi, per cui le viste vecchie non puntano mai a
+		  memoria liberata
+	*/
+	void LidarDriver::rinnova_generazioni() {
+		unsigned long long massima = 0;
+		for (unsigned long long g : generazioni)
+			massima = std::max(massima, g);
+		if (static_cast<int>(generazioni.size()) < dimBuffer)
+			generazioni.resize(dimBuffer);
+		std::fill(generazioni.begin(), generazioni.end(), massima + 1);
+	}
+
+	/* Funzione calcola_tabelle():
+		- calcola coseno e seno dell'angolo di ogni misura (indice * resolusion, in gradi) e li salva
+		  nelle tabelle usate da to_points
+		- viene chiamata dal costruttore (e da clear_buffer se le tabelle non ci sono); dopo non
+		  cambiano più, perché risoluzione e numero di misure restano quelli del costruttore, per cui
+		  le copie del driver le condividono
+	*/
+	void LidarDriver::calcola_tabelle() {
+		std::shared_ptr<TabellePunti> t = std::make_shared<TabellePunti>();
+		t->coseni.resize(dimScansioni);
+		t->seni.resize(dimScansioni);
+		for (int j = 0; j < dimScansioni; j++) {
+			double angolo = (MIN_ANGLE + j * resolusion) * std::numbers::pi / 180;
+			t->coseni[j] = std::cos(angolo);
+			t->seni[j] = std::sin(angolo);
+		}
+		tabelle = std::move(t);
+	}
+
+	/* Funzione nuovo_slot():
+		- alloca uno slot per una scansione (dimScansioni misure nel formato del buffer), allineato
+		  alla cache line come i buffer di AllocatoreAllineato; lo slot viene liberato quando non lo
+		  usa più nessuna copia del driver
+		- sia lo slot che il blocco di controllo dello shared_ptr vengono presi dalla risorsa del
+		  driver (vedi set_risorsa): con una RiservaSlot, una volta riservati abbastanza blocchi,
+		  nuovo_slot non tocca più l'heap
+	*/
+	std::shared_ptr<unsigned char> LidarDriver::nuovo_slot() const {
+		std::size_t byte = static_cast<std::size_t>(dimScansioni) * dimCampione;
+		std::pmr::memory_resource *r = risorsa;
+		return std::shared_ptr<unsigned char>(static_cast<unsigned char *>(r->allocate(byte, ALLINEAMENTO_SLOT)),
+		                                      [r, byte](unsigned char *p) { r->deallocate(p, byte, ALLINEAMENTO_SLOT); },
+		                                      std::pmr::polymorphic_allocator<unsigned char>(r));
 	}
 }
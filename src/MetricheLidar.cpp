@@ -0,0 +1,126 @@
+/*
+	FILE IMPLEMENTAZIONI METRICHELIDAR.CPP
+
+	Vengono implementate le funzioni della libreria MetricheLidar.h
+*/
+
+#include "../include/MetricheLidar.h"
+#include <atomic>
+#include <cstdint>
+#include <ostream>
+#include <span>
+#include <string>
+
+namespace lidar_driver {
+	/* Funzione istantanea():
+		- legge tutti i contatori e gli istogrammi (con letture relaxed, vedi MetricheLidar.h)
+	*/
+	IstantaneaMetriche MetricheLidar::istantanea() const {
+		IstantaneaMetriche ist;
+		for (int c = 0; c < NUMERO_CONTATORI; c++)
+			ist.contatori[c] = contatori[c].load(std::memory_order_relaxed);
+		for (int o = 0; o < NUMERO_OPERAZIONI; o++) {
+			ist.operazioni[o].errori = operazioni[o].errori.load(std::memory_order_relaxed);
+			ist.operazioni[o].chiamate = operazioni[o].chiamate.load(std::memory_order_relaxed);
+			ist.operazioni[o].sommaNs = operazioni[o].sommaNs.load(std::memory_order_relaxed);
+			for (int s = 0; s < NUMERO_SECCHI; s++)
+				ist.operazioni[o].secchi[s] = operazioni[o].secchi[s].load(std::memory_order_relaxed);
+		}
+		return ist;
+	}
+
+	/* Funzione azzera():
+		- rimette a zero tutti i valori (se un driver le sta usando, i suoi aggiornamenti contemporanei
+		  possono finire prima o dopo l'azzeramento)
+	*/
+	void MetricheLidar::azzera() {
+		for (std::atomic<std::uint64_t> &c : contatori)
+			c.store(0, std::memory_order_relaxed);
+		for (Operazione &o : operazioni) {
+			o.errori.store(0, std::memory_order_relaxed);
+			o.chiamate.store(0, std::memory_order_relaxed);
+			o.sommaNs.store(0, std::memory_order_relaxed);
+			for (std::atomic<std::uint64_t> &s : o.secchi)
+				s.store(0, std::memory_order_relaxed);
+		}
+	}
+
+	/* Funzione nome_operazione(OperazioneLidar o):
+		- restituisce il nome dell'operazione usato nell'etichetta "operazione" delle serie
+	*/
+	const char *nome_operazione(OperazioneLidar o) {
+		switch (o) {
+			case OperazioneLidar::NEW_SCAN:     return "new_scan";
+			case OperazioneLidar::GET_SCAN:     return "get_scan";
+			case OperazioneLidar::GET_LAST:     return "get_last";
+			case OperazioneLidar::GET_DISTANCE: return "get_distance";
+		}
+		return "?";
+	}
+
+	/* Funzione etichette(const std::string &comuni, const std::string &proprie):
+		- mette insieme le etichette comuni della serie e quelle proprie della riga, tra graffe (niente
+		  se sono vuote entrambe)
+	*/
+	static std::string etichette(const std::string &comuni, const std::string &proprie) {
+		if (comuni.empty() && proprie.empty())
+			return "";
+		if (comuni.empty() || proprie.empty())
+			return "{" + comuni + proprie + "}";
+		return "{" + comuni + "," + proprie + "}";
+	}
+
+	/* Funzione scrivi_prometheus(std::ostream &os, std::span<const SerieMetriche> serie):
+		1. per ogni metrica scrive le righe # HELP e # TYPE una volta sola e poi i valori di tutte le
+		   serie, come vuole il formato di testo di Prometheus
+		2. i contatori diventano lidar_scansioni_<nome>_total, gli errori lidar_errori_total con
+		   l'etichetta operazione
+		3. le durate diventano l'istogramma lidar_durata_ns: i secchi vengono sommati per avere i
+		   valori cumulativi (le="16", le="32", ..., le="+Inf"), poi _sum e _count
+	*/
+	void scrivi_prometheus(std::ostream &os, std::span<const SerieMetriche> serie) {
+		static const char *contatori[NUMERO_CONTATORI][2] = {
+			{"inserite", "scansioni inserite con new_scan e new_scans"},
+			{"sovrascritte", "scansioni sovrascritte prima di essere lette"},
+			{"completate", "scansioni con meno misure del necessario, completate con zeri"},
+			{"troncate", "scansioni con più misure del necessario, troncate"},
+		};
+		for (int c = 0; c < NUMERO_CONTATORI; c++) {
+			os << "# HELP lidar_scansioni_" << contatori[c][0] << "_total " << contatori[c][1] << "\n";
+			os << "# TYPE lidar_scansioni_" << contatori[c][0] << "_total counter\n";
+			for (const SerieMetriche &s : serie)
+				os << "lidar_scansioni_" << contatori[c][0] << "_total" << etichette(s.etichette, "") << " " << s.valori.contatori[c] << "\n";
+		}
+
+		os << "# HELP lidar_errori_total eccezioni lanciate dalle operazioni\n";
+		os << "# TYPE lidar_errori_total counter\n";
+		for (const SerieMetriche &s : serie)
+			for (int o = 0; o < NUMERO_OPERAZIONI; o++)
+				os << "lidar_errori_total" << etichette(s.etichette, std::string("operazione=\"") + nome_operazione(static_cast<OperazioneLidar>(o)) + "\"")
+				   << " " << s.valori.operazioni[o].errori << "\n";
+
+		os << "# HELP lidar_durata_ns durata delle chiamate in nanosecondi\n";
+		os << "# TYPE lidar_durata_ns histogram\n";
+		for (const SerieMetriche &s : serie)
+			for (int o = 0; o < NUMERO_OPERAZIONI; o++) {
+				const IstantaneaMetriche::Operazione &op = s.valori.operazioni[o];
+				std::string operazione = std::string("operazione=\"") + nome_operazione(static_cast<OperazioneLidar>(o)) + "\"";
+				std::uint64_t cumulativo = 0;
+				for (int b = 0; b < NUMERO_SECCHI; b++) {
+					cumulativo += op.secchi[b];
+					std::string limite = (b < NUMERO_SECCHI - 1) ? std::to_string(PRIMO_LIMITE_NS << b) : "+Inf";
+					os << "lidar_durata_ns_bucket" << etichette(s.etichette, operazione + ",le=\"" + limite + "\"") << " " << cumulativo << "\n";
+				}
+				os << "lidar_durata_ns_sum" << etichette(s.etichette, operazione) << " " << op.sommaNs << "\n";
+				os << "lidar_durata_ns_count" << etichette(s.etichette, operazione) << " " << op.chiamate << "\n";
+			}
+	}
+
+	/* Funzione scrivi_prometheus(std::ostream &os, const IstantaneaMetriche &ist, const std::string &et):
+		- come sopra, per una sola istantanea con le etichette indicate
+	*/
+	void scrivi_prometheus(std::ostream &os, const IstantaneaMetriche &ist, const std::string &et) {
+		SerieMetriche serie{et, ist};
+		scrivi_prometheus(os, std::span<const SerieMetriche>(&serie, 1));
+	}
+}
@@ -0,0 +1,118 @@
+/*
+	FILE IMPLEMENTAZIONI RISERVASLOT.CPP
+
+	Vengono implementate le funzioni della libreria RiservaSlot.h
+*/
+
+#include "../include/RiservaSlot.h"
+#include <algorithm> // per std::max
+#include <cstddef>
+#include <memory_resource>
+#include <mutex>
+#include <vector>
+
+namespace lidar_driver {
+	/* Costruttore con risorsa a monte:
+		- la riserva parte vuota: i blocchi vengono chiesti alla risorsa a monte con riserva o alla
+		  prima allocate di ogni dimensione
+	*/
+	RiservaSlot::RiservaSlot(std::pmr::memory_resource *aMonte) : aMonte{aMonte}, allocazioni{0} {}
+
+	/* Distruttore:
+		- restituisce alla risorsa a monte tutti i blocchi liberi; quelli ancora usati da qualche
+		  driver non possono essere restituiti (la riserva deve essere distrutta per ultima)
+	*/
+	RiservaSlot::~RiservaSlot() {
+		for (Lista &l : liste)
+			for (void *p : l.liberi)
+				aMonte->deallocate(p, l.dimensione, ALLINEAMENTO);
+	}
+
+	/* Funzione riserva(std::size_t byte, int quanti):
+		- chiede subito alla risorsa a monte "quanti" blocchi da "byte" byte e li mette nella lista
+		  libera, così le allocate successive di quella dimensione non toccano la risorsa a monte
+	*/
+	void RiservaSlot::riserva(std::size_t byte, int quanti) {
+		std::lock_guard<std::mutex> blocco(mutex);
+		Lista &l = lista(byte);
+		l.liberi.reserve(l.liberi.size() + quanti);
+		for (int i = 0; i < quanti; i++) {
+			l.liberi.push_back(aMonte->allocate(l.dimensione, ALLINEAMENTO));
+			allocazioni++;
+		}
+	}
+
+	/* Funzione blocchi_liberi():
+		- restituisce quanti blocchi (di tutte le dimensioni) sono pronti per essere riusati
+	*/
+	int RiservaSlot::blocchi_liberi() const {
+		std::lock_guard<std::mutex> blocco(mutex);
+		int n = 0;
+		for (const Lista &l : liste)
+			n += l.liberi.size();
+		return n;
+	}
+
+	/* Funzione allocazioni_a_monte():
+		- restituisce quanti blocchi sono stati chiesti finora alla risorsa a monte: se non cresce più,
+		  i driver che usano la riserva non toccano più l'heap
+	*/
+	std::size_t RiservaSlot::allocazioni_a_monte() const {
+		std::lock_guard<std::mutex> blocco(mutex);
+		return allocazioni;
+	}
+
+	/* Funzione lista(std::size_t byte) - con il mutex preso:
+		- restituisce la lista dei blocchi della dimensione di "byte" arrotondata a ALLINEAMENTO,
+		  creandola se non c'è ancora (le dimensioni sono poche, per cui la ricerca è lineare)
+	*/
+	RiservaSlot::Lista &RiservaSlot::lista(std::size_t byte) {
+		std::size_t dimensione = (std::max<std::size_t>(byte, 1) + ALLINEAMENTO - 1) / ALLINEAMENTO * ALLINEAMENTO;
+		for (Lista &l : liste)
+			if (l.dimensione == dimensione)
+				return l;
+		liste.push_back({dimensione, {}});
+		return liste.back();
+	}
+
+	/* Funzione do_allocate(std::size_t byte, std::size_t allineamento):
+		- restituisce un blocco libero della dimensione giusta o, se non ce ne sono, uno nuovo della
+		  risorsa a monte
+		- i blocchi sono allineati a ALLINEAMENTO byte: allineamenti più grandi vengono chiesti
+		  direttamente alla risorsa a monte, senza passare dalle liste
+	*/
+	void *RiservaSlot::do_allocate(std::size_t byte, std::size_t allineamento) {
+		if (allineamento > ALLINEAMENTO)
+			return aMonte->allocate(byte, allineamento);
+
+		std::lock_guard<std::mutex> blocco(mutex);
+		Lista &l = lista(byte);
+		if (!l.liberi.empty()) {
+			void *p = l.liberi.back();
+			l.liberi.pop_back();
+			return p;
+		}
+		allocazioni++;
+		return aMonte->allocate(l.dimensione, ALLINEAMENTO);
+	}
+
+	/* Funzione do_deallocate(void *p, std::size_t byte, std::size_t allineamento):
+		- rimette il blocco nella lista della sua dimensione, senza restituirlo alla risorsa a monte
+	*/
+	void RiservaSlot::do_deallocate(void *p, std::size_t byte, std::size_t allineamento) {
+		if (allineamento > ALLINEAMENTO) {
+			aMonte->deallocate(p, byte, allineamento);
+			return;
+		}
+
+		std::lock_guard<std::mutex> blocco(mutex);
+		lista(byte).liberi.push_back(p);
+	}
+
+	/* Funzione do_is_equal(const memory_resource &altra):
+		- un blocco può essere restituito solo alla riserva da cui è stato preso
+	*/
+	bool RiservaSlot::do_is_equal(const std::pmr::memory_resource &altra) const noexcept {
+		return this == &altra;
+	}
+}
@@ -0,0 +1,399 @@
+/*
+	FILE BENCHMARK.CPP
+
+	Misura le prestazioni delle funzioni della classe LidarDriver e delle sue varianti.
+	Si compila con "make benchmark" (con le ottimizzazioni attive) e si esegue con ./build/benchmark
+
+	Per ogni prova viene stampato il tempo medio per operazione in nanosecondi.
+	Per la suite con le iterazioni calibrate, le allocazioni e l'output per i programmi (da usare per
+	controllare le regressioni) vedi prestazioni.cpp ("make prestazioni").
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <vector>
+#include "../include/LidarDriver.h"
+#include "../include/FlottaLidar.h"
+#include "../include/FormattatoreTesto.h"
+#include "../include/GruppoThread.h"
+#include "../include/RiservaSlot.h"
+using namespace std;
+using namespace lidar_driver;
+
+// impedisce al compilatore di eliminare i calcoli il cui risultato non viene usato
+volatile double pozzo;
+
+/* Funzione misura:
+	- esegue la funzione f per "ripetizioni" volte e restituisce il tempo medio in ns per chiamata
+*/
+template <typename F>
+double misura(int ripetizioni, F f) {
+	auto inizio = chrono::steady_clock::now();
+	for (int i = 0; i < ripetizioni; i++)
+		f();
+	auto fine = chrono::steady_clock::now();
+	return chrono::duration<double, nano>(fine - inizio).count() / ripetizioni;
+}
+
+/* Funzione stampa:
+	- stampa una riga della tabella dei risultati
+*/
+void stampa(const string &nome, double ns) {
+	cout << nome << " : " << ns << " ns/op" << endl;
+}
+
+/* Funzione testo_vecchio:
+	- la vecchia implementazione di operator<< (copia dell'ultima scansione con get_last e una
+	  std::to_string per misura aggiunta a una stringa che cresce), tenuta per il confronto
+*/
+string testo_vecchio(const LidarDriver &ld) {
+	vector<double> temp = ld.get_last();
+	string s = "{ ";
+	for (size_t i = 0; i < temp.size(); i++) {
+		s += to_string(temp[i]);
+		if (i < temp.size() - 1)
+			s += ", ";
+	}
+	s += " }\n";
+	return s;
+}
+
+int main() {
+	// lidar con risoluzione 0.1, quindi 1801 misure per scansione
+	LidarDriver ld(0.1);
+	vector<double> scansione(1801);
+	for (int i = 0; i < 1801; i++)
+		scansione[i] = i;
+	ld.new_scan(scansione);
+
+	// get_distance in un ciclo (come in main.cpp) contro get_distances, su 512 angoli
+	vector<double> angoli(512), distanze(512);
+	for (int i = 0; i < 512; i++)
+		angoli[i] = i * 0.35;
+
+	double ciclo = misura(20000, [&]() {
+		for (int i = 0; i < 512; i++)
+			distanze[i] = ld.get_distance(angoli[i]);
+		pozzo = distanze[0];
+	});
+	double batch = misura(20000, [&]() {
+		ld.get_distances(angoli, distanze);
+		pozzo = distanze[0];
+	});
+	double settore = misura(20000, [&]() {
+		ld.get_distances(0, 511 * 0.35, 0.35, distanze);
+		pozzo = distanze[0];
+	});
+	stampa("get_distance x512 (ciclo)", ciclo);
+	stampa("get_distances x512 (batch)", batch);
+	stampa("get_distances x512 (settore)", settore);
+
+	// inserimento: vector lvalue, span di un pacchetto grezzo, pacchetto da 10 scansioni con new_scans
+	vector<double> pacchetto(10 * 1801, 1.0);
+	vector<double> corta(1000, 1.0);
+	stampa("new_scan vector 1801", misura(100000, [&]() { ld.new_scan(scansione); }));
+	stampa("new_scan vector 1000 (completata con zeri)", misura(100000, [&]() { ld.new_scan(corta); }));
+	stampa("new_scan span 1801", misura(100000, [&]() { ld.new_scan(span<const double>(pacchetto.data(), 1801)); }));
+	stampa("new_scans 10x1801 (per scansione)", misura(10000, [&]() { ld.new_scans(pacchetto, 1801); }) / 10);
+
+	// inserimento con il diario su file (mappato in memoria, 4096 record)
+	{
+		string percorso = (filesystem::temp_directory_path() / "lidar_diario_benchmark.bin").string();
+		remove(percorso.c_str());
+		LidarDriver ldDiario(0.1);
+		ldDiario.apri_diario(percorso, 4096);
+		stampa("new_scan vector 1801 (con diario)", misura(100000, [&]() { ldDiario.new_scan(scansione); }));
+		ldDiario.chiudi_diario();
+		remove(percorso.c_str());
+	}
+
+	// formati delle misure: inserimento, lettura dell'ultima scansione, get_distances e memoria occupata
+	struct { const char *nome; FormatoCampioni formato; } formati[] = {
+		{"DOUBLE", FormatoCampioni::DOUBLE}, {"FLOAT", FormatoCampioni::FLOAT}, {"UINT16", FormatoCampioni::UINT16}
+	};
+	vector<double> metri(1801), letti(1801);
+	for (int i = 0; i < 1801; i++)
+		metri[i] = 0.5 + i * 0.01;
+	for (auto f : formati) {
+		LidarDriver ldf(0.1, f.formato, 0.001);
+		string nome = string(" [") + f.nome + "]";
+		stampa("new_scan 1801" + nome, misura(100000, [&]() { ldf.new_scan(metri); }));
+		stampa("get_last 1801" + nome, misura(100000, [&]() { pozzo = ldf.get_last()[0]; }));
+		stampa("get_last_view + copia_in 1801" + nome, misura(100000, [&]() { ldf.get_last_view().copia_in(letti.data()); pozzo = letti[0]; }));
+		stampa("get_distances x512" + nome, misura(20000, [&]() { ldf.get_distances(angoli, distanze); pozzo = distanze[0]; }));
+		cout << "memoria buffer" << nome << " : " << ldf.memoria_buffer() << " byte" << endl;
+	}
+
+	// scrittura del buffer intero (10 scansioni da 1801 misure): testo con operator<< (solo l'ultima
+	// scansione!) contro formato binario su stream e in memoria
+	LidarDriver ldPieno(0.1);
+	for (int k = 0; k < 10; k++)
+		ldPieno.new_scan(metri);
+	vector<unsigned char> binario(ldPieno.dimensione_binaria());
+	ostringstream testo, stream;
+	double tTesto = misura(200, [&]() { testo.str(""); testo << ldPieno; });
+	double tStream = misura(2000, [&]() { stream.str(""); ldPieno.write_buffer(stream); });
+	double tMemoria = misura(20000, [&]() { ldPieno.write_buffer(binario); });
+	double tLettura = misura(2000, [&]() { pozzo = LidarDriver::read_buffer(span<const unsigned char>(binario)).get_dim_buffer(); });
+	stampa("operator<< (1 scansione)", tTesto);
+	stampa("write_buffer stream (10 scansioni)", tStream);
+	stampa("write_buffer memoria (10 scansioni)", tMemoria);
+	stampa("read_buffer memoria (10 scansioni)", tLettura);
+	cout << "throughput operator<< : " << 1801 * sizeof(double) / tTesto * 1e3 << " MB/s di misure" << endl;
+	cout << "throughput write_buffer memoria : " << binario.size() / tMemoria * 1e3 << " MB/s" << endl;
+
+	// interpolazione e fusione delle ultime 10 scansioni: ciclo di get_distance_fusa (un blocco di una
+	// misura per volta) contro get_scan_fusa (kernel a blocchi vettorizzati)
+	vector<double> fusa(1801);
+	stampa("get_distance_interpolata x512", misura(20000, [&]() {
+		for (int i = 0; i < 512; i++)
+			distanze[i] = ldPieno.get_distance_interpolata(angoli[i]);
+		pozzo = distanze[0];
+	}));
+	for (Fusione modo : {Fusione::MEDIA, Fusione::MEDIANA}) {
+		string nome = (modo == Fusione::MEDIA) ? " [MEDIA]" : " [MEDIANA]";
+		stampa("get_distance_fusa x1801 (ciclo)" + nome, misura(200, [&]() {
+			for (int i = 0; i < 1801; i++)
+				fusa[i] = ldPieno.get_distance_fusa(i * 0.1, 10, modo);
+			pozzo = fusa[0];
+		}));
+		stampa("get_scan_fusa 1801" + nome, misura(2000, [&]() { ldPieno.get_scan_fusa(10, modo, fusa); pozzo = fusa[0]; }));
+	}
+
+	// filtri: new_scan con tutti i filtri (maschera, limiti, picchi, mediana su 5 misure) applicati nello
+	// slot, contro la copia con get_last e un ciclo scalare per ogni consumatore
+	LidarDriver ldFiltri(0.1);
+	ldFiltri.set_filtri({true, 0.05, 60, 1, 5, Fusione::MEDIANA});
+	stampa("new_scan 1801 con filtri (mediana 5)", misura(20000, [&]() { ldFiltri.new_scan(metri); }));
+	ldFiltri.set_filtri({true, 0.05, 60, 1, 5, Fusione::MEDIA});
+	stampa("new_scan 1801 con filtri (media 5)", misura(20000, [&]() { ldFiltri.new_scan(metri); }));
+	stampa("get_last + filtri scalari (mediana 5)", misura(2000, [&]() {
+		vector<double> v = ldPieno.get_last();
+		vector<double> out(v.size());
+		for (size_t i = 0; i < v.size(); i++) {
+			double finestra[5];
+			int c = 0;
+			for (int d = -2; d <= 2; d++)
+				if (i + d < v.size() && v[i + d] > 0.05 && v[i + d] < 60)
+					finestra[c++] = v[i + d];
+			sort(finestra, finestra + c);
+			out[i] = (c == 0) ? 0 : (finestra[(c - 1) / 2] + finestra[c / 2]) / 2;
+		}
+		pozzo = out[0];
+	}));
+
+	// punti cartesiani dell'ultima scansione: std::cos e std::sin per ogni misura contro to_points
+	// (tabelle calcolate nel costruttore e un ciclo vettorizzato), anche con le misure FLOAT
+	vector<double> px(1801), py(1801);
+	double tTrig = misura(2000, [&]() {
+		VistaScansione v = ldPieno.get_last_view();
+		for (int i = 0; i < v.size(); i++) {
+			double angolo = i * 0.1 * M_PI / 180;
+			px[i] = v[i] * cos(angolo);
+			py[i] = v[i] * sin(angolo);
+		}
+		pozzo = px[0] + py[0];
+	});
+	double tPunti = misura(20000, [&]() { ldPieno.to_points(px, py); pozzo = px[0] + py[0]; });
+	LidarDriver ldPuntiFloat(0.1, FormatoCampioni::FLOAT);
+	ldPuntiFloat.new_scan(metri);
+	stampa("punti 1801 (std::cos e std::sin)", tTrig);
+	stampa("punti 1801 (to_points)", tPunti);
+	stampa("punti 1801 (to_points) [FLOAT]", misura(20000, [&]() { ldPuntiFloat.to_points(px, py); pozzo = px[0] + py[0]; }));
+	cout << "accelerazione to_points : " << tTrig / tPunti << "x" << endl;
+
+	// statistiche dell'ultima scansione: passaggi separati su una copia (get_last) contro il calcolo
+	// in new_scan e la lettura O(1) con closest_obstacle
+	LidarDriver ldStat(0.1);
+	ldStat.new_scan(metri);
+	double tCopia = misura(20000, [&]() {
+		vector<double> v = ldStat.get_last();
+		double minimo = INFINITY, massimo = 0, somma = 0;
+		int angolo = 0, valide = 0;
+		for (int i = 0; i < (int)v.size(); i++)
+			if (v[i] > 0 && v[i] < minimo) {
+				minimo = v[i];
+				angolo = i;
+			}
+		for (double d : v)
+			massimo = max(massimo, d);
+		for (double d : v)
+			if (d > 0) {
+				somma += d;
+				valide++;
+			}
+		pozzo = minimo + angolo + massimo + somma / valide;
+	});
+	double tSenza = misura(100000, [&]() { ldStat.new_scan(metri); });
+	ldStat.set_statistiche(true);
+	double tCon = misura(100000, [&]() { ldStat.new_scan(metri); });
+	ldStat.set_statistiche(true, 10);
+	double tSettori = misura(100000, [&]() { ldStat.new_scan(metri); });
+	stampa("statistiche 1801 (get_last + 3 passaggi)", tCopia);
+	stampa("new_scan 1801 senza statistiche", tSenza);
+	stampa("new_scan 1801 con statistiche", tCon);
+	stampa("new_scan 1801 con statistiche (settori di 10 gradi)", tSettori);
+	stampa("closest_obstacle", misura(1000000, [&]() { pozzo = ldStat.closest_obstacle().first; }));
+	cout << "costo delle statistiche in new_scan : " << tCon - tSenza << " ns" << endl;
+
+	// istantanee per il thread di diagnostica (10 scansioni da 1801 misure): copia del driver (slot
+	// condivisi, copy-on-write) contro la copia profonda di tutte le misure che faceva la vecchia copia,
+	// da sola e in un ciclo new_scan + istantanea; memoria propria della copia in byte
+	LidarDriver ldIstantanee = ldPieno;
+	double tIstantanea = misura(200000, [&]() { LidarDriver copia = ldIstantanee; pozzo = copia.size(); });
+	auto copiaProfonda = [&]() {
+		vector<double> misure(ldIstantanee.size() * 1801);
+		for (int k = 0; k < ldIstantanee.size(); k++)
+			ldIstantanee.get_view(k).copia_in(misure.data() + k * 1801);
+		pozzo = misure[0];
+	};
+	double tProfonda = misura(20000, copiaProfonda);
+	stampa("istantanea 10x1801 (copia copy-on-write)", tIstantanea);
+	stampa("istantanea 10x1801 (copia profonda)", tProfonda);
+	stampa("new_scan + istantanea (copy-on-write)", misura(100000, [&]() {
+		ldIstantanee.new_scan(metri);
+		LidarDriver copia = ldIstantanee;
+		pozzo = copia.size();
+	}));
+	stampa("new_scan + istantanea (copia profonda)", misura(20000, [&]() {
+		ldIstantanee.new_scan(metri);
+		copiaProfonda();
+	}));
+	LidarDriver copiaMemoria = ldIstantanee;
+	cout << "memoria propria istantanea copy-on-write : " << copiaMemoria.memoria_buffer() - copiaMemoria.memoria_condivisa() << " byte" << endl;
+	cout << "memoria propria copia profonda : " << ldIstantanee.memoria_buffer() << " byte" << endl;
+	cout << "accelerazione istantanea : " << tProfonda / tIstantanea << "x" << endl;
+
+	// riserva di slot: il ciclo new_scan + istantanea (che copia lo slot sovrascritto) e la
+	// "riconnessione" di un sensore (driver nuovo, o clear_buffer, e 10 scansioni) con gli slot
+	// dall'heap e da una RiservaSlot; a regime la riserva non deve più chiedere memoria all'heap
+	RiservaSlot riserva;
+	LidarDriver ldRiserva = ldPieno;
+	ldRiserva.set_risorsa(&riserva, 2);
+	stampa("new_scan + istantanea (slot dall'heap)", misura(100000, [&]() {
+		ldIstantanee.new_scan(metri);
+		LidarDriver copia = ldIstantanee;
+		pozzo = copia.size();
+	}));
+	stampa("new_scan + istantanea (RiservaSlot)", misura(100000, [&]() {
+		ldRiserva.new_scan(metri);
+		LidarDriver copia = ldRiserva;
+		pozzo = copia.size();
+	}));
+	stampa("riconnessione 10x1801 (driver nuovo, heap)", misura(20000, [&]() {
+		LidarDriver nuovo(0.1);
+		for (int k = 0; k < 10; k++)
+			nuovo.new_scan(metri);
+		pozzo = nuovo.size();
+	}));
+	stampa("riconnessione 10x1801 (clear_buffer)", misura(20000, [&]() {
+		ldRiserva.clear_buffer();
+		for (int k = 0; k < 10; k++)
+			ldRiserva.new_scan(metri);
+		pozzo = ldRiserva.size();
+	}));
+	size_t allocazioniPrima = riserva.allocazioni_a_monte();
+	stampa("riconnessione 10x1801 (shrink_to_fit + RiservaSlot)", misura(20000, [&]() {
+		ldRiserva.clear_buffer();
+		ldRiserva.shrink_to_fit();
+		for (int k = 0; k < 10; k++)
+			ldRiserva.new_scan(metri);
+		pozzo = ldRiserva.size();
+	}));
+	cout << "allocazioni a monte della riserva a regime : " << riserva.allocazioni_a_monte() - allocazioniPrima << endl;
+
+	// elaborazione di tutte le scansioni di un buffer profondo (1024 scansioni da 1801 misure): mediana
+	// su 5 misure e minimo per ogni scansione, una alla volta con get_view contro for_each_scan con
+	// 1, 2, 4, ... thread (al massimo quelli del gruppo condiviso più il thread che chiama)
+	LidarDriver ldProfondo(0.1, 1024);
+	for (int k = 0; k < 1024; k++)
+		ldProfondo.new_scan(metri);
+	auto analizza = [](int, const VistaScansione &v) {
+		double minimo = INFINITY;
+		for (int i = 2; i < v.size() - 2; i++) {
+			double finestra[5] = {v[i - 2], v[i - 1], v[i], v[i + 1], v[i + 2]};
+			nth_element(finestra, finestra + 2, finestra + 5);
+			if (finestra[2] > 0)
+				minimo = min(minimo, finestra[2]);
+		}
+		return minimo;
+	};
+	vector<double> minimi(1024);
+	double tSeriale = misura(5, [&]() {
+		for (int k = 0; k < ldProfondo.size(); k++)
+			minimi[k] = analizza(k, ldProfondo.get_view(k));
+		pozzo = minimi[0];
+	});
+	stampa("analisi 1024x1801 (get_view, 1 thread)", tSeriale);
+	for (int t = 1; t <= GruppoThread::condiviso().size() + 1; t *= 2) {
+		double tParallelo = misura(5, [&]() {
+			ldProfondo.for_each_scan([&](int k, const VistaScansione &v) { minimi[k] = analizza(k, v); }, t);
+			pozzo = minimi[0];
+		});
+		stampa("analisi 1024x1801 (for_each_scan, " + to_string(t) + " thread)", tParallelo);
+		cout << "accelerazione for_each_scan " << t << " thread : " << tSeriale / tParallelo << "x" << endl;
+	}
+	stampa("analisi 1024x1801 (transform_scans)", misura(5, [&]() { pozzo = ldProfondo.transform_scans(analizza)[0]; }));
+	GruppoThread gruppo4(3);
+	stampa("analisi 1024x1801 (GruppoThread da 4 thread)", misura(5, [&]() {
+		gruppo4.per_ogni(ldProfondo.size(), [&](int k) { minimi[k] = analizza(k, ldProfondo.get_view(k)); });
+		pozzo = minimi[0];
+	}));
+
+	// flotta di lidar: un "giro" del robot (una scansione filtrata, con le statistiche, per ogni
+	// sensore) inserito a mano da un solo thread contro FlottaLidar con 1..N lavoratori, e l'ostacolo
+	// più vicino tra tutti i sensori; l'accelerazione dipende dai core disponibili
+	cout << "core disponibili : " << thread::hardware_concurrency() << endl;
+	for (int sensori : {1, 2, 4, 8}) {
+		vector<LidarDriver> aMano(sensori, LidarDriver(0.1));
+		for (LidarDriver &d : aMano) {
+			d.set_filtri({true, 0.05, 60, 1, 5, Fusione::MEDIANA});
+			d.set_statistiche(true, 10);
+		}
+		double tMano = misura(2000, [&]() {
+			for (LidarDriver &d : aMano)
+				d.new_scan(metri);
+		});
+		stampa("giro " + to_string(sensori) + " sensori (a mano, 1 thread)", tMano);
+
+		for (int lavoratori = 1; lavoratori <= sensori; lavoratori *= 2) {
+			FlottaLidar flotta(sensori, 0.1, lavoratori);
+			for (int s = 0; s < sensori; s++)
+				flotta.con_driver(s, [](LidarDriver &d) {
+					d.set_filtri({true, 0.05, 60, 1, 5, Fusione::MEDIANA});
+					d.set_statistiche(true, 10);
+				});
+			double tFlotta = misura(2000, [&]() {
+				for (int s = 0; s < sensori; s++)
+					flotta.new_scan(s, metri);
+				flotta.attendi();
+			});
+			string nome = to_string(sensori) + " sensori, " + to_string(lavoratori) + " lavoratori";
+			stampa("giro " + nome + " (FlottaLidar)", tFlotta);
+			stampa("closest_obstacle " + nome, misura(20000, [&]() { pozzo = flotta.closest_obstacle().distanza; }));
+			cout << "accelerazione giro " << nome << " : " << tMano / tFlotta << "x" << endl;
+		}
+	}
+
+	// testo leggibile: vecchia operator<< (get_last + to_string) contro FormattatoreTesto (to_chars
+	// dallo slot in una stringa riusata), anche con 3 decimali, per tutto il buffer e per un settore
+	FormattatoreTesto formattatore;
+	FormattatoreTesto formattatore3({3, ";"});
+	double tVecchio = misura(200, [&]() { pozzo = testo_vecchio(ldPieno).size(); });
+	double tNuovo = misura(200, [&]() { pozzo = formattatore.formatta_ultima(ldPieno).size(); });
+	stampa("testo 1801 (vecchio: get_last + to_string)", tVecchio);
+	stampa("testo 1801 (operator<<)", tTesto);
+	stampa("testo 1801 (FormattatoreTesto)", tNuovo);
+	stampa("testo 1801 (FormattatoreTesto, 3 decimali)", misura(200, [&]() { pozzo = formattatore3.formatta_ultima(ldPieno).size(); }));
+	stampa("testo buffer 10x1801 (FormattatoreTesto)", misura(20, [&]() { pozzo = formattatore.formatta_buffer(ldPieno).size(); }));
+	stampa("testo settore 45-135 (FormattatoreTesto)", misura(200, [&]() { pozzo = formattatore.formatta_settore(ldPieno, 45, 135).size(); }));
+	cout << "accelerazione FormattatoreTesto : " << tVecchio / tNuovo << "x" << endl;
+
+	return 0;
+}
@@ -6,7 +6,32 @@
 */
 
 #include <iostream>
+#include <thread>
+#include <atomic>
+#include <list>
+#include <cmath>
+#include <sstream>
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <map>
+#include <cstdint>
+#include <chrono>
+#include <coroutine>
+#include <span>
 #include "../include/LidarDriver.h"
+#include "../include/LidarDriverConcorrente.h"
+#include "../include/LidarDriverFisso.h"
+#include "../include/FormattatoreTesto.h"
+#include "../include/DiarioScansioni.h"
+#include "../include/FlottaLidar.h"
+#include "../include/GruppoThread.h"
+#include "../include/RiservaSlot.h"
+#include "../include/MetricheLidar.h"
 using namespace std;
 using namespace lidar_driver;
 
@@ -152,5 +177,1394 @@ int main() {
 		cout << "<<errore voluto - eccezione lanciata correttamente se si vuole leggere una misura in un buffer vuoto>>" << endl;
 	}
 
+	// ora testo le viste: get_last_view deve vedere gli stessi dati di get_last senza copiarli
+	// e la vista di get_scan_view deve diventare non valida quando il suo slot viene sovrascritto
+	ld1.new_scan(v1);
+	VistaScansione vl = ld1.get_last_view();
+	vector<double> copia = ld1.get_last();
+	if (vector<double>(vl.begin(), vl.end()) == copia && vl.valida())
+		cout << "vista ultima scansione -> corretta" << endl;
+	else
+		cout << "vista ultima scansione -> sbagliata" << endl;
+
+	VistaScansione vs = ld1.get_scan_view();
+	bool validaPrima = vs.valida() && vs[180] == 180;
+	for (int i = 0; i < 10; i++)
+		ld1.new_scan(v2);
+	if (validaPrima && !vs.valida())
+		cout << "vista invalidata dopo la sovrascrittura -> corretto" << endl;
+	else
+		cout << "vista invalidata dopo la sovrascrittura -> sbagliato" << endl;
+
+	// il LidarDriverFisso con risoluzione nota a tempo di compilazione deve comportarsi come LidarDriver
+	LidarDriver ldr(0.5);
+	LidarDriverFisso<0.5> ldf;
+	vector<double> v3(400);
+	for (int i = 0; i < 400; i++)
+		v3[i] = i * 0.5;
+	ldr.new_scan(v3);
+	ldf.new_scan(v3);
+	bool uguali = ldr.get_last() == ldf.get_last();
+	for (double a = 0; a <= 180; a += 0.3)
+		if (ldr.get_distance(a) != ldf.get_distance(a))
+			uguali = false;
+	try {
+		ldf.get_distance(NAN);
+		uguali = false;
+	} catch (LidarDriverFisso<0.5>::AngoloForaDaiRangeError) {
+		cout << "<<errore voluto - angolo NaN nel LidarDriverFisso>>" << endl;
+	}
+	if (uguali && LidarDriverFisso<0.5>::DIM_SCANSIONI == 361)
+		cout << "LidarDriverFisso uguale a LidarDriver -> corretto" << endl;
+	else
+		cout << "LidarDriverFisso uguale a LidarDriver -> sbagliato" << endl;
+
+	// get_distances deve dare gli stessi risultati di get_distance chiamata in un ciclo, anche con una
+	// risoluzione che non divide 180 (l'angolo 180 va sull'ultima misura)
+	LidarDriver ldg(0.65);
+	vector<double> v4(277);
+	for (int i = 0; i < 277; i++)
+		v4[i] = i;
+	ldg.new_scan(v4);
+	vector<double> angoli, batch(1000), settore(1000);
+	for (int i = 0; i < 1000; i++)
+		angoli.push_back(i * 0.1801);
+	angoli.push_back(180);
+	batch.resize(angoli.size());
+	ldg.get_distances(angoli, batch);
+	bool batchOk = true;
+	for (int i = 0; i < static_cast<int>(angoli.size()); i++)
+		if (batch[i] != ldg.get_distance(angoli[i]))
+			batchOk = false;
+	int nSettore = ldg.get_distances(10, 20, 0.5, settore);
+	for (int i = 0; i < nSettore; i++)
+		if (settore[i] != ldg.get_distance(10 + i * 0.5))
+			batchOk = false;
+	if (batchOk && nSettore == 21)
+		cout << "get_distances uguale a get_distance -> corretto" << endl;
+	else
+		cout << "get_distances uguale a get_distance -> sbagliato" << endl;
+	try {
+		angoli.push_back(181);
+		batch.resize(angoli.size());
+		ldg.get_distances(angoli, batch);
+	} catch (LidarDriver::AngoloForaDaiRangeError) {
+		cout << "<<errore voluto - get_distances rifiuta gli angoli fuori range>>" << endl;
+	}
+	try {
+		// con un passo così piccolo il numero di angoli non sta in un int: va rifiutato prima di convertirlo
+		ldg.get_distances(0, 180, 1e-300, settore);
+	} catch (LidarDriver::DimensionOutputSbagliataError) {
+		cout << "<<errore voluto - get_distances con un passo troppo piccolo per l'output>>" << endl;
+	}
+
+	// new_scans con un pacchetto di 13 scansioni (più del buffer) deve lasciare il buffer come 13 new_scan,
+	// e new_scan con due iteratori di una lista deve troncare/completare come con un vector
+	LidarDriver ldSingole(1), ldPacchetto(1);
+	ldSingole.new_scan(v1);
+	ldPacchetto.new_scan(v1);
+	vector<double> pacchetto;
+	for (int k = 0; k < 13; k++) {
+		vector<double> s(150, k);
+		ldSingole.new_scan(s);
+		pacchetto.insert(pacchetto.end(), s.begin(), s.end());
+	}
+	ldPacchetto.new_scans(pacchetto, 150);
+	bool pacchettoOk = true;
+	for (int k = 0; k < 10; k++)
+		if (ldSingole.get_scan() != ldPacchetto.get_scan())
+			pacchettoOk = false;
+	list<double> lista(v1.begin(), v1.begin() + 100);
+	ldPacchetto.new_scan(lista.begin(), lista.end());
+	vector<double> dallaLista = ldPacchetto.get_last();
+	if (pacchettoOk && dallaLista[99] == 99 && dallaLista[100] == 0 && dallaLista.size() == 181)
+		cout << "new_scans e new_scan da iteratori -> corretto" << endl;
+	else
+		cout << "new_scans e new_scan da iteratori -> sbagliato" << endl;
+
+	// formati compatti: con FLOAT e UINT16 (scala 1 mm) le misure lette devono differire da quelle
+	// inserite al massimo per l'arrotondamento, e il buffer deve occupare 1/2 e 1/4 della memoria
+	LidarDriver ldD(0.1), ldF(0.1, FormatoCampioni::FLOAT), ldU(0.1, FormatoCampioni::UINT16, 0.001);
+	vector<double> metri(1801);
+	for (int i = 0; i < 1801; i++)
+		metri[i] = 0.5 + i * 0.0271828;
+	ldD.new_scan(metri);
+	ldF.new_scan(metri);
+	ldU.new_scan(metri);
+	bool formatiOk = ldF.memoria_buffer() * 2 == ldD.memoria_buffer() && ldU.memoria_buffer() * 4 == ldD.memoria_buffer();
+	vector<double> lettiF = ldF.get_last(), lettiU = ldU.get_last();
+	for (int i = 0; i < 1801; i++) {
+		if (abs(lettiF[i] - metri[i]) > 1e-5 || abs(lettiU[i] - metri[i]) > 0.00051)
+			formatiOk = false;
+		if (abs(ldU.get_distance(i * 0.1) - metri[i]) > 0.00051 || abs(ldU.get_last_view()[i] - metri[i]) > 0.00051)
+			formatiOk = false;
+	}
+	// con le misure compatte gli iteratori della vista convertono come operator[], mentre data() e
+	// span() non danno accesso diretto ai byte dello slot
+	VistaScansione vistaU = ldU.get_last_view(), vistaF = ldF.get_last_view();
+	formatiOk = formatiOk && vector<double>(vistaU.begin(), vistaU.end()) == lettiU
+	            && vector<double>(vistaF.begin(), vistaF.end()) == lettiF
+	            && vistaU.span().empty() && vistaU.data() == nullptr && vistaF.span().empty()
+	            && ldD.get_last_view().span().size() == 1801;
+	if (formatiOk)
+		cout << "formati FLOAT e UINT16 -> corretti" << endl;
+	else
+		cout << "formati FLOAT e UINT16 -> sbagliati" << endl;
+
+	// dimensione del buffer scelta a runtime: con 4 scansioni (potenza di 2) e 6 inserimenti restano le
+	// ultime 4; riducendo a 3 restano le 3 più nuove, allargando a 7 c'è posto per altre 4; le viste
+	// ottenute prima (e prima di un assegnamento di copia) non devono più risultare valide
+	LidarDriver ld4(1, 4);
+	for (int k = 0; k < 6; k++)
+		ld4.new_scan(vector<double>(181, k));
+	VistaScansione primaDelCambio = ld4.get_last_view();
+	ld4.set_dim_buffer(3);
+	ld4.set_dim_buffer(7);
+	for (int k = 6; k < 10; k++)
+		ld4.new_scan(vector<double>(181, k));
+	bool dimOk = ld4.get_dim_buffer() == 7 && !primaDelCambio.valida();
+	{
+		LidarDriver assegnato(1, 2);
+		assegnato.new_scan(vector<double>(181, 1));
+		VistaScansione primaDellAssegnamento = assegnato.get_last_view();
+		assegnato = ld4;
+		dimOk = dimOk && !primaDellAssegnamento.valida() && assegnato.get_view(6)[0] == 9;
+	}
+	for (int k = 3; k < 10; k++)
+		if (ld4.get_scan()[0] != k)
+			dimOk = false;
+	LidarDriver ldBudget(1, BudgetMemoria{181 * sizeof(double) * 5 + 100});
+	if (dimOk && ldBudget.get_dim_buffer() == 5)
+		cout << "dimensione del buffer configurabile -> corretta" << endl;
+	else
+		cout << "dimensione del buffer configurabile -> sbagliata" << endl;
+
+	// formato binario: il buffer salvato su uno stream o in memoria e riletto deve avere le stesse
+	// scansioni nello stesso ordine; le scansioni registrate con write_scan e rilette con read_scan
+	// in un driver FLOAT devono essere convertite
+	LidarDriver ldSalvato(0.5, 4, FormatoCampioni::UINT16, 0.01);
+	for (int k = 0; k < 6; k++)
+		ldSalvato.new_scan(vector<double>(361, k + 0.25));
+	stringstream file;
+	ldSalvato.write_buffer(file);
+	vector<unsigned char> memoria(ldSalvato.dimensione_binaria());
+	ldSalvato.write_buffer(memoria);
+	LidarDriver ldDaFile = LidarDriver::read_buffer(file);
+	LidarDriver ldDaMemoria = LidarDriver::read_buffer(span<const unsigned char>(memoria));
+
+	stringstream registrazione;
+	LidarDriver ldRiletto(0.5, FormatoCampioni::FLOAT);
+	bool binarioOk = ldDaFile.get_dim_buffer() == 4 && ldDaFile.get_formato() == FormatoCampioni::UINT16;
+	for (int k = 2; k < 6; k++) {
+		vector<double> originale = ldSalvato.get_scan();
+		if (ldDaFile.get_scan() != originale || ldDaMemoria.get_scan() != originale || originale[0] != k + 0.25)
+			binarioOk = false;
+		ldRiletto.new_scan(originale);
+		ldRiletto.write_scan(registrazione);
+	}
+	LidarDriver ldReplay(0.5);
+	for (int k = 2; k < 6; k++)
+		ldReplay.read_scan(registrazione);
+	for (int k = 2; k < 6; k++)
+		if (ldReplay.get_scan()[360] != k + 0.25)
+			binarioOk = false;
+	try {
+		ld1.read_scan(registrazione);
+	} catch (LidarDriver::FileSbagliatoError) {
+		cout << "<<errore voluto - read_scan a fine file>>" << endl;
+	}
+	{
+		// stream troncato a metà delle misure con il buffer pieno: la scansione più vecchia (che
+		// verrebbe sovrascritta) deve restare intatta, con il suo timestamp e la sua sequenza
+		LidarDriver ldPieno(0.5, 4);
+		for (int k = 0; k < 4; k++)
+			ldPieno.new_scan(vector<double>(361, k + 1), 1000 + k);
+		VistaScansione vecchia = ldPieno.get_view(0);
+		stringstream troncato;
+		ldRiletto.write_scan(troncato);
+		string byte = troncato.str();
+		troncato.str(byte.substr(0, byte.size() / 2));
+		try {
+			ldPieno.read_scan(troncato);
+			binarioOk = false;
+		} catch (LidarDriver::FileSbagliatoError) {
+			cout << "<<errore voluto - read_scan troncata>>" << endl;
+		}
+		binarioOk = binarioOk && ldPieno.size() == 4 && vecchia.valida() && ldPieno.get_view(0)[360] == 1
+		         && ldPieno.get_timestamp(0) == 1000 && ldPieno.get_sequenza(0) == 0 && ldPieno.get_last()[0] == 4;
+
+		// read_buffer dalla memoria: una scansione UINT16 con una scala diversa da quella del buffer
+		// verrebbe decodificata male, per cui viene rifiutata
+		vector<unsigned char> scalaDiversa = memoria;
+		double altraScala = 0.02;
+		memcpy(scalaDiversa.data() + sizeof(IntestazioneBuffer) + sizeof(IntestazioneScansione) + 361 * 2
+		       + offsetof(IntestazioneScansione, scala), &altraScala, sizeof(altraScala));
+		try {
+			LidarDriver::read_buffer(span<const unsigned char>(scalaDiversa));
+			binarioOk = false;
+		} catch (LidarDriver::FileSbagliatoError) {
+			cout << "<<errore voluto - read_buffer con scale diverse>>" << endl;
+		}
+	}
+	if (binarioOk)
+		cout << "scrittura e lettura binaria -> corrette" << endl;
+	else
+		cout << "scrittura e lettura binaria -> sbagliate" << endl;
+
+	// formattatore di testo: con le opzioni di default deve stampare come la vecchia operator<<
+	// (std::to_string), con opzioni diverse cambiano precisione e separatori; get_view deve
+	// restituire le scansioni dalla più vecchia alla più nuova
+	LidarDriver ldTesto(0.5, 3);
+	vector<double> misureTesto(361);
+	for (int i = 0; i < 361; i++)
+		misureTesto[i] = i * 0.123456789 - 7;
+	for (int k = 0; k < 4; k++) {
+		misureTesto[0] = k;
+		ldTesto.new_scan(misureTesto);
+	}
+	string atteso = "{ ";
+	for (int i = 0; i < 361; i++)
+		atteso += to_string(i == 0 ? 3.0 : misureTesto[i]) + (i < 360 ? ", " : " }\n");
+	stringstream stampato;
+	stampato << ldTesto;
+
+	FormattatoreTesto formattatore({2, "; ", "[", "]\n", "[]\n"});
+	bool testoOk = stampato.str() == atteso;
+	testoOk = testoOk && formattatore.formatta_settore(ldTesto, 0, 1) == "[3.00; -6.88; -6.75]\n";
+	testoOk = testoOk && formattatore.formatta_settore(ldTesto, 179.9, 180) == "[37.44]\n";
+	testoOk = testoOk && formattatore.formatta_buffer(ldTesto).substr(0, 10) == "[1.00; -6.";
+	testoOk = testoOk && ldTesto.size() == 3 && ldTesto.get_view(0)[0] == 1 && ldTesto.get_view(2)[0] == 3;
+	string tuttoIlBuffer(formattatore.formatta_buffer(ldTesto));
+	testoOk = testoOk && count(tuttoIlBuffer.begin(), tuttoIlBuffer.end(), '\n') == 3;
+	ldTesto.clear_buffer();
+	stampato.str("");
+	stampato << ldTesto;
+	testoOk = testoOk && stampato.str() == "{ }\n" && formattatore.formatta_buffer(ldTesto) == "[]\n";
+	try {
+		ldTesto.get_view(0);
+		testoOk = false;
+	} catch (LidarDriver::NoGheSonVettoriError) {
+		cout << "<<errore voluto - get_view su buffer vuoto>>" << endl;
+	}
+	if (testoOk)
+		cout << "formattazione testo -> corretta" << endl;
+	else
+		cout << "formattazione testo -> sbagliata" << endl;
+
+	// diario su file: le scansioni inserite vengono registrate (anche quelle già nel buffer quando si
+	// apre il diario) e, arrivati in fondo, si ricomincia dal primo record; dopo un "crash" (il driver
+	// viene distrutto senza chiudere niente e l'ultimo record viene lasciato scritto a metà) un
+	// lettore ricostruisce gli indici e un nuovo driver ricarica le scansioni più nuove
+	string percorsoDiario = (filesystem::temp_directory_path() / "lidar_diario_prova.bin").string();
+	remove(percorsoDiario.c_str());
+	bool diarioOk = true;
+	{
+		LidarDriver ldDiario(0.5, 4, FormatoCampioni::FLOAT);
+		ldDiario.new_scan(vector<double>(361, 1.25));
+		ldDiario.new_scan(vector<double>(361, 2.25));
+		ldDiario.apri_diario(percorsoDiario, 8);
+		for (int k = 3; k <= 12; k++)
+			ldDiario.new_scan(vector<double>(361, k + 0.25));
+		const DiarioScansioni *d = ldDiario.get_diario();
+		diarioOk = d->size() == 8 && d->get_view(0)[0] == 5.25 && d->get_view(7)[360] == 12.25
+		        && d->intestazione(7).sequenza == 11 && d->cerca_sequenza(9) == 5 && d->cerca_sequenza(3) == -1;
+		LidarDriver copia(ldDiario);
+		diarioOk = diarioOk && copia.get_diario() == nullptr;
+
+		// anche l'assegnamento di copia chiude il diario, che ha i parametri del vecchio driver
+		LidarDriver altraRisoluzione(1);
+		ldDiario = altraRisoluzione;
+		ldDiario.new_scan(vector<double>(181, 1));
+		diarioOk = diarioOk && ldDiario.get_diario() == nullptr;
+	}
+	{
+		DiarioScansioni lettore(percorsoDiario);
+		diarioOk = diarioOk && lettore.size() == 8 && lettore.get_view(0)[0] == 5.25 && lettore.get_view(7)[0] == 12.25;
+	}
+	{
+		// il record scritto per dodicesimo è il 3 (i primi due sono nei record 0 e 1): azzero il suo
+		// progressivo come se il processo si fosse fermato durante la scrittura
+		fstream file(percorsoDiario, ios::in | ios::out | ios::binary);
+		file.seekp(INIZIO_RECORD_DIARIO + 3 * ((sizeof(IntestazioneRecord) + sizeof(IntestazioneScansione) + 361 * sizeof(float) + 63) / 64 * 64)
+		           + offsetof(IntestazioneRecord, progressivo));
+		unsigned long long zero = 0;
+		file.write(reinterpret_cast<const char *>(&zero), sizeof(zero));
+	}
+	{
+		DiarioScansioni lettore(percorsoDiario);
+		diarioOk = diarioOk && lettore.size() == 7 && lettore.get_view(6)[0] == 11.25;
+
+		LidarDriver ldRipreso(0.5, 4, FormatoCampioni::FLOAT);
+		ldRipreso.apri_diario(percorsoDiario, 8);
+		diarioOk = diarioOk && ldRipreso.size() == 4 && ldRipreso.get_view(0)[0] == 8.25 && ldRipreso.get_last()[0] == 11.25;
+		ldRipreso.new_scan(vector<double>(361, 13.25));
+		lettore.aggiorna();
+		diarioOk = diarioOk && lettore.size() == 8 && lettore.get_view(7)[0] == 13.25 && lettore.intestazione(7).sequenza == 11;
+
+		// leggi deve rifiutare un record riscritto dal driver dopo l'ultima aggiorna del lettore
+		vector<double> letti(361);
+		diarioOk = diarioOk && lettore.leggi(7, letti.data()) && letti[360] == 13.25;
+		ldRipreso.new_scan(vector<double>(361, 14.25));
+		diarioOk = diarioOk && !lettore.leggi(0, letti.data()) && lettore.leggi(1, letti.data()) && letti[0] == 6.25;
+
+		// un lettore che legge mentre un thread scrive: le copie accettate da leggi devono essere intere
+		atomic<bool> fine{false};
+		thread scrittore([&]() {
+			for (int k = 0; k < 5000; k++)
+				ldRipreso.new_scan(vector<double>(361, k));
+			fine = true;
+		});
+		while (!fine) {
+			lettore.aggiorna();
+			if (lettore.leggi(lettore.size() - 1, letti.data()))
+				for (int i = 0; i < 361; i++)
+					if (letti[i] != letti[0])
+						diarioOk = false;
+		}
+		scrittore.join();
+	}
+	bool scrittoreAperto = false;
+	try {
+		DiarioScansioni scrittore(percorsoDiario, 8, 0.5, 361, FormatoCampioni::FLOAT, 0.001);
+		scrittoreAperto = true;
+		vector<double> doppie(181);
+		scrittore.scrivi(reinterpret_cast<const unsigned char *>(doppie.data()), 181, FormatoCampioni::DOUBLE, 0, 0);
+		diarioOk = false;
+	} catch (LidarDriver::FileSbagliatoError) {
+		diarioOk = diarioOk && scrittoreAperto;
+		cout << "<<errore voluto - scansione diversa dal diario>>" << endl;
+	}
+	try {
+		LidarDriver ldDiverso(1);
+		ldDiverso.apri_diario(percorsoDiario, 8);
+		diarioOk = false;
+	} catch (LidarDriver::FileSbagliatoError) {
+		cout << "<<errore voluto - diario con parametri diversi>>" << endl;
+	}
+	remove(percorsoDiario.c_str());
+	{
+		// timestamp e sequenze passati dal chiamante (es. quelli dello strumento) devono tornare uguali
+		// dopo la riapertura del diario, e le ricerche per tempo devono continuare a funzionare
+		LidarDriver ldStrumento(1, 4);
+		ldStrumento.apri_diario(percorsoDiario, 8);
+		for (int k = 0; k < 6; k++)
+			ldStrumento.new_scan(vector<double>(181, k), 1000 + 10 * k, 500 + 2 * k);
+	}
+	{
+		LidarDriver ldRiaperto(1, 4);
+		ldRiaperto.apri_diario(percorsoDiario, 8);
+		for (int k = 0; k < 4; k++)
+			if (ldRiaperto.get_timestamp(k) != 1020 + 10 * k || ldRiaperto.get_sequenza(k) != 504 + 2 * static_cast<unsigned long long>(k))
+				diarioOk = false;
+		ldRiaperto.new_scan(vector<double>(181, 6), 1060);
+		diarioOk = diarioOk && ldRiaperto.get_sequenza(3) == 511 && ldRiaperto.trova_vicina(1041) == 1
+		          && ldRiaperto.get_diario()->cerca_sequenza(506) == 3 && ldRiaperto.get_diario()->intestazione(6).timestamp == 1060;
+	}
+	remove(percorsoDiario.c_str());
+	if (diarioOk)
+		cout << "diario su file -> corretto" << endl;
+	else
+		cout << "diario su file -> sbagliato" << endl;
+
+	// timestamp e sequenze: le ricerche per tempo devono trovare la scansione più vicina e quelle
+	// in un intervallo anche dopo che il buffer ha girato; le scansioni sovrascritte senza essere
+	// lette devono essere contate; timestamp e sequenze devono sopravvivere alla scrittura binaria
+	LidarDriver ldTempi(1, 4);
+	for (int k = 1; k <= 6; k++)
+		ldTempi.new_scan(vector<double>(181, k), k * 100, 1000 + k);	// restano 300, 400, 500, 600
+	bool tempiOk = ldTempi.scansioni_perse() == 2 && ldTempi.get_timestamp(0) == 300 && ldTempi.get_sequenza(3) == 1006;
+	tempiOk = tempiOk && ldTempi.trova_vicina(0) == 0 && ldTempi.trova_vicina(349) == 0 && ldTempi.trova_vicina(351) == 1
+	                  && ldTempi.trova_vicina(350) == 0 && ldTempi.trova_vicina(10000) == 3
+	                  && ldTempi.get_view(ldTempi.trova_vicina(480))[0] == 5;
+	tempiOk = tempiOk && ldTempi.trova_intervallo(350, 500) == make_pair(1, 3) && ldTempi.trova_intervallo(400, 400) == make_pair(1, 2)
+	                  && ldTempi.trova_intervallo(601, 700) == make_pair(4, 4) && ldTempi.trova_intervallo(500, 100) == make_pair(2, 2);
+	ldTempi.new_scan(vector<double>(181, 7.0));	// sequenza successiva, timestamp attuale
+	tempiOk = tempiOk && ldTempi.get_sequenza(3) == 1007 && ldTempi.scansioni_perse() == 3;
+	ldTempi.get_scan();
+	ldTempi.new_scan(vector<double>(181, 8.0));	// c'era posto: nessuna persa
+	tempiOk = tempiOk && ldTempi.scansioni_perse() == 3;
+	stringstream fileTempi;
+	ldTempi.write_buffer(fileTempi);
+	LidarDriver ldTempiRiletto = LidarDriver::read_buffer(fileTempi);
+	for (int k = 0; k < 4; k++)
+		if (ldTempiRiletto.get_timestamp(k) != ldTempi.get_timestamp(k) || ldTempiRiletto.get_sequenza(k) != ldTempi.get_sequenza(k))
+			tempiOk = false;
+	try {
+		LidarDriver(1).trova_vicina(0);
+		tempiOk = false;
+	} catch (LidarDriver::NoGheSonVettoriError) {
+		cout << "<<errore voluto - trova_vicina su buffer vuoto>>" << endl;
+	}
+	{
+		// un timestamp minore dell'ultimo (anche da read_scan) va rifiutato senza toccare il buffer;
+		// senza timestamp si usa l'orologio, ma mai sotto l'ultimo (qui quello dello "strumento")
+		const long long strumento = 1LL << 62;
+		LidarDriver ldOrdinato(1, 4);
+		ldOrdinato.new_scan(vector<double>(181, 1), strumento, 0);
+		stringstream vecchia;
+		LidarDriver ldVecchio(1);
+		ldVecchio.new_scan(vector<double>(181, 2), 5, 0);
+		ldVecchio.write_scan(vecchia);
+		try {
+			ldOrdinato.new_scan(vector<double>(181, 2), strumento - 1, 1);
+			tempiOk = false;
+		} catch (LidarDriver::TimestampIndrioError) {
+			cout << "<<errore voluto - timestamp minore dell'ultimo>>" << endl;
+		}
+		try {
+			ldOrdinato.read_scan(vecchia);
+			tempiOk = false;
+		} catch (LidarDriver::TimestampIndrioError) {
+			tempiOk = tempiOk && ldOrdinato.size() == 1 && ldOrdinato.get_last()[0] == 1;
+		}
+		ldOrdinato.new_scan(vector<double>(181, 3));
+		ldOrdinato.new_scans(vector<double>(2 * 181, 4), 181);
+		tempiOk = tempiOk && ldOrdinato.size() == 4 && ldOrdinato.get_timestamp(3) == strumento
+		          && ldOrdinato.trova_vicina(strumento) == 0;
+	}
+	if (tempiOk)
+		cout << "timestamp e ricerche per tempo -> corretti" << endl;
+	else
+		cout << "timestamp e ricerche per tempo -> sbagliati" << endl;
+
+	// interpolazione e fusione: l'interpolazione è lineare tra le due misure vicine (saltando gli 0),
+	// media e mediana delle ultime N scansioni devono coincidere con quelle calcolate a mano sulle
+	// misure non nulle, sia con la rete di ordinamento (poche scansioni) sia senza (tante)
+	LidarDriver ldInterpolato(0.5);
+	vector<double> rampa(361);
+	for (int i = 0; i < 361; i++)
+		rampa[i] = i;
+	rampa[100] = 0;
+	ldInterpolato.new_scan(rampa);
+	bool fusioneOk = fabs(ldInterpolato.get_distance_interpolata(0.6) - 1.2) < 1e-9 && ldInterpolato.get_distance_interpolata(180) == 360
+	              && ldInterpolato.get_distance_interpolata(49.75) == 99 && ldInterpolato.get_distance_interpolata(50.25) == 101;
+
+	LidarDriver ldFuso(1, 32, FormatoCampioni::UINT16, 1);
+	for (int k = 0; k < 40; k++) {
+		vector<double> v(181);
+		for (int i = 0; i < 181; i++)
+			v[i] = (k * 7 + i * 3) % 11;	// un po' di misure a 0
+		ldFuso.new_scan(v);
+	}
+	vector<double> fusa(181);
+	for (int ultime : {1, 5, 16, 20, 100}) {
+		for (Fusione modo : {Fusione::MEDIA, Fusione::MEDIANA}) {
+			ldFuso.get_scan_fusa(ultime, modo, fusa);
+			for (int i = 0; i < 181; i++) {
+				vector<double> valori;
+				for (int k = 40 - min(ultime, 32); k < 40; k++)
+					if ((k * 7 + i * 3) % 11 != 0)
+						valori.push_back((k * 7 + i * 3) % 11);
+				sort(valori.begin(), valori.end());
+				double atteso = 0;
+				if (!valori.empty() && modo == Fusione::MEDIA) {
+					for (double x : valori)
+						atteso += x;
+					atteso /= valori.size();
+				}
+				else if (!valori.empty())
+					atteso = (valori[(valori.size() - 1) / 2] + valori[valori.size() / 2]) / 2;
+				if (fabs(fusa[i] - atteso) > 1e-9 || fabs(ldFuso.get_distance_fusa(i, ultime, modo) - atteso) > 1e-9)
+					fusioneOk = false;
+			}
+		}
+	}
+	try {
+		ldFuso.get_scan_fusa(0, Fusione::MEDIA, fusa);
+		fusioneOk = false;
+	} catch (LidarDriver::DimensionOutputSbagliataError) {
+		cout << "<<errore voluto - fusione di 0 scansioni>>" << endl;
+	}
+	try {
+		ldInterpolato.get_distance_interpolata(NAN);
+		fusioneOk = false;
+	} catch (LidarDriver::AngoloForaDaiRangeError) {
+		cout << "<<errore voluto - angolo NaN nell'interpolazione>>" << endl;
+	}
+	try {
+		ldFuso.get_distance_fusa(NAN, 5, Fusione::MEDIANA);
+		fusioneOk = false;
+	} catch (LidarDriver::AngoloForaDaiRangeError) {
+		cout << "<<errore voluto - angolo NaN nella fusione>>" << endl;
+	}
+	if (fusioneOk)
+		cout << "interpolazione e fusione -> corrette" << endl;
+	else
+		cout << "interpolazione e fusione -> sbagliate" << endl;
+
+	// filtri: maschera e limiti misura per misura, rimozione dei picchi isolati e smoothing con
+	// finestra (confrontato con mediana e media calcolate a mano sulle misure non nulle della finestra)
+	LidarDriver ldFiltrato(1);
+	ldFiltrato.set_filtri({true, 0.5, 10});
+	vector<double> grezza(181, 3);
+	grezza[0] = NAN;
+	grezza[1] = -1;
+	grezza[2] = 0;
+	grezza[3] = 0.2;
+	grezza[4] = 20;
+	ldFiltrato.new_scan(grezza);
+	vector<double> filtrata = ldFiltrato.get_last();
+	bool filtriOk = filtrata[0] == 0 && filtrata[1] == 0 && filtrata[2] == 0 && filtrata[3] == 0.5 && filtrata[4] == 10 && filtrata[5] == 3;
+
+	ldFiltrato.set_filtri({false, 0, 0, 2});
+	grezza = vector<double>(181, 3);
+	grezza[50] = 9;
+	grezza[60] = 0.5;
+	grezza[70] = 9;
+	grezza[71] = 0;	// vicino mancante: 70 non è un picco
+	ldFiltrato.new_scan(grezza);
+	filtrata = ldFiltrato.get_last();
+	filtriOk = filtriOk && filtrata[50] == 3 && filtrata[60] == 3 && filtrata[70] == 9 && filtrata[71] == 0;
+
+	for (Fusione modo : {Fusione::MEDIANA, Fusione::MEDIA}) {
+		ldFiltrato.set_filtri({false, 0, 0, 0, 5, modo});
+		for (int i = 0; i < 181; i++)
+			grezza[i] = (i * 37 % 13 == 0) ? 0 : i * 37 % 13;
+		ldFiltrato.new_scan(grezza);
+		filtrata = ldFiltrato.get_last();
+		for (int i = 0; i < 181; i++) {
+			vector<double> finestra;
+			for (int d = -2; d <= 2; d++)
+				if (i + d >= 0 && i + d < 181 && grezza[i + d] != 0)
+					finestra.push_back(grezza[i + d]);
+			sort(finestra.begin(), finestra.end());
+			double atteso = (modo == Fusione::MEDIANA) ? (finestra[(finestra.size() - 1) / 2] + finestra[finestra.size() / 2]) / 2 : 0;
+			if (modo == Fusione::MEDIA) {
+				for (double x : finestra)
+					atteso += x;
+				atteso /= finestra.size();
+			}
+			if (grezza[i] == 0)
+				atteso = 0;
+			if (fabs(filtrata[i] - atteso) > 1e-9)
+				filtriOk = false;
+		}
+	}
+	ldFiltrato.set_filtri({});
+	ldFiltrato.new_scan(grezza);
+	filtriOk = filtriOk && ldFiltrato.get_last() == grezza && ldFiltrato.get_filtri().finestra == 1;
+	{
+		// dopo l'assegnamento da un driver con scansioni più corte lo spazio di lavoro dei filtri
+		// non deve avere ai bordi le misure delle scansioni precedenti: stesso risultato di un
+		// driver nuovo
+		LidarDriver ldLargo(0.1);
+		ldLargo.set_filtri({false, 0, 0, 0, 5});
+		ldLargo.new_scan(vector<double>(1801, 7));
+		LidarDriver ldStretto(1);
+		ldStretto.set_filtri({false, 0, 0, 0, 5});
+		ldLargo = ldStretto;
+		ldLargo.new_scan(grezza);
+		ldStretto.new_scan(grezza);
+		filtriOk = filtriOk && ldLargo.get_last() == ldStretto.get_last();
+		LidarDriver ldSpostato(0.1);
+		ldSpostato.set_filtri({false, 0, 0, 0, 5});
+		ldSpostato.new_scan(vector<double>(1801, 7));
+		ldSpostato = std::move(ldStretto);
+		ldSpostato.new_scan(grezza);
+		filtriOk = filtriOk && ldSpostato.get_last() == ldLargo.get_last();
+
+		// le scansioni lette con read_scan non vengono filtrate, qualunque sia il formato nel file
+		stringstream doppie, singole;
+		LidarDriver ldDoppio(1), ldSingolo(1, FormatoCampioni::FLOAT);
+		ldDoppio.new_scan(grezza);
+		ldSingolo.new_scan(grezza);
+		ldDoppio.write_scan(doppie);
+		ldSingolo.write_scan(singole);
+		LidarDriver ldLetto(1);
+		ldLetto.set_filtri({false, 0, 0, 0, 5});
+		ldLetto.read_scan(doppie);
+		filtriOk = filtriOk && ldLetto.get_last() == grezza;
+		ldLetto.read_scan(singole);
+		filtriOk = filtriOk && ldLetto.get_last() == grezza;
+	}
+	try {
+		ldFiltrato.set_filtri({false, 0, 0, 0, 4});
+		filtriOk = false;
+	} catch (LidarDriver::FiltroSbagliatoError) {
+		cout << "<<errore voluto - finestra dei filtri pari>>" << endl;
+	}
+	if (filtriOk)
+		cout << "filtri sulle nuove scansioni -> corretti" << endl;
+	else
+		cout << "filtri sulle nuove scansioni -> sbagliati" << endl;
+
+	// punti cartesiani: confronto con std::cos e std::sin per ogni misura, per l'ultima scansione e
+	// per una scansione più vecchia del buffer, anche con le misure compatte (FLOAT) e dopo una move
+	bool puntiOk = true;
+	for (FormatoCampioni f : {FormatoCampioni::DOUBLE, FormatoCampioni::FLOAT}) {
+		LidarDriver ldPunti(0.5, 4, f);
+		vector<double> misure(361);
+		for (int k = 1; k <= 3; k++) {
+			for (int i = 0; i < 361; i++)
+				misure[i] = (i % 7) * k;
+			ldPunti.new_scan(misure);
+		}
+		LidarDriver ldSpostato(std::move(ldPunti));
+		vector<double> x(361), y(361);
+		for (int k : {0, 2}) {
+			ldSpostato.to_points(k, x, y);
+			for (int i = 0; i < 361; i++) {
+				double r = (i % 7) * (k + 1), angolo = i * 0.5 * M_PI / 180;
+				if (abs(x[i] - r * cos(angolo)) > 1e-9 || abs(y[i] - r * sin(angolo)) > 1e-9)
+					puntiOk = false;
+			}
+		}
+		ldSpostato.to_points(x, y);
+		puntiOk = puntiOk && abs(x[1] - 3 * cos(0.5 * M_PI / 180)) < 1e-9 && x[0] == 0 && y[0] == 0;
+
+		// l'oggetto smembrato ricalcola le tabelle e funziona ancora
+		ldPunti.new_scan(misure);
+		ldPunti.to_points(x, y);
+		puntiOk = puntiOk && abs(y[180] - 5 * 3) < 1e-9;
+	}
+	try {
+		vector<double> corto(10), giusto(1801);
+		LidarDriver ldPunti(0.1);
+		ldPunti.new_scan(giusto);
+		ldPunti.to_points(corto, giusto);
+		puntiOk = false;
+	} catch (LidarDriver::DimensionOutputSbagliataError) {
+		cout << "<<errore voluto - span dei punti troppo piccolo>>" << endl;
+	}
+	if (puntiOk)
+		cout << "conversione in punti cartesiani -> corretta" << endl;
+	else
+		cout << "conversione in punti cartesiani -> sbagliata" << endl;
+
+	// statistiche: confronto con minimo, massimo, media e conteggio calcolati a mano sulle misure
+	// valide (positive e finite) di tutta la scansione e di ogni settore, per scansioni inserite prima
+	// e dopo set_statistiche, dopo set_dim_buffer e dopo una move
+	bool statisticheOk = true;
+	auto controlla = [&](const vector<double> &v, int da, int a, const StatisticheScansione &st) {
+		double minimo = 0, angolo = 0, massimo = 0, somma = 0;
+		int valide = 0;
+		for (int i = da; i < a; i++) {
+			if (!(v[i] > 0 && v[i] < INFINITY))
+				continue;
+			if (valide == 0 || v[i] < minimo) {
+				minimo = v[i];
+				angolo = i * 0.5;
+			}
+			massimo = max(massimo, v[i]);
+			somma += v[i];
+			valide++;
+		}
+		double media = (valide == 0) ? 0 : somma / valide;
+		if (st.minimo != minimo || st.angoloMinimo != angolo || st.massimo != massimo || st.valide != valide || abs(st.media - media) > 1e-9)
+			statisticheOk = false;
+	};
+	for (FormatoCampioni f : {FormatoCampioni::DOUBLE, FormatoCampioni::FLOAT}) {
+		LidarDriver ldStat(0.5, 3, f);
+		vector<vector<double>> inserite;
+		for (int k = 0; k < 5; k++) {
+			vector<double> v(361);
+			for (int i = 0; i < 361; i++)
+				v[i] = ((i * 7 + k * 13) % 23) * 0.25;
+			v[10 * k] = NAN;
+			v[10 * k + 1] = -2;
+			v[10 * k + 2] = INFINITY;
+			if (k == 2)
+				fill(v.begin() + 60, v.begin() + 120, 0);	// un settore senza misure valide
+			if (k == 1)
+				ldStat.set_statistiche(true, 30);
+			ldStat.new_scan(v);
+			inserite.push_back(v);
+		}
+		if (ldStat.larghezza_settore() != 30 || ldStat.sector_stats(0).size() != 7)
+			statisticheOk = false;
+		for (int k = 0; k < 3; k++) {
+			const vector<double> &v = inserite[2 + k];
+			controlla(v, 0, 361, ldStat.scan_stats(k));
+			for (int s = 0; s < 7; s++)
+				controlla(v, s * 60, min(s * 60 + 60, 361), ldStat.sector_stats(k)[s]);
+		}
+		pair<double, double> ostacolo = ldStat.closest_obstacle();
+		statisticheOk = statisticheOk && ostacolo.first == ldStat.scan_stats().minimo && ostacolo.second == ldStat.scan_stats().angoloMinimo;
+
+		ldStat.set_dim_buffer(2);
+		controlla(inserite[3], 0, 361, ldStat.scan_stats(0));
+		controlla(inserite[4], 120, 180, ldStat.sector_stats(1)[2]);
+		LidarDriver ldSpostato(std::move(ldStat));
+		controlla(inserite[4], 0, 361, ldSpostato.scan_stats());
+		ldStat.new_scan(inserite[2]);
+		controlla(inserite[2], 60, 120, ldStat.sector_stats(0)[1]);
+
+		// senza settori c'è un solo settore con tutta la scansione
+		ldSpostato.set_statistiche(true);
+		statisticheOk = statisticheOk && ldSpostato.sector_stats(1).size() == 1 && ldSpostato.sector_stats(1)[0].media == ldSpostato.scan_stats(1).media;
+	}
+	try {
+		LidarDriver ldStat(0.5);
+		ldStat.new_scan(vector<double>(361, 1));
+		ldStat.scan_stats();
+		statisticheOk = false;
+	} catch (LidarDriver::StatisticheSpenteError) {
+		cout << "<<errore voluto - statistiche non attive>>" << endl;
+	}
+	if (statisticheOk)
+		cout << "statistiche delle scansioni -> corrette" << endl;
+	else
+		cout << "statistiche delle scansioni -> sbagliate" << endl;
+
+	// istantanee (copy-on-write): la copia condivide tutti gli slot con l'originale, e quando uno dei
+	// due inserisce una scansione l'altro continua a vedere le sue (anche con le viste e dopo
+	// set_dim_buffer e una move); poi un thread "diagnostico" prende istantanee sotto lo stesso mutex
+	// del thread che inserisce e le legge fuori dal mutex, e ogni scansione deve essere intera
+	bool istantaneeOk = true;
+	{
+		LidarDriver originale(1, 4);
+		for (int k = 1; k <= 3; k++)
+			originale.new_scan(vector<double>(181, k));
+		LidarDriver istantanea = originale;
+		if (originale.memoria_condivisa() != originale.memoria_buffer() || istantanea.memoria_condivisa() != istantanea.memoria_buffer())
+			istantaneeOk = false;
+		VistaScansione vistaIstantanea = istantanea.get_last_view();
+		originale.new_scan(vector<double>(181, 4));
+		originale.new_scan(vector<double>(181, 5));
+		if (istantanea.size() != 3 || istantanea.get_last()[0] != 3 || istantanea.get_view(0)[180] != 1 || !vistaIstantanea.valida() || vistaIstantanea[90] != 3)
+			istantaneeOk = false;
+		if (originale.size() != 4 || originale.get_last()[0] != 5 || originale.get_view(0)[0] != 2)
+			istantaneeOk = false;
+		if (originale.memoria_condivisa() != 2 * 181 * sizeof(double))	// slot delle scansioni 2 e 3
+			istantaneeOk = false;
+
+		istantanea.new_scan(vector<double>(181, 6));
+		originale.set_dim_buffer(2);
+		if (istantanea.get_view(2)[0] != 3 || istantanea.get_last()[0] != 6 || originale.get_view(0)[0] != 4)
+			istantaneeOk = false;
+		LidarDriver spostata(std::move(istantanea));
+		istantanea.new_scan(vector<double>(181, 7));
+		if (spostata.get_last()[0] != 6 || istantanea.size() != 1 || istantanea.get_last()[0] != 7)
+			istantaneeOk = false;
+
+		LidarDriver condiviso(0.5);
+		mutex mutexCondiviso;
+		atomic<bool> fine{false};
+		thread diagnostica([&]() {
+			while (!fine) {
+				unique_lock<mutex> blocco(mutexCondiviso);
+				LidarDriver copia = condiviso;
+				blocco.unlock();
+				for (int k = 0; k < copia.size(); k++) {
+					VistaScansione v = copia.get_view(k);
+					for (int i = 0; i < v.size(); i++)
+						if (v[i] != v[0])
+							istantaneeOk = false;
+				}
+			}
+		});
+		for (int k = 0; k < 20000; k++) {
+			lock_guard<mutex> blocco(mutexCondiviso);
+			condiviso.new_scan(vector<double>(361, k));
+		}
+		fine = true;
+		diagnostica.join();
+	}
+	if (istantaneeOk)
+		cout << "istantanee copy-on-write -> corrette" << endl;
+	else
+		cout << "istantanee copy-on-write -> sbagliate" << endl;
+
+	// elaborazione parallela: la somma di ogni scansione di un buffer da 64 (che ha già girato) con
+	// transform_scans e for_each_scan deve coincidere con quella fatta a mano su get_view; un gruppo di
+	// 3 thread deve chiamare f una volta sola per ogni indice, anche con lavori annidati, e rilanciare
+	// l'eccezione di f
+	bool paralleloOk = true;
+	{
+		LidarDriver profondo(1, 64);
+		for (int k = 0; k < 100; k++) {
+			vector<double> v(181);
+			for (int i = 0; i < 181; i++)
+				v[i] = k + i * 0.5;
+			profondo.new_scan(v);
+		}
+		auto somma = [](int, const VistaScansione &v) {
+			double s = 0;
+			for (int i = 0; i < v.size(); i++)
+				s += v[i];
+			return s;
+		};
+		vector<double> somme = profondo.transform_scans(somma);
+		vector<double> somme2(profondo.size());
+		profondo.for_each_scan([&](int k, const VistaScansione &v) { somme2[k] = somma(k, v); }, 1);
+		if ((int)somme.size() != profondo.size())
+			paralleloOk = false;
+		for (int k = 0; k < profondo.size(); k++)
+			if (somme[k] != somma(k, profondo.get_view(k)) || somme2[k] != somme[k])
+				paralleloOk = false;
+
+		GruppoThread gruppo(3);
+		vector<atomic<int>> chiamate(1000);
+		gruppo.per_ogni(1000, [&](int i) {
+			chiamate[i]++;
+			if (i % 100 == 0)
+				gruppo.per_ogni(10, [&](int j) { chiamate[i + 1 + j]--; });
+		}, 0, 7);
+		for (int i = 0; i < 1000; i++)
+			if (chiamate[i] != ((i % 100 >= 1 && i % 100 <= 10) ? 0 : 1))
+				paralleloOk = false;
+		try {
+			gruppo.per_ogni(1000, [](int i) { if (i == 500) throw LidarDriver::NoGheSonVettoriError(); });
+			paralleloOk = false;
+		} catch (LidarDriver::NoGheSonVettoriError) {
+			cout << "<<errore voluto - eccezione lanciata da un thread del gruppo>>" << endl;
+		}
+	}
+	if (paralleloOk)
+		cout << "elaborazione parallela delle scansioni -> corretta" << endl;
+	else
+		cout << "elaborazione parallela delle scansioni -> sbagliata" << endl;
+
+	// flotta di lidar: 5 sensori divisi tra 2 lavoratori; le scansioni passate a new_scan devono
+	// arrivare nel driver giusto, le ultime scansioni e l'ostacolo più vicino devono essere quelli di
+	// tutti i sensori (anche con le statistiche attive su uno solo); poi 4 thread produttori inseriscono
+	// insieme mentre il main interroga la flotta, e alla fine inserite + perse deve fare il totale
+	bool flottaOk = true;
+	{
+		FlottaLidar flotta(5, 1, 2);
+		if (flotta.numero_lavoratori() != 2 || flotta.lavoratore_di(3) != 1 || flotta.get_dim_scansioni() != 181
+		    || flotta.con_driver(0, [](LidarDriver &ld) { return ld.get_dim_scansioni(); }) != 181)
+			flottaOk = false;
+		for (int s = 0; s < 4; s++)
+			for (int k = 1; k <= 3; k++) {
+				vector<double> v(181, 10 * s + k);
+				if (s == 2 && k == 3)
+					v[90] = 0.5;
+				flotta.new_scan(s, v);
+			}
+		flotta.attendi();
+		for (int s = 0; s < 5; s++)
+			if (flotta.con_driver(s, [](LidarDriver &ld) { return ld.size(); }) != (s < 4 ? 3 : 0))
+				flottaOk = false;
+
+		vector<double> ultime(5 * 181);
+		vector<long long> tempi(5);
+		flotta.ultime_scansioni(ultime, tempi);
+		for (int s = 0; s < 5; s++)
+			for (int i = 0; i < 181; i++) {
+				double atteso = (s == 4) ? 0 : (s == 2 && i == 90) ? 0.5 : 10 * s + 3;
+				if (ultime[s * 181 + i] != atteso)
+					flottaOk = false;
+			}
+		if (tempi[4] != -1 || tempi[0] < 0)
+			flottaOk = false;
+
+		OstacoloFlotta o = flotta.closest_obstacle();
+		if (o.sensore != 2 || o.distanza != 0.5 || o.angolo != 90)
+			flottaOk = false;
+		flotta.con_driver(1, [](LidarDriver &ld) { ld.set_statistiche(true); });
+		vector<double> vicina(181, 20);
+		vicina[45] = 0.25;
+		flotta.new_scan(1, vicina);
+		o = flotta.closest_obstacle();
+		if (o.sensore != 1 || o.distanza != 0.25 || o.angolo != 45)
+			flottaOk = false;
+
+		try {
+			flotta.new_scan(5, vicina);
+			flottaOk = false;
+		} catch (FlottaLidar::SensoreForaDaiRangeError) {
+			cout << "<<errore voluto - sensore della flotta che non esiste>>" << endl;
+		}
+		try {
+			flotta.ultime_scansioni(span<double>(ultime).first(181), tempi);
+			flottaOk = false;
+		} catch (FlottaLidar::DimensionOutputSbagliataError) {
+			cout << "<<errore voluto - spazio insufficiente per le ultime scansioni>>" << endl;
+		}
+	}
+	{
+		FlottaLidar flotta(4, 0.5, 4);
+		const int NF = 2000;
+		vector<thread> produttori;
+		for (int s = 0; s < 4; s++)
+			produttori.emplace_back([&flotta, s]() {
+				vector<double> v(361);
+				for (int k = 1; k <= NF; k++) {
+					fill(v.begin(), v.end(), 1000 * s + k);
+					flotta.new_scan(s, v);
+				}
+			});
+		vector<double> ultime(4 * 361);
+		vector<long long> tempi(4);
+		for (int q = 0; q < 200; q++) {
+			OstacoloFlotta o = flotta.closest_obstacle();
+			flotta.ultime_scansioni(ultime, tempi);
+			for (int s = 0; s < 4; s++)
+				if (ultime[s * 361 + 360] != ultime[s * 361])	// scansione "mescolata"
+					flottaOk = false;
+			if (o.sensore > 0)	// il sensore 0 ha sempre le misure più piccole
+				flottaOk = false;
+		}
+		for (thread &t : produttori)
+			t.join();
+		flotta.attendi();
+		for (int s = 0; s < 4; s++) {
+			unsigned long long inserite = flotta.con_driver(s, [](LidarDriver &ld) { return ld.get_sequenza(ld.size() - 1) + 1; });	// le sequenze partono da 0
+			double ultima = flotta.con_driver(s, [](LidarDriver &ld) { return ld.get_last_view()[0]; });
+			if (inserite + flotta.scansioni_perse(s) != NF || ultima != 1000 * s + NF)
+				flottaOk = false;
+		}
+	}
+	if (flottaOk)
+		cout << "flotta di lidar (5 sensori, 2 lavoratori; 4 produttori concorrenti) -> corretta" << endl;
+	else
+		cout << "flotta di lidar -> sbagliata" << endl;
+
+	// riserva di slot: due driver prendono gli slot da una RiservaSlot comune; dopo il primo giro,
+	// svuotare e riempire i buffer, prendere istantanee (che fanno copiare gli slot sovrascritti) e
+	// spostare i driver avanti e indietro non deve più chiedere memoria alla risorsa a monte;
+	// shrink_to_fit deve restituire alla riserva gli slot vuoti (con i loro blocchi di controllo) e
+	// set_risorsa non deve perdere le scansioni già nel buffer; le viste sugli slot liberati o
+	// spostati da queste due funzioni devono diventare non valide
+	bool riservaOk = true;
+	{
+		RiservaSlot riserva;
+		LidarDriver a(1, 4), b(1, 4);
+		a.set_risorsa(&riserva, 4);
+		b.set_risorsa(&riserva, 4);
+		size_t dopoRiscaldamento = 0;
+		for (int giro = 0; giro < 100; giro++) {
+			for (int k = 1; k <= 6; k++) {
+				a.new_scan(vector<double>(181, giro + k));
+				b.new_scan(vector<double>(181, -k));
+			}
+			{
+				LidarDriver istantanea = a;
+				a.new_scan(vector<double>(181, 0.5));
+				a.new_scan(vector<double>(181, 0.5));
+				if (istantanea.get_last()[0] != giro + 6 || a.get_last()[0] != 0.5)
+					riservaOk = false;
+			}
+			LidarDriver spostato(std::move(b));
+			b = std::move(spostato);
+			if (b.size() != 4 || b.get_last()[180] != -6)
+				riservaOk = false;
+			a.clear_buffer();
+			b.clear_buffer();
+			if (giro == 0)
+				dopoRiscaldamento = riserva.allocazioni_a_monte();
+		}
+		if (riserva.allocazioni_a_monte() != dopoRiscaldamento)
+			riservaOk = false;
+
+		int liberi = riserva.blocchi_liberi();
+		a.new_scan(vector<double>(181, 7));
+		a.new_scan(vector<double>(181, 1));
+		VistaScansione tolta = a.get_scan_view();	// lo slot si svuota ma la vista resta valida fino a shrink_to_fit
+		bool vistaPrima = tolta.valida() && tolta[0] == 7;
+		a.shrink_to_fit();
+		if (riserva.blocchi_liberi() != liberi + 2 * 3 || !vistaPrima || tolta.valida())	// 3 slot vuoti, ognuno con il suo blocco di controllo
+			riservaOk = false;
+		for (int k = 2; k <= 4; k++)
+			a.new_scan(vector<double>(181, k));
+		if (riserva.blocchi_liberi() != liberi || a.get_view(0)[0] != 1 || a.get_last()[0] != 4)
+			riservaOk = false;
+
+		LidarDriver c(0.5, 3, FormatoCampioni::FLOAT);
+		for (int k = 1; k <= 5; k++)
+			c.new_scan(vector<double>(361, k));
+		liberi = riserva.blocchi_liberi();
+		size_t aMonte = riserva.allocazioni_a_monte();
+		VistaScansione spostata = c.get_last_view();	// set_risorsa sposta la scansione in un altro slot
+		c.set_risorsa(&riserva);
+		if (c.size() != 3 || c.get_view(0)[360] != 3 || c.get_last()[0] != 5 || spostata.valida())
+			riservaOk = false;
+		c.set_risorsa(nullptr);
+		// tornando all'heap, tutti i blocchi presi da c devono tornare liberi nella riserva
+		if (c.get_last()[100] != 5 || riserva.blocchi_liberi() - liberi != static_cast<int>(riserva.allocazioni_a_monte() - aMonte))
+			riservaOk = false;
+	}
+	if (riservaOk)
+		cout << "riserva di slot condivisa (nessuna allocazione a regime) -> corretta" << endl;
+	else
+		cout << "riserva di slot condivisa -> sbagliata" << endl;
+
+	// metriche: l'istogramma e il formato di Prometheus si provano sempre, con durate registrate a mano
+	// e un "raccoglitore" che legge le righe del testo; i contatori del driver (inserite, sovrascritte,
+	// completate, troncate), gli errori e le chiamate cronometrate devono essere quelli attesi se il
+	// programma è compilato con LIDAR_METRICHE (make OPZIONI=-DLIDAR_METRICHE), altrimenti tutti a zero
+	bool metricheOk = true;
+	{
+		auto raccogli = [](const string &testo) {
+			map<string, double> valori;
+			istringstream righe(testo);
+			string riga;
+			while (getline(righe, riga))
+				if (!riga.empty() && riga[0] != '#')
+					valori[riga.substr(0, riga.rfind(' '))] = stod(riga.substr(riga.rfind(' ') + 1));
+			return valori;
+		};
+
+		MetricheLidar durate;
+		for (uint64_t ns : {10ULL, 16ULL, 17ULL, 1000ULL, 1000000000000ULL})
+			durate.registra_durata(OperazioneLidar::GET_LAST, ns);
+		ostringstream testoDurate;
+		scrivi_prometheus(testoDurate, durate.istantanea(), "sensore=\"7\"");
+		map<string, double> d = raccogli(testoDurate.str());
+		if (d["lidar_durata_ns_bucket{sensore=\"7\",operazione=\"get_last\",le=\"16\"}"] != 2 ||
+		    d["lidar_durata_ns_bucket{sensore=\"7\",operazione=\"get_last\",le=\"32\"}"] != 3 ||
+		    d["lidar_durata_ns_bucket{sensore=\"7\",operazione=\"get_last\",le=\"512\"}"] != 3 ||
+		    d["lidar_durata_ns_bucket{sensore=\"7\",operazione=\"get_last\",le=\"1024\"}"] != 4 ||
+		    d["lidar_durata_ns_bucket{sensore=\"7\",operazione=\"get_last\",le=\"+Inf\"}"] != 5 ||
+		    d["lidar_durata_ns_count{sensore=\"7\",operazione=\"get_last\"}"] != 5 ||
+		    d["lidar_durata_ns_sum{sensore=\"7\",operazione=\"get_last\"}"] != 1000000001043.0 ||
+		    d.count("lidar_scansioni_inserite_total{sensore=\"7\"}") != 1)
+			metricheOk = false;
+		durate.azzera();
+		if (durate.istantanea()[OperazioneLidar::GET_LAST].chiamate != 0)
+			metricheOk = false;
+
+		MetricheLidar metriche;
+		LidarDriver misurato(1, 4);
+		misurato.set_metriche(&metriche);
+		for (int k = 0; k < 6; k++)
+			misurato.new_scan(vector<double>(181, 1));	// le ultime 2 sovrascrivono
+		misurato.new_scan(vector<double>(100, 1));		// completata
+		misurato.new_scan(vector<double>(200, 1));		// troncata
+		list<double> corta(50, 1);
+		misurato.new_scan(corta.begin(), corta.end());	// completata
+		misurato.new_scans(vector<double>(3 * 181, 1), 181);	// 3 sovrascritte, senza durata
+		vector<double> letta;
+		misurato.get_scan();
+		misurato.get_scan();
+		misurato.get_scan(letta);
+		misurato.get_scan(letta);
+		try {
+			misurato.get_scan();
+			metricheOk = false;
+		} catch (LidarDriver::NoGheSonVettoriError) {}
+		try {
+			misurato.get_scan_view();
+			metricheOk = false;
+		} catch (LidarDriver::NoGheSonVettoriError) {}
+		try {
+			misurato.get_last();
+			metricheOk = false;
+		} catch (LidarDriver::NoGheSonVettoriError) {}
+		try {
+			misurato.get_distance(10);
+			metricheOk = false;
+		} catch (LidarDriver::NoGheSonVettoriError) {}
+		misurato.new_scan(vector<double>(181, 1));
+		try {
+			misurato.get_distance(200);
+			metricheOk = false;
+		} catch (LidarDriver::AngoloForaDaiRangeError) {}
+		misurato.get_distance(90);
+		LidarDriver copiaMisurata = misurato;	// la copia aggiorna le stesse metriche
+		copiaMisurata.new_scan(vector<double>(181, 1));
+
+		IstantaneaMetriche m = metriche.istantanea();
+#ifdef LIDAR_METRICHE
+		if (m[ContatoreLidar::INSERITE] != 14 || m[ContatoreLidar::SOVRASCRITTE] != 8 ||
+		    m[ContatoreLidar::COMPLETATE] != 2 || m[ContatoreLidar::TRONCATE] != 1)
+			metricheOk = false;
+		if (m[OperazioneLidar::NEW_SCAN].chiamate != 11 || m[OperazioneLidar::NEW_SCAN].errori != 0 ||
+		    m[OperazioneLidar::GET_SCAN].chiamate != 5 || m[OperazioneLidar::GET_SCAN].errori != 2 ||
+		    m[OperazioneLidar::GET_LAST].chiamate != 1 || m[OperazioneLidar::GET_LAST].errori != 1 ||
+		    m[OperazioneLidar::GET_DISTANCE].chiamate != 3 || m[OperazioneLidar::GET_DISTANCE].errori != 2)
+			metricheOk = false;
+		uint64_t nelleSecchie = 0;
+		for (uint64_t s : m[OperazioneLidar::NEW_SCAN].secchi)
+			nelleSecchie += s;
+		if (nelleSecchie != 11 || m[OperazioneLidar::NEW_SCAN].sommaNs == 0)
+			metricheOk = false;
+		const bool attese = true;
+#else
+		IstantaneaMetriche vuota;
+		for (int c = 0; c < NUMERO_CONTATORI; c++)
+			if (m.contatori[c] != vuota.contatori[c])
+				metricheOk = false;
+		for (int o = 0; o < NUMERO_OPERAZIONI; o++)
+			if (m.operazioni[o].chiamate != 0 || m.operazioni[o].errori != 0)
+				metricheOk = false;
+		const bool attese = false;
+#endif
+		if (copiaMisurata.get_metriche() != &metriche)
+			metricheOk = false;
+
+		// due sensori nello stesso testo: le righe # TYPE una volta sola, le serie con le etichette
+		SerieMetriche serie[2] = {{"sensore=\"0\"", m}, {"sensore=\"1\"", IstantaneaMetriche{}}};
+		ostringstream testo;
+		scrivi_prometheus(testo, serie);
+		map<string, double> v = raccogli(testo.str());
+		size_t tipi = 0;
+		for (size_t p = testo.str().find("# TYPE lidar_durata_ns "); p != string::npos; p = testo.str().find("# TYPE lidar_durata_ns ", p + 1))
+			tipi++;
+		if (tipi != 1 || v["lidar_scansioni_inserite_total{sensore=\"0\"}"] != (attese ? 14 : 0) ||
+		    v["lidar_errori_total{sensore=\"0\",operazione=\"get_distance\"}"] != (attese ? 2 : 0) ||
+		    v["lidar_durata_ns_count{sensore=\"0\",operazione=\"new_scan\"}"] != (attese ? 11 : 0) ||
+		    v["lidar_durata_ns_bucket{sensore=\"0\",operazione=\"new_scan\",le=\"+Inf\"}"] != (attese ? 11 : 0) ||
+		    v.count("lidar_scansioni_sovrascritte_total{sensore=\"1\"}") != 1)
+			metricheOk = false;
+	}
+	if (metricheOk)
+		cout << "metriche delle operazioni (" <<
+#ifdef LIDAR_METRICHE
+			"attive"
+#else
+			"tolte in compilazione"
+#endif
+			<< ") -> corrette" << endl;
+	else
+		cout << "metriche delle operazioni -> sbagliate" << endl;
+
+	// ora verifico le funzioni try_: stessi risultati delle funzioni che lanciano, ma con l'errore
+	// nell'esito invece dell'eccezione
+	bool tryOk = true;
+	{
+		LidarDriver ldt(1, 4);
+		EsitoLidar<double> d = ldt.try_get_distance(10);
+		if (d || d.error() != ErroreLidar::BUFFER_VUOTO || d.value_or(-1) != -1)
+			tryOk = false;
+		if (ldt.try_get_scan() || ldt.try_get_last() || ldt.try_get_scan_view() || ldt.try_get_last_view())
+			tryOk = false;
+		vector<double> letta(3, 7);
+		if (ldt.try_get_scan(letta) || letta.size() != 3)	// con il buffer vuoto non tocca il vettore
+			tryOk = false;
+
+		vector<double> s1(181), s2(181);
+		for (int i = 0; i < 181; i++) {
+			s1[i] = i;
+			s2[i] = 2 * i;
+		}
+		ldt.new_scan(s1);
+		ldt.new_scan(s2);
+		d = ldt.try_get_distance(90);
+		if (!d || *d != ldt.get_distance(90) || *d != 180)
+			tryOk = false;
+		if (ldt.try_get_distance(200).error() != ErroreLidar::ANGOLO_FORA_DAI_RANGE ||
+		    ldt.try_get_distance(-1).error() != ErroreLidar::ANGOLO_FORA_DAI_RANGE ||
+		    ldt.try_get_distance(NAN).error() != ErroreLidar::ANGOLO_FORA_DAI_RANGE)
+			tryOk = false;
+		try {
+			ldt.get_distance(NAN);	// anche get_distance, scritta sopra try_get_distance, rifiuta NaN
+			tryOk = false;
+		} catch (LidarDriver::AngoloForaDaiRangeError) {
+			cout << "<<errore voluto - angolo NaN>>" << endl;
+		}
+
+		EsitoLidar<VistaScansione> ultima = ldt.try_get_last_view();
+		if (!ultima || ultima->size() != 181 || (*ultima)[10] != 20 || ldt.try_get_last().value() != s2)
+			tryOk = false;
+		EsitoLidar<vector<double>> prima = ldt.try_get_scan();
+		if (!prima || *prima != s1 || ldt.size() != 1)
+			tryOk = false;
+		if (!ldt.try_get_scan(letta) || letta != s2 || ldt.size() != 0 || ldt.try_get_scan(letta))
+			tryOk = false;
+
+		LidarDriverFisso<1.0> ldft;
+		if (ldft.try_get_distance(0).error() != ErroreLidar::BUFFER_VUOTO || ldft.try_get_last_view())
+			tryOk = false;
+		ldft.new_scan(s2);
+		if (ldft.try_get_distance(45).value_or(-1) != 90 || ldft.try_get_distance(NAN))
+			tryOk = false;
+
+		LidarDriverConcorrente ldct(1);
+		if (ldct.try_get_scan(letta))
+			tryOk = false;
+		ldct.new_scan(s1);
+		if (!ldct.try_get_scan(letta) || letta != s1 || ldct.try_get_scan(letta))
+			tryOk = false;
+	}
+	if (tryOk)
+		cout << "funzioni try_ senza eccezioni -> corrette" << endl;
+	else
+		cout << "funzioni try_ senza eccezioni -> sbagliate" << endl;
+
+	// ora verifico l'attesa delle scansioni del LidarDriverConcorrente: wait_scan con un tempo massimo,
+	// wait_scans a gruppi, subscribe (un thread svegliato ogni 4 scansioni) e una coroutine che viene
+	// ripresa dal produttore ogni 3 scansioni
+	bool attesaOk = true;
+	{
+		LidarDriverConcorrente lda(1);
+		vector<double> letta;
+		auto inizio = chrono::steady_clock::now();
+		if (lda.wait_scan(letta, chrono::milliseconds(20)) || chrono::steady_clock::now() - inizio < chrono::milliseconds(20))
+			attesaOk = false;
+
+		thread ritardato([&]() {
+			this_thread::sleep_for(chrono::milliseconds(20));
+			for (int k = 1; k <= 4; k++)
+				lda.new_scan(vector<double>(181, k));
+		});
+		if (!lda.wait_scan(letta, chrono::seconds(10)) || letta[0] != 1)
+			attesaOk = false;
+		if (lda.wait_scans(3, chrono::seconds(10)) != 3)
+			attesaOk = false;
+		ritardato.join();
+		for (int k = 2; k <= 4; k++)
+			if (!lda.try_get_scan(letta) || letta[0] != k)
+				attesaOk = false;
+
+		atomic<int> chiamate{0}, somma{0};
+		{
+			jthread abbonato = lda.subscribe([&](span<const double> s) {
+				somma += static_cast<int>(s[0]);
+				chiamate++;
+			}, 4, chrono::milliseconds(5));
+			for (int k = 1; k <= 10; k++)
+				lda.new_scan(vector<double>(181, k));
+			for (int i = 0; i < 10000 && chiamate < 10; i++)
+				this_thread::sleep_for(chrono::milliseconds(1));
+		}	// il distruttore di abbonato ferma il thread
+		if (chiamate != 10 || somma != 55 || lda.scansioni_perse() != 0)
+			attesaOk = false;
+
+		struct Compito {
+			struct promise_type {
+				Compito get_return_object() { return {}; }
+				suspend_never initial_suspend() noexcept { return {}; }
+				suspend_never final_suspend() noexcept { return {}; }
+				void return_void() {}
+				void unhandled_exception() { terminate(); }
+			};
+		};
+		auto lettore = [](LidarDriverConcorrente &ld, int &lette, int &gruppi) -> Compito {
+			vector<double> v;
+			for (int g = 0; g < 2; g++) {
+				co_await ld.async_wait_scans(3);
+				gruppi++;
+				while (ld.try_get_scan(v))
+					lette++;
+			}
+		};
+		int lette = 0, gruppi = 0;
+		lettore(lda, lette, gruppi);	// il buffer è vuoto: la coroutine si sospende subito
+		lda.new_scan(vector<double>(181, 1));
+		lda.new_scan(vector<double>(181, 2));
+		if (gruppi != 0)
+			attesaOk = false;
+		lda.new_scan(vector<double>(181, 3));	// questa riprende la coroutine, dentro new_scan
+		if (gruppi != 1 || lette != 3)
+			attesaOk = false;
+		for (int k = 4; k <= 6; k++)
+			lda.new_scan(vector<double>(181, k));
+		if (gruppi != 2 || lette != 6 || lda.size() != 0)
+			attesaOk = false;
+	}
+	if (attesaOk)
+		cout << "attesa delle scansioni (wait_scan, subscribe, coroutine) -> corretta" << endl;
+	else
+		cout << "attesa delle scansioni -> sbagliata" << endl;
+
+	// ora verifico i lettori indipendenti (broadcast): prima in un solo thread, con un lettore
+	// lento che perde le scansioni sovrascritte, poi con tre lettori in tre thread che leggono
+	// mentre il produttore inserisce
+	bool lettoriOk = true;
+	{
+		LidarDriverConcorrente ldb(1);
+		ldb.new_scan(vector<double>(181, 0));	// prima dei lettori: la vede solo il consumatore
+		LidarDriverConcorrente::Lettore veloce(ldb), lento(ldb);
+		vector<double> letta;
+		for (int k = 1; k <= 15; k++) {
+			ldb.new_scan(vector<double>(181, k));
+			if (!veloce.try_get_scan(letta) || letta[0] != k)
+				lettoriOk = false;
+		}
+		if (veloce.ritardo() != 0 || veloce.scansioni_perse() != 0 || veloce.try_get_scan(letta))
+			lettoriOk = false;
+		if (lento.ritardo() != 15 || lento.size() != 10)
+			lettoriOk = false;
+		for (int k = 6; k <= 15; k++)	// le prime 5 sono state sovrascritte
+			if (!lento.try_get_scan(letta) || letta[0] != k)
+				lettoriOk = false;
+		if (lento.scansioni_perse() != 5 || lento.ritardo() != 0 || lento.try_get_scan(letta))
+			lettoriOk = false;
+		// i lettori non tolgono niente al consumatore
+		if (ldb.size() != 10 || !ldb.try_get_scan(letta) || letta[0] != 6 || ldb.scansioni_perse() != 6)
+			lettoriOk = false;
+	}
+	{
+		LidarDriverConcorrente ldb(0.5);
+		const int M = 20000;
+		atomic<int> pronti{0};
+		vector<long long> lette(3, 0), perse(3, 0);
+		vector<char> ordinate(3, 1);	// ogni thread scrive solo il suo elemento
+		vector<thread> lettori;
+		for (int t = 0; t < 3; t++)
+			lettori.emplace_back([&, t]() {
+				LidarDriverConcorrente::Lettore io(ldb);
+				pronti++;
+				vector<double> s;
+				double ultima = 0;
+				while (ultima < M) {
+					if (!io.try_get_scan(s)) {
+						this_thread::yield();
+						continue;
+					}
+					for (double d : s)
+						if (d != s[0])
+							ordinate[t] = 0;
+					if (s[0] <= ultima)
+						ordinate[t] = 0;
+					ultima = s[0];
+					lette[t]++;
+				}
+				perse[t] = io.scansioni_perse();
+			});
+		while (pronti < 3)
+			this_thread::yield();
+		vector<double> s(361);
+		for (int k = 1; k <= M; k++) {
+			for (double &d : s)
+				d = k;
+			ldb.new_scan(s);
+		}
+		for (thread &t : lettori)
+			t.join();
+		for (int t = 0; t < 3; t++)
+			if (!ordinate[t] || lette[t] + perse[t] != M)
+				lettoriOk = false;
+	}
+	if (lettoriOk)
+		cout << "lettori indipendenti (broadcast, 3 lettori concorrenti) -> corretti" << endl;
+	else
+		cout << "lettori indipendenti -> sbagliati" << endl;
+
+	// ora stresso il LidarDriverConcorrente con un thread produttore e uno consumatore
+	// il produttore inserisce N scansioni, la k-esima ha tutti i valori uguali a k
+	// il consumatore verifica che ogni scansione letta non sia "mescolata" (tutti i valori uguali)
+	// e che arrivino in ordine; alla fine lette + perse deve fare N
+	LidarDriverConcorrente ldc(0.1);
+	const int N = 200000;
+	atomic<bool> finito{false};
+	thread produttore([&]() {
+		vector<double> s(1801);
+		for (int k = 1; k <= N; k++) {
+			for (double &d : s)
+				d = k;
+			ldc.new_scan(s);
+		}
+		finito = true;
+	});
+
+	long long lette = 0;
+	double ultima = 0;
+	bool ok = true;
+	while (true) {
+		bool eraFinito = finito;
+		try {
+			vector<double> s = ldc.get_scan();
+			for (double d : s)
+				if (d != s[0])
+					ok = false;
+			if (s[0] <= ultima)
+				ok = false;
+			ultima = s[0];
+			lette++;
+		} catch (LidarDriverConcorrente::NoGheSonVettoriError) {
+			if (eraFinito)
+				break;
+		}
+	}
+	produttore.join();
+
+	if (ok && lette + ldc.scansioni_perse() == N)
+		cout << "stress test produttore/consumatore -> corretto (" << lette << " lette, " << ldc.scansioni_perse() << " perse)" << endl;
+	else
+		cout << "stress test produttore/consumatore -> sbagliato" << endl;
+
 	return 0;
 }
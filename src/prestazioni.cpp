@@ -0,0 +1,514 @@
+/*
+	FILE PRESTAZIONI.CPP
+
+	Suite di prestazioni delle funzioni principali di LidarDriver, sullo stile di Google Benchmark:
+	ogni prova viene ripetuta con un numero di iterazioni calibrato in automatico finché non dura
+	almeno il tempo minimo, per tutte le risoluzioni da 0.1° a 1°.
+	Si compila con "make prestazioni" (con le ottimizzazioni attive) e si esegue con ./build/prestazioni
+
+	Per ogni prova e risoluzione viene riportato:
+	 - il tempo medio per operazione in nanosecondi
+	 - i byte allocati (e il numero di allocazioni) per operazione, contati sostituendo operator new
+	 - le scansioni al secondo, per le prove che leggono o scrivono scansioni intere
+
+	Opzioni:
+	 - --formato=testo|csv|json -> tabella leggibile (default) o formato per i programmi
+	 - --filtro=testo           -> esegue solo le prove il cui nome contiene il testo
+	 - --tempo_min=secondi      -> durata minima di ogni prova (default 0.2)
+	 - --confronta=file.csv     -> confronta il tempo per operazione con un'esecuzione precedente salvata
+	                               con --formato=csv e termina con codice 1 se qualche prova è più lenta
+	                               della soglia
+	 - --soglia=percentuale     -> rallentamento tollerato da --confronta (default 10)
+
+	Esempio, per controllare le regressioni tra una versione e l'altra:
+		./build/prestazioni --formato=csv > prima.csv
+		(modifiche, make prestazioni)
+		./build/prestazioni --confronta=prima.csv
+
+	Note sulle prove:
+	 - new_scan/rvalue passa un vector temporaneo: il driver copia comunque le misure nel suo slot, per
+	   cui la differenza con new_scan/lvalue è il costo della creazione del temporaneo (vedi byte/op)
+	 - new_scan/corta e new_scan/lunga passano metà misure in più o in meno del necessario (completate
+	   con zeri o troncate)
+	 - get_scan riempie il buffer da 10 a cronometro fermo e poi lo svuota
+	 - move è un'andata e ritorno (due costruzioni di move), per lasciare il driver come prima
+	 - copia e move contano 10 scansioni per operazione (il buffer pieno)
+	 - new_scan/metriche e get_distance/metriche hanno le metriche collegate: costano di più solo se la
+	   suite è compilata con le metriche attive ("make prestazioni OPZIONI=-DLIDAR_METRICHE")
+	 - concorrente/new_scan è la new_scan del LidarDriverConcorrente senza nessuno che aspetta: misura
+	   che l'attesa delle scansioni non costi niente al produttore quando non viene usata
+	 - concorrente/3_lettori inserisce ogni scansione e la fa leggere a tre Lettore (broadcast) nello
+	   stesso thread: niente code separate, ogni lettore copia la scansione direttamente dallo slot
+	 - get_distance/vuoto e get_scan/vuoto leggono da un buffer vuoto e catturano l'eccezione, le
+	   versioni try_ ricevono l'errore nell'esito: la differenza è il costo di lancio e cattura
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <new>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "../include/LidarDriver.h"
+#include "../include/LidarDriverConcorrente.h"
+#include "../include/MetricheLidar.h"
+using namespace std;
+using namespace lidar_driver;
+
+// contatori delle allocazioni, aggiornati da operator new solo mentre una prova è in corso
+static atomic<bool> contaAllocazioni{false};
+static atomic<size_t> byteAllocati{0};
+static atomic<size_t> numeroAllocazioni{0};
+
+static void *alloca_contando(size_t n, size_t allineamento) {
+	if (contaAllocazioni.load(memory_order_relaxed)) {
+		byteAllocati.fetch_add(n, memory_order_relaxed);
+		numeroAllocazioni.fetch_add(1, memory_order_relaxed);
+	}
+	if (n == 0)
+		n = 1;
+	void *p = (allineamento <= alignof(max_align_t)) ? malloc(n)
+	                                                 : aligned_alloc(allineamento, (n + allineamento - 1) / allineamento * allineamento);
+	if (!p)
+		throw bad_alloc();
+	return p;
+}
+
+// sostituzione degli operatori globali (le versioni [] e nothrow usano queste)
+void *operator new(size_t n) { return alloca_contando(n, alignof(max_align_t)); }
+void *operator new(size_t n, align_val_t a) { return alloca_contando(n, static_cast<size_t>(a)); }
+void operator delete(void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
+void operator delete(void *p, align_val_t) noexcept { free(p); }
+void operator delete(void *p, size_t, align_val_t) noexcept { free(p); }
+
+// impedisce al compilatore di eliminare i calcoli il cui risultato non viene usato
+volatile double pozzo;
+
+/* Classe Stato:
+	- passata a ogni prova, contiene il numero di iterazioni da eseguire e il cronometro, che la
+	  prova può fermare (ferma/riparti) mentre prepara i dati che non vanno misurati; anche le
+	  allocazioni vengono contate solo a cronometro acceso
+*/
+class Stato {
+	public:
+		explicit Stato(long long iterazioni) : iterazioni{iterazioni} {}
+		long long iterazioni;
+
+		void riparti() {
+			contaAllocazioni.store(true, memory_order_relaxed);
+			inizio = chrono::steady_clock::now();
+		}
+		void ferma() {
+			trascorso += chrono::steady_clock::now() - inizio;
+			contaAllocazioni.store(false, memory_order_relaxed);
+		}
+		double secondi() const { return chrono::duration<double>(trascorso).count(); }
+
+	private:
+		chrono::steady_clock::time_point inizio;
+		chrono::steady_clock::duration trascorso{0};
+};
+
+// una prova: nome, scansioni lette o scritte per operazione (0 = non ha senso) e corpo
+struct Prova {
+	string nome;
+	int scansioniPerOp;
+	function<void(double, Stato &)> corpo;	// riceve la risoluzione
+};
+
+// risultato di una prova con una risoluzione
+struct Risultato {
+	string nome;
+	double risoluzione;
+	long long iterazioni;
+	double nsOp;
+	double byteOp;
+	double allocazioniOp;
+	double scansioniS;	// 0 se la prova non legge o scrive scansioni intere
+};
+
+/* Funzione esegui:
+	- esegue la prova con 1, 10, 100, ... iterazioni (come Google Benchmark, stimando quante ne servono
+	  dal tempo dell'ultima esecuzione) finché non dura almeno tempoMin secondi
+	- il risultato è quello dell'ultima esecuzione, divisa per il numero di iterazioni
+*/
+Risultato esegui(const Prova &p, double risoluzione, double tempoMin) {
+	long long n = 1;
+	while (true) {
+		Stato s(n);
+		byteAllocati = 0;
+		numeroAllocazioni = 0;
+		s.riparti();
+		p.corpo(risoluzione, s);
+		s.ferma();
+
+		double t = s.secondi();
+		if (t >= tempoMin || n >= 1000000000LL) {
+			double nsOp = t * 1e9 / n;
+			return {p.nome, risoluzione, n, nsOp, static_cast<double>(byteAllocati) / n,
+			        static_cast<double>(numeroAllocazioni) / n, p.scansioniPerOp * 1e9 / nsOp};
+		}
+		double stima = (t > 0) ? tempoMin * 1.4 / t : 100;
+		n = static_cast<long long>(n * clamp(stima, 2.0, 100.0));
+	}
+}
+
+/* Funzione prove:
+	- restituisce tutte le prove della suite; ognuna crea i suoi driver (a cronometro fermo) con la
+	  risoluzione ricevuta e dimensione del buffer di default (10 scansioni)
+*/
+vector<Prova> prove() {
+	// scansione con le misure giuste per la risoluzione (metri, tutte valide)
+	auto misure = [](double risoluzione, double fattore = 1) {
+		int n = static_cast<int>((180 / risoluzione + 1) * fattore);
+		vector<double> v(n);
+		for (int i = 0; i < n; i++)
+			v[i] = 0.5 + (i % 1000) * 0.01;
+		return v;
+	};
+	auto pieno = [=](double risoluzione) {
+		LidarDriver ld(risoluzione);
+		vector<double> v = misure(risoluzione);
+		for (int k = 0; k < 10; k++)
+			ld.new_scan(v);
+		return ld;
+	};
+
+	return {
+		{"new_scan/lvalue", 1, [=](double r, Stato &s) {
+			s.ferma();
+			LidarDriver ld(r);
+			vector<double> v = misure(r);
+			s.riparti();
+			for (long long i = 0; i < s.iterazioni; i++)
+				ld.new_scan(v);
+		}},
+		{"new_scan/metriche", 1, [=](double r, Stato &s) {
+			s.ferma();
+			MetricheLidar metriche;
+			LidarDriver ld(r);
+			ld.set_metriche(&metriche);
+			vector<double> v = misure(r);
+			s.riparti();
+			for (long long i = 0; i < s.iterazioni; i++)
+				ld.new_scan(v);
+		}},
+		{"new_scan/rvalue", 1, [=](double r, Stato &s) {
+			s.ferma();
+			LidarDriver ld(r);
+			vector<double> v = misure(r);
+			s.riparti();
+			for (long long i = 0; i < s.iterazioni; i++)
+				ld.new_scan(vector<double>(v));
+		}},
+		{"new_scan/corta", 1, [=](double r, Stato &s) {
+			s.ferma();
+			LidarDriver ld(r);
+			vector<double> v = misure(r, 0.5);
+			s.riparti();
+			for (long long i = 0; i < s.iterazioni; i++)
+				ld.new_scan(v);
+		}},
+		{"new_scan/lunga", 1, [=](double r, Stato &s) {
+			s.ferma();
+			LidarDriver ld(r);
+			vector<double> v = misure(r, 1.5);
+			s.riparti();
+			for (long long i = 0; i < s.iterazioni; i++)
+				ld.new_scan(v);
+		}},
+		{"get_scan", 1, [=](double r, Stato &s) {
+			s.ferma();
+			LidarDriver ld(r);
+			vector<double> v = misure(r);
+			for (long long i = 0; i < s.iterazioni; i += 10) {
+				long long lotto = min(10LL, s.iterazioni - i);
+				for (long long k = 0; k < lotto; k++)
+					ld.new_scan(v);
+				s.riparti();
+				for (long long k = 0; k < lotto; k++)
+					pozzo = ld.get_scan()[0];
+				s.ferma();
+			}
+			s.riparti();
+		}},
+		{"get_scan/vector_riusato", 1, [=](double r, Stato &s) {
+			s.ferma();
+			LidarDriver ld(r);
+			vector<double> v = misure(r), letta(v.size());
+			for (long long i = 0; i < s.iterazioni; i += 10) {
+				long long lotto = min(10LL, s.iterazioni - i);
+				for (long long k = 0; k < lotto; k++)
+					ld.new_scan(v);
+				s.riparti();
+				for (long long k = 0; k < lotto; k++) {
+					ld.get_scan(letta);
+					pozzo = letta[0];
+				}
+				s.ferma();
+			}
+			s.riparti();
+		}},
+		{"get_last", 1, [=](double r, Stato &s) {
+			s.ferma();
+			LidarDriver ld = pieno(r);
+			s.riparti();
+			for (long long i = 0; i < s.iterazioni; i++)
+				pozzo = ld.get_last()[0];
+		}},
+		{"get_distance", 0, [=](double r, Stato &s) {
+			s.ferma();
+			LidarDriver ld = pieno(r);
+			vector<double> angoli(256);
+			for (int i = 0; i < 256; i++)
+				angoli[i] = i * 0.7;
+			s.riparti();
+			for (long long i = 0; i < s.iterazioni; i++)
+				pozzo = ld.get_distance(angoli[i & 255]);
+		}},
+		{"get_distance/metriche", 0, [=](double r, Stato &s) {
+			s.ferma();
+			MetricheLidar metriche;
+			LidarDriver ld = pieno(r);
+			ld.set_metriche(&metriche);
+			vector<double> angoli(256);
+			for (int i = 0; i < 256; i++)
+				angoli[i] = i * 0.7;
+			s.riparti();
+			for (long long i = 0; i < s.iterazioni; i++)
+				pozzo = ld.get_distance(angoli[i & 255]);
+		}},
+		{"try_get_distance", 0, [=](double r, Stato &s) {
+			s.ferma();
+			LidarDriver ld = pieno(r);
+			vector<double> angoli(256);
+			for (int i = 0; i < 256; i++)
+				angoli[i] = i * 0.7;
+			s.riparti();
+			for (long long i = 0; i < s.iterazioni; i++)
+				pozzo = ld.try_get_distance(angoli[i & 255]).value_or(0);
+		}},
+		{"get_distance/vuoto", 0, [=](double r, Stato &s) {
+			s.ferma();
+			LidarDriver ld(r);
+			s.riparti();
+			for (long long i = 0; i < s.iterazioni; i++) {
+				try {
+					pozzo = ld.get_distance(90);
+				} catch (LidarDriver::NoGheSonVettoriError) {
+					pozzo = -1;
+				}
+			}
+		}},
+		{"try_get_distance/vuoto", 0, [=](double r, Stato &s) {
+			s.ferma();
+			LidarDriver ld(r);
+			s.riparti();
+			for (long long i = 0; i < s.iterazioni; i++)
+				pozzo = ld.try_get_distance(90).value_or(-1);
+		}},
+		{"get_scan/vuoto", 0, [=](double r, Stato &s) {
+			s.ferma();
+			LidarDriver ld(r);
+			vector<double> letta;
+			s.riparti();
+			for (long long i = 0; i < s.iterazioni; i++) {
+				try {
+					ld.get_scan(letta);
+				} catch (LidarDriver::NoGheSonVettoriError) {
+					pozzo = -1;
+				}
+			}
+		}},
+		{"try_get_scan/vuoto", 0, [=](double r, Stato &s) {
+			s.ferma();
+			LidarDriver ld(r);
+			vector<double> letta;
+			s.riparti();
+			for (long long i = 0; i < s.iterazioni; i++)
+				pozzo = ld.try_get_scan(letta) ? letta[0] : -1;
+		}},
+		{"concorrente/new_scan", 1, [=](double r, Stato &s) {
+			s.ferma();
+			LidarDriverConcorrente ld(r);
+			vector<double> v = misure(r);
+			s.riparti();
+			for (long long i = 0; i < s.iterazioni; i++)
+				ld.new_scan(v);
+		}},
+		{"concorrente/3_lettori", 1, [=](double r, Stato &s) {
+			s.ferma();
+			LidarDriverConcorrente ld(r);
+			LidarDriverConcorrente::Lettore registratore(ld), mappa(ld), sicurezza(ld);
+			vector<double> v = misure(r), letta(v.size());
+			s.riparti();
+			for (long long i = 0; i < s.iterazioni; i++) {
+				ld.new_scan(v);
+				registratore.try_get_scan(letta);
+				mappa.try_get_scan(letta);
+				sicurezza.try_get_scan(letta);
+			}
+			pozzo = letta[0];
+		}},
+		{"clear_buffer", 0, [=](double r, Stato &s) {
+			s.ferma();
+			LidarDriver ld = pieno(r);
+			s.riparti();
+			for (long long i = 0; i < s.iterazioni; i++)
+				ld.clear_buffer();
+		}},
+		{"copia", 10, [=](double r, Stato &s) {
+			s.ferma();
+			LidarDriver ld = pieno(r);
+			s.riparti();
+			for (long long i = 0; i < s.iterazioni; i++) {
+				LidarDriver copia(ld);
+				pozzo = copia.size();
+			}
+		}},
+		{"move", 10, [=](double r, Stato &s) {
+			s.ferma();
+			LidarDriver ld = pieno(r);
+			s.riparti();
+			for (long long i = 0; i < s.iterazioni; i++) {
+				LidarDriver spostato(std::move(ld));
+				ld = std::move(spostato);
+			}
+			pozzo = ld.size();
+		}},
+		{"operator<<", 1, [=](double r, Stato &s) {
+			s.ferma();
+			LidarDriver ld = pieno(r);
+			ostringstream os;
+			os << ld;	// prima stampa: il formattatore alloca la sua stringa
+			s.riparti();
+			for (long long i = 0; i < s.iterazioni; i++) {
+				os.seekp(0);
+				os << ld;
+			}
+			pozzo = os.tellp();
+		}},
+	};
+}
+
+/* Funzione leggi_csv:
+	- legge i risultati salvati con --formato=csv e restituisce il tempo per operazione di ogni
+	  prova, indicizzato per nome e risoluzione
+*/
+map<pair<string, double>, double> leggi_csv(const string &percorso) {
+	map<pair<string, double>, double> tempi;
+	ifstream f(percorso);
+	if (!f) {
+		cerr << "impossibile aprire " << percorso << endl;
+		exit(2);
+	}
+	string riga;
+	getline(f, riga);	// intestazione
+	while (getline(f, riga)) {
+		stringstream ss(riga);
+		string nome, risoluzione, iterazioni, nsOp;
+		if (getline(ss, nome, ',') && getline(ss, risoluzione, ',') && getline(ss, iterazioni, ',') && getline(ss, nsOp, ','))
+			tempi[{nome, stod(risoluzione)}] = stod(nsOp);
+	}
+	return tempi;
+}
+
+int main(int argc, char **argv) {
+	string formato = "testo", filtro, confronta;
+	double tempoMin = 0.2, soglia = 10;
+	for (int i = 1; i < argc; i++) {
+		string a = argv[i];
+		auto valore = [&](const string &opzione) { return a.rfind(opzione, 0) == 0 ? a.substr(opzione.size()) : string(); };
+		if (!valore("--formato=").empty())
+			formato = valore("--formato=");
+		else if (!valore("--filtro=").empty())
+			filtro = valore("--filtro=");
+		else if (!valore("--tempo_min=").empty())
+			tempoMin = stod(valore("--tempo_min="));
+		else if (!valore("--confronta=").empty())
+			confronta = valore("--confronta=");
+		else if (!valore("--soglia=").empty())
+			soglia = stod(valore("--soglia="));
+		else {
+			cerr << "uso: " << argv[0] << " [--formato=testo|csv|json] [--filtro=testo] [--tempo_min=secondi]"
+			     << " [--confronta=file.csv] [--soglia=percentuale]" << endl;
+			return 2;
+		}
+	}
+	if (formato != "testo" && formato != "csv" && formato != "json") {
+		cerr << "formato sconosciuto: " << formato << endl;
+		return 2;
+	}
+
+	// esecuzione di tutte le prove (quelle che passano il filtro) con tutte le risoluzioni
+	const double risoluzioni[] = {0.1, 0.25, 0.5, 1};
+	vector<Risultato> risultati;
+	if (formato == "testo")
+		printf("%-26s %5s %12s %12s %10s %9s %12s\n", "prova", "ris.", "iterazioni", "ns/op", "byte/op", "alloc/op", "scansioni/s");
+	for (const Prova &p : prove()) {
+		if (p.nome.find(filtro) == string::npos)
+			continue;
+		for (double r : risoluzioni) {
+			Risultato ris = esegui(p, r, tempoMin);
+			risultati.push_back(ris);
+			if (formato == "testo") {
+				printf("%-26s %5.2f %12lld %12.1f %10.1f %9.2f ", ris.nome.c_str(), ris.risoluzione, ris.iterazioni, ris.nsOp, ris.byteOp, ris.allocazioniOp);
+				if (ris.scansioniS > 0)
+					printf("%12.0f\n", ris.scansioniS);
+				else
+					printf("%12s\n", "-");
+				fflush(stdout);
+			}
+		}
+	}
+
+	// formati per i programmi: CSV con intestazione, o JSON con il contesto dell'esecuzione
+	if (formato == "csv") {
+		printf("nome,risoluzione,iterazioni,ns_op,byte_op,allocazioni_op,scansioni_s\n");
+		for (const Risultato &r : risultati)
+			printf("%s,%g,%lld,%.3f,%.3f,%.4f,%.1f\n", r.nome.c_str(), r.risoluzione, r.iterazioni, r.nsOp, r.byteOp, r.allocazioniOp, r.scansioniS);
+	} else if (formato == "json") {
+		printf("{\n  \"contesto\": {\"core\": %u, \"compilatore\": \"%s\", \"tempo_min\": %g},\n  \"risultati\": [\n",
+		       thread::hardware_concurrency(), __VERSION__, tempoMin);
+		for (size_t i = 0; i < risultati.size(); i++) {
+			const Risultato &r = risultati[i];
+			printf("    {\"nome\": \"%s\", \"risoluzione\": %g, \"iterazioni\": %lld, \"ns_op\": %.3f, \"byte_op\": %.3f, "
+			       "\"allocazioni_op\": %.4f, \"scansioni_s\": %.1f}%s\n",
+			       r.nome.c_str(), r.risoluzione, r.iterazioni, r.nsOp, r.byteOp, r.allocazioniOp, r.scansioniS,
+			       i + 1 < risultati.size() ? "," : "");
+		}
+		printf("  ]\n}\n");
+	}
+
+	// confronto con un'esecuzione precedente: variazione del tempo per operazione di ogni prova
+	if (!confronta.empty()) {
+		map<pair<string, double>, double> prima = leggi_csv(confronta);
+		bool regressione = false;
+		FILE *out = (formato == "testo") ? stdout : stderr;
+		fprintf(out, "\nconfronto con %s (soglia %g%%)\n", confronta.c_str(), soglia);
+		for (const Risultato &r : risultati) {
+			auto it = prima.find({r.nome, r.risoluzione});
+			if (it == prima.end())
+				continue;
+			double variazione = (r.nsOp / it->second - 1) * 100;
+			bool lenta = variazione > soglia;
+			regressione = regressione || lenta;
+			fprintf(out, "%-26s %5.2f %12.1f -> %12.1f ns/op %+7.1f%%%s\n", r.nome.c_str(), r.risoluzione, it->second, r.nsOp,
+			        variazione, lenta ? "  <- PIU' LENTA" : "");
+		}
+		if (regressione)
+			return 1;
+	}
+
+	return 0;
+}